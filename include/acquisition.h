@@ -0,0 +1,40 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "reading.h"
+
+/** Initialise les capteurs (DHT11, backend ADC). */
+void acquisitionBegin();
+
+/**
+ * Lit tous les capteurs de facon synchrone et remplit `r`
+ * (sequence, horodatage, valeurs et masque de validite).
+ */
+void acquireReading(Reading& r);
+
+/**
+ * Publication par exception (REPORT_BY_EXCEPTION) : renseigne les canaux
+ * inchanges de `r` et retourne false si le releve n'est pas a publier.
+ * Toujours true si le mode est desactive. Etat conserve en memoire RTC.
+ */
+bool acquisitionReport(Reading& r);
+
+/**
+ * Initialise les capteurs et demarre la tache d'acquisition sur le coeur APP.
+ * Chaque releve est pousse dans `queue` ; si la file est pleine, le plus
+ * ancien releve est ecarte pour garder les plus recents.
+ */
+void startAcquisition(QueueHandle_t queue);
+
+/**
+ * Intervalle (ms) jusqu'au prochain releve : READ_INTERVAL (DEEP_SLEEP_INTERVAL
+ * en deep sleep), ou cadence courante avec ADAPTIVE_INTERVAL.
+ */
+uint32_t acquisitionInterval();
+
+/** Nombre de releves ecartes faute de place dans la file. */
+uint32_t acquisitionDropped();
+
+#endif
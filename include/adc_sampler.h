@@ -0,0 +1,27 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * Valeur filtree des deux voies analogiques, en code ADC lineaire (0-4095,
+ * fractionnaire) apres correction de calibration.
+ */
+struct AdcSample {
+  float ntcRaw;     // GPIO 34 (module NTC)
+  float ldrRaw;     // GPIO 35 (module LDR)
+  uint16_t count;   // Echantillons filtres par canal (le plus petit des deux)
+};
+
+/**
+ * Initialise le backend choisi par ADC_BACKEND (voir config.h).
+ */
+void adcSamplerBegin();
+
+/**
+ * Effectue une salve d'acquisition sur les deux canaux et retourne la valeur filtree.
+ * Retourne false si aucun echantillon n'a pu etre lu.
+ */
+bool adcSamplerRead(AdcSample& out);
+
+#endif
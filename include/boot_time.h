@@ -0,0 +1,31 @@
+#ifndef BOOT_TIME_H
+#define BOOT_TIME_H
+
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Horloge des releves de la station (voir lib/MeteoCore/src/timebase.h).
+ *
+ * Le temps monotone est celui d'esp_timer, prolonge en deep sleep par les
+ * durees de sommeil cumulees en memoire RTC : les releves accumules sur
+ * plusieurs reveils avant la premiere synchronisation restent ordonnes et
+ * sont completes ensemble.
+ */
+
+/** Temps monotone (us) depuis la mise sous tension, deep sleeps compris. */
+uint64_t monotonicUs();
+
+/** Horodatage d'un releve pris maintenant : heure UNIX, ou relatif si inconnue. */
+uint32_t stampNow();
+
+/**
+ * Convertit les horodatages relatifs de `batch` en heure UNIX si l'heure
+ * est connue. Retourne false s'il en reste. A appeler depuis une seule tache.
+ */
+bool backfillEpochs(PackedReading* batch, uint16_t n);
+
+/** Deep sleep : ajoute le sommeil a venir au temps monotone du prochain reveil. */
+void bootTimeSleep(uint64_t sleepUs);
+
+#endif
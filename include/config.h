@@ -0,0 +1,568 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/**
+ * Parametres de la MeteoStation partages par tous les modules.
+ * Chaque valeur peut etre surchargee via build_flags (-DNOM=valeur)
+ * dans platformio.ini.
+ */
+
+#ifdef UNIT_TEST
+#include "credentials.h.example"  // Identifiants fictifs des tests natifs
+#else
+#include "credentials.h"
+#endif
+
+// --- Configuration des pins ---
+#define DHT_PIN     27    // Data DHT11
+#define TEMP_AO_PIN 34    // Sortie analogique du module NTC
+#define LDR_PIN     35    // Signal du module LDR
+
+// --- Parametres DHT11 ---
+#define DHT_TYPE DHT11
+// DHT_BACKEND_LIB : bibliotheque Adafruit (bit-bang, interruptions masquees ~5 ms,
+//                   jusqu'a ~250 ms bloquants sur un echec)
+// DHT_BACKEND_RMT : trame capturee par le peripherique RMT, tache en attente passive
+#define DHT_BACKEND_LIB 0
+#define DHT_BACKEND_RMT 1
+#ifndef DHT_BACKEND
+#define DHT_BACKEND DHT_BACKEND_RMT
+#endif
+#define DHT_RMT_CHANNEL   0       // Canal RMT en reception
+#define DHT_FRAME_TIMEOUT 40      // Attente max de la trame apres le signal de depart (ms)
+#ifndef DHT_STALE_MAX
+#define DHT_STALE_MAX     30000   // Derniere valeur valide reutilisee apres un echec (ms)
+#endif
+
+// --- Parametres de lecture ---
+#ifndef READ_INTERVAL
+#define READ_INTERVAL 10000  // Intervalle entre chaque releve (ms)
+#endif
+#ifndef NB_SAMPLES
+#define NB_SAMPLES 20        // Nombre d'echantillons pour le moyennage ADC
+#endif
+
+// --- Agregation par fenetre ---
+// AGGREGATE_WINDOW > 0 : READ_INTERVAL devient la periode d'echantillonnage et un
+// seul releve resume (moyenne, min, max, ecart-type par canal) est publie par fenetre
+#ifndef AGGREGATE_WINDOW
+#define AGGREGATE_WINDOW 0   // Duree d'une fenetre (ms), ex: 60000 avec READ_INTERVAL 1000
+#endif
+#define AGGREGATE_SAMPLES (AGGREGATE_WINDOW / READ_INTERVAL)
+
+// --- Cadence adaptative (lib/MeteoCore/src/adaptive_rate.h) ---
+// ADAPTIVE_INTERVAL = 1 : l'intervalle entre releves (periode de reveil en deep sleep)
+// varie entre READ_INTERVAL_MIN et READ_INTERVAL_MAX selon la variation des canaux
+#ifndef ADAPTIVE_INTERVAL
+#define ADAPTIVE_INTERVAL     0
+#endif
+#ifndef READ_INTERVAL_MIN
+#define READ_INTERVAL_MIN     2000   // Intervalle quand le signal bouge (ms, >= 1000)
+#endif
+#ifndef READ_INTERVAL_MAX
+#define READ_INTERVAL_MAX     60000  // Intervalle quand le signal est stable (ms)
+#endif
+#define ADAPT_STEP_DHT_TEMP   20     // Variation visee entre deux releves (centiemes de C)
+#define ADAPT_STEP_DHT_HUM    100    // Centiemes de %
+#define ADAPT_STEP_NTC_TEMP   10     // Centiemes de C
+#define ADAPT_STEP_LUMINOSITY 200    // Centiemes de %
+#define ADAPT_QUIET_SAMPLES   3      // Releves calmes avant d'allonger l'intervalle de moitie
+#if ADAPTIVE_INTERVAL && AGGREGATE_WINDOW > 0
+#error "ADAPTIVE_INTERVAL et AGGREGATE_WINDOW sont incompatibles (fenetre a nombre d'echantillons fixe)"
+#endif
+#if ADAPTIVE_INTERVAL && (READ_INTERVAL_MIN < 1000 || READ_INTERVAL_MIN > READ_INTERVAL_MAX)
+#error "Il faut 1000 <= READ_INTERVAL_MIN <= READ_INTERVAL_MAX"
+#endif
+
+// --- Backend d'acquisition ADC ---
+// ADC_BACKEND_ONESHOT : analogRead() successifs (NB_SAMPLES par canal, 5 ms d'ecart)
+// ADC_BACKEND_DMA     : mode continu (DMA) qui scanne les deux canaux en materiel
+#define ADC_BACKEND_ONESHOT 0
+#define ADC_BACKEND_DMA     1
+#ifndef ADC_BACKEND
+#define ADC_BACKEND ADC_BACKEND_ONESHOT
+#endif
+#ifndef ADC_DMA_SAMPLE_FREQ
+#define ADC_DMA_SAMPLE_FREQ 20000  // Frequence de conversion totale (Hz, 20 kHz min sur ESP32)
+#endif
+#ifndef ADC_DMA_OVERSAMPLE
+#define ADC_DMA_OVERSAMPLE  256    // Echantillons moyennes par canal et par releve
+#endif
+#define ADC_DMA_FRAME_BYTES 256    // Taille d'une trame DMA lue en une fois (octets)
+#if ADC_DMA_OVERSAMPLE > 65535
+#error "ADC_DMA_OVERSAMPLE limite a 65535 (moyenne exacte sur 32 bits, AdcSample::count)"
+#endif
+// Duree nominale d'une salve sur les deux canaux (ms)
+#if ADC_BACKEND == ADC_BACKEND_DMA
+#define ADC_BURST_MS        (2UL * ADC_DMA_OVERSAMPLE * 1000UL / ADC_DMA_SAMPLE_FREQ)
+#else
+#define ADC_BURST_MS        (2UL * NB_SAMPLES * 5)
+#endif
+#define ADC_DMA_TIMEOUT_MS  (2 * ADC_BURST_MS + 20)  // Salve doublee, plus une marge fixe
+
+// --- Calibration de l'ADC (lib/MeteoCore/src/adc_cal.h) ---
+#ifndef ADC_CALIBRATION
+#define ADC_CALIBRATION      1     // Table de correction eFuse (8 Ko de RAM), 0 : ADC suppose lineaire
+#endif
+#define ADC_CAL_DEFAULT_VREF 1100  // Vref (mV) si l'eFuse n'est pas programme
+#ifndef ADC_SUPPLY_MV
+#define ADC_SUPPLY_MV        3300  // Alimentation des ponts diviseurs NTC et LDR (mV)
+#endif
+
+// --- Filtrage des voies analogiques (lib/MeteoCore/src/adc_filter.h) ---
+// ADC_FILTER_MEAN (0), ADC_FILTER_MEDIAN (1), ADC_FILTER_TRIMMED (2), ADC_FILTER_IIR (3)
+#ifndef ADC_FILTER_NTC
+#define ADC_FILTER_NTC      2      // Moyenne tronquee
+#endif
+#ifndef ADC_FILTER_LDR
+#define ADC_FILTER_LDR      2
+#endif
+#define ADC_FILTER_WINDOW   32     // Echantillons par bloc trie (mediane, moyenne tronquee)
+#ifndef ADC_FILTER_TRIM_PCT
+#define ADC_FILTER_TRIM_PCT 20     // Pourcentage ecarte de chaque cote d'un bloc
+#endif
+#ifndef ADC_FILTER_IIR_ALPHA
+#define ADC_FILTER_IIR_ALPHA 0.1f  // Coefficient du passe-bas IIR
+#endif
+
+// --- Parametres de l'ordonnanceur ---
+#ifndef PUBLISH_INTERVAL
+#define PUBLISH_INTERVAL  500   // Vidage de la file des releves vers MQTT (ms)
+#endif
+#ifndef CONNECT_INTERVAL
+#define CONNECT_INTERVAL  100   // Pas des machines a etats WiFi/MQTT (ms)
+#endif
+#ifndef IDLE_MAX_DELAY
+#define IDLE_MAX_DELAY    10    // Attente max entre deux appels a mqtt.loop() (ms)
+#endif
+
+// --- Mode d'alimentation ---
+// POWER_ALWAYS_ON  : WiFi et MQTT maintenus en permanence (taches FreeRTOS)
+// POWER_DEEP_SLEEP : deep sleep entre deux releves, publication groupee
+#define POWER_ALWAYS_ON  0
+#define POWER_DEEP_SLEEP 1
+#ifndef POWER_MODE
+#define POWER_MODE POWER_ALWAYS_ON
+#endif
+#ifndef DEEP_SLEEP_INTERVAL
+#define DEEP_SLEEP_INTERVAL  60000  // Periode de reveil pour un releve (ms)
+#endif
+#ifndef DEEP_SLEEP_BATCH
+#define DEEP_SLEEP_BATCH     10     // Releves accumules avant d'allumer la radio
+#endif
+#define DEEP_SLEEP_RTC_LEN   120    // Capacite du tampon RTC (2,4 Ko sur 8 Ko)
+#ifndef DEEP_SLEEP_NTP_EVERY
+#define DEEP_SLEEP_NTP_EVERY 6      // Resynchronisation NTP toutes les N publications
+#endif
+#define NTP_SYNC_TIMEOUT     5000   // Attente max d'une synchronisation NTP (ms)
+#if AGGREGATE_WINDOW > 0 && POWER_MODE == POWER_DEEP_SLEEP
+#error "AGGREGATE_WINDOW suppose un echantillonnage rapide, incompatible avec POWER_DEEP_SLEEP"
+#endif
+#if AGGREGATE_WINDOW > 0 && AGGREGATE_SAMPLES < 2
+#error "AGGREGATE_WINDOW doit couvrir au moins deux READ_INTERVAL"
+#endif
+
+// --- Publication par exception ---
+// Un canal n'est publie que s'il s'ecarte de sa derniere valeur publiee d'au
+// moins sa bande morte (centiemes) ; releve complet force toutes les REPORT_HEARTBEAT ms
+#ifndef REPORT_BY_EXCEPTION
+#define REPORT_BY_EXCEPTION 0
+#endif
+#ifndef DEADBAND_DHT_TEMP
+#define DEADBAND_DHT_TEMP   50      // 0,5 C
+#endif
+#ifndef DEADBAND_DHT_HUM
+#define DEADBAND_DHT_HUM    200     // 2 %
+#endif
+#ifndef DEADBAND_NTC_TEMP
+#define DEADBAND_NTC_TEMP   20      // 0,2 C
+#endif
+#ifndef DEADBAND_LUMINOSITY
+#define DEADBAND_LUMINOSITY 300     // 3 %
+#endif
+#ifndef REPORT_HEARTBEAT
+#define REPORT_HEARTBEAT    300000  // Releve complet au moins toutes les 5 min (ms)
+#endif
+
+// --- Taches FreeRTOS ---
+// L'acquisition tourne sur le coeur APP (1), la pile WiFi et le reseau sur le coeur PRO (0).
+#define ACQ_TASK_CORE     1
+#define ACQ_TASK_STACK    4096
+#define ACQ_TASK_PRIO     3
+#define NET_TASK_CORE     0
+#define NET_TASK_STACK    8192
+#define NET_TASK_PRIO     2
+#ifndef READING_QUEUE_LEN
+#define READING_QUEUE_LEN 16    // Releves en transit entre les deux taches
+#endif
+#define LOG_TASK_CORE     0     // Vidage du journal vers l'UART, priorite minimale
+#define LOG_TASK_STACK    2048
+#define LOG_TASK_PRIO     1
+
+// --- Journal (include/log.h) ---
+// Les messages au-dessus de LOG_LEVEL sont retires a la compilation (formatage compris)
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4       // Detail de chaque releve et de chaque publication
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_BUFFER_SIZE 2048    // Tampon circulaire vide par la tache de journal (octets)
+#define LOG_LINE_MAX    160     // Longueur max d'un message formate
+
+// --- Tampon de coupure (store-and-forward) ---
+// Politique de debordement quand le tampon est plein
+#define OUTAGE_DROP_OLDEST  0   // Ecarte le plus ancien releve
+#define OUTAGE_DROP_NEWEST  1   // Refuse le nouveau releve
+#ifndef OUTAGE_POLICY
+#define OUTAGE_POLICY OUTAGE_DROP_OLDEST
+#endif
+#ifndef OUTAGE_BUFFER_LEN
+#define OUTAGE_BUFFER_LEN   720   // Releves en RAM (720 x 10 s = 2 h, 14 Ko)
+#endif
+#ifndef OUTAGE_SPILL_FS
+#define OUTAGE_SPILL_FS     0     // 1 : deborde sur LittleFS quand la RAM est pleine
+#endif
+#if AGGREGATE_WINDOW > 0
+#define OUTAGE_SPILL_FILE   "/outage_agg.bin"  // Releves resumes, format plus grand
+#define OUTAGE_SPILL_POS    "/outage_agg.pos"
+#else
+#define OUTAGE_SPILL_FILE   "/outage.bin"
+#define OUTAGE_SPILL_POS    "/outage.pos"      // Releves du fichier deja rejoues (uint32)
+#endif
+#define OUTAGE_SPILL_TMP    "/outage.tmp"      // Copie du fichier sans les releves rejoues
+#ifndef OUTAGE_SPILL_MAX
+#define OUTAGE_SPILL_MAX    8640  // Releves max sur flash (24 h, 170 Ko)
+#endif
+#define OUTAGE_SPILL_CHUNK  60    // Releves deplaces vers la flash en une ecriture
+#ifndef REPLAY_BATCH
+#define REPLAY_BATCH        10    // Releves publies au plus par PUBLISH_INTERVAL
+#endif
+
+// --- Payloads groupes ---
+// PAYLOAD_BATCH_SIZE = 1 : un message par releve sur MQTT_TOPIC (format historique)
+// PAYLOAD_BATCH_SIZE > 1 : un message groupe sur MQTT_BATCH_TOPIC des que le lot
+// est plein ou que PAYLOAD_BATCH_MAX_AGE est ecoule depuis le precedent
+#ifndef PAYLOAD_BATCH_SIZE
+#define PAYLOAD_BATCH_SIZE    1
+#endif
+#ifndef PAYLOAD_BATCH_MAX_AGE
+#define PAYLOAD_BATCH_MAX_AGE 60000   // Age max d'un lot incomplet (ms)
+#endif
+#ifndef MQTT_BUFFER_SIZE
+#define MQTT_BUFFER_SIZE      4096    // Tampon PubSubClient (~130 octets par releve groupe)
+#endif
+#define MQTT_HEADER_RESERVE   128     // En-tete MQTT + topic dans le tampon PubSubClient
+
+// --- Compression du rejeu (voir lib/MeteoCore/src/compress.h) ---
+// REPLAY_COMPRESS = 1 : tant qu'au moins REPLAY_COMPRESS_MIN releves attendent
+// (retour d'une longue coupure), ils sont publies par lots de
+// REPLAY_COMPRESS_BATCH, en colonnes delta puis LZSS, sur MQTT_TOPIC/z ;
+// en dessous, l'encodage PAYLOAD_ENCODING reprend
+#ifndef REPLAY_COMPRESS
+#define REPLAY_COMPRESS       0
+#endif
+#ifndef REPLAY_COMPRESS_MIN
+#define REPLAY_COMPRESS_MIN   30
+#endif
+#ifndef REPLAY_COMPRESS_BATCH
+#define REPLAY_COMPRESS_BATCH 120     // 20 minutes a READ_INTERVAL = 10 s
+#endif
+#if REPLAY_COMPRESS && (REPLAY_COMPRESS_BATCH < REPLAY_COMPRESS_MIN || REPLAY_COMPRESS_BATCH > 255)
+#error "REPLAY_COMPRESS_BATCH doit etre compris entre REPLAY_COMPRESS_MIN et 255"
+#endif
+
+#define PUBLISH_BATCH_BASE (PAYLOAD_BATCH_SIZE > REPLAY_BATCH ? PAYLOAD_BATCH_SIZE : REPLAY_BATCH)
+#if REPLAY_COMPRESS && REPLAY_COMPRESS_MIN <= PUBLISH_BATCH_BASE
+#error "REPLAY_COMPRESS_MIN doit depasser PAYLOAD_BATCH_SIZE et REPLAY_BATCH (retransmissions QoS 1)"
+#endif
+#if REPLAY_COMPRESS
+#define PUBLISH_BATCH_MAX \
+  (REPLAY_COMPRESS_BATCH > PUBLISH_BATCH_BASE ? REPLAY_COMPRESS_BATCH : PUBLISH_BATCH_BASE)
+#else
+#define PUBLISH_BATCH_MAX PUBLISH_BATCH_BASE
+#endif
+
+// --- Encodage des payloads ---
+// ENCODING_JSON   : JSON lisible (MQTT_TOPIC ou MQTT_BATCH_TOPIC)
+// ENCODING_CBOR   : CBOR compact sur MQTT_TOPIC/cbor (voir lib/MeteoCore/src/encoder.h)
+// ENCODING_BINARY : enregistrement binaire versionne sur MQTT_TOPIC/bin
+#define ENCODING_JSON   0
+#define ENCODING_CBOR   1
+#define ENCODING_BINARY 2
+#ifndef PAYLOAD_ENCODING
+#define PAYLOAD_ENCODING ENCODING_JSON
+#endif
+
+// --- Qualite de service MQTT ---
+// MQTT_QOS 0 : PUBLISH QoS 0 via PubSubClient, releve retire du tampon des l'envoi
+// MQTT_QOS 1 : PUBLISH QoS 1 (include/mqtt_link.h), releve retire a reception du
+// PUBACK ; jusqu'a MQTT_INFLIGHT_MAX messages en vol sans attendre leur PUBACK
+#ifndef MQTT_QOS
+#define MQTT_QOS            1
+#endif
+#ifndef MQTT_INFLIGHT_MAX
+#define MQTT_INFLIGHT_MAX   8       // Messages QoS 1 en vol (fenetre)
+#endif
+#ifndef MQTT_RETRY_TIMEOUT
+#define MQTT_RETRY_TIMEOUT  5000    // Retransmission (DUP) sans PUBACK (ms)
+#endif
+#define MQTT_ACK_WAIT       10000   // Deep sleep : attente max sans nouveau PUBACK (ms)
+#if MQTT_QOS != 0 && MQTT_QOS != 1
+#error "MQTT_QOS doit valoir 0 ou 1"
+#endif
+#if MQTT_INFLIGHT_MAX < 1 || MQTT_INFLIGHT_MAX > 255
+#error "MQTT_INFLIGHT_MAX doit etre compris entre 1 et 255"
+#endif
+
+// --- Role de la station (ESP-NOW, voir lib/MeteoCore/src/espnow_frame.h) ---
+// ROLE_STANDALONE : WiFi, TLS et MQTT propres
+// ROLE_LEAF       : releves envoyes en ESP-NOW a une passerelle, ni WiFi, ni TLS, ni MQTT
+// ROLE_GATEWAY    : station complete qui publie aussi les releves des feuilles,
+//                   sous sensors/{MQTT_USER}/{nom de la feuille}
+#define ROLE_STANDALONE 0
+#define ROLE_LEAF       1
+#define ROLE_GATEWAY    2
+#ifndef STATION_ROLE
+#define STATION_ROLE    ROLE_STANDALONE
+#endif
+#ifndef ESPNOW_CHANNEL
+#define ESPNOW_CHANNEL  1       // Feuille : canal WiFi du point d'acces de la passerelle
+#endif
+// Feuille : adresse MAC de la passerelle, ou diffusion jusqu'au premier acquittement
+#ifndef ESPNOW_GATEWAY_MAC
+#define ESPNOW_GATEWAY_MAC 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+#endif
+#define ESPNOW_ACK_TIMEOUT  200     // Feuille : attente de l'acquittement d'une trame (ms)
+#define ESPNOW_RETRY_MAX    30000   // Feuille : attente max entre deux essais sans passerelle (ms)
+#ifndef ESPNOW_MAX_LEAVES
+#define ESPNOW_MAX_LEAVES   16      // Passerelle : feuilles suivies
+#endif
+#ifndef ESPNOW_RELAY_LEN
+#define ESPNOW_RELAY_LEN    32      // Passerelle : trames en attente de publication (~8 Ko)
+#endif
+#define ESPNOW_RX_QUEUE_LEN 8       // Passerelle : trames recues non traitees
+#if STATION_ROLE == ROLE_GATEWAY && POWER_MODE == POWER_DEEP_SLEEP
+#error "La passerelle ESP-NOW doit rester a l'ecoute (POWER_ALWAYS_ON)"
+#endif
+
+// --- Gestion de l'energie entre les taches (include/power.h) ---
+// POWER_SAVE_OFF   : CPU a CPU_FREQ_BOOST_MHZ, radio eveillee en permanence
+// POWER_SAVE_MODEM : CPU a CPU_FREQ_IDLE_MHZ entre les taches, modem sleep WiFi
+//                    (reveil a chaque DTIM) ; CPU_FREQ_BOOST_MHZ pendant les
+//                    handshakes TLS et les publications
+// POWER_SAVE_LIGHT : idem, modem sleep long et light sleep automatique (esp_pm,
+//                    tickless idle) ; repli sur POWER_SAVE_MODEM si le SDK ne le permet pas
+// La passerelle et la feuille ESP-NOW ne changent que la frequence : leur radio reste a l'ecoute
+#define POWER_SAVE_OFF   0
+#define POWER_SAVE_MODEM 1
+#define POWER_SAVE_LIGHT 2
+#ifndef POWER_SAVE
+#define POWER_SAVE       POWER_SAVE_MODEM
+#endif
+#ifndef CPU_FREQ_IDLE_MHZ
+#define CPU_FREQ_IDLE_MHZ  80      // Minimum avec la radio active
+#endif
+#ifndef CPU_FREQ_BOOST_MHZ
+#define CPU_FREQ_BOOST_MHZ 240
+#endif
+// Courants estimes par etat (uA), pour le courant moyen du diagnostic
+#ifndef POWER_UA_BOOST
+#define POWER_UA_BOOST     120000  // CPU au maximum, radio en emission/reception
+#endif
+#ifndef POWER_UA_IDLE
+#if POWER_SAVE == POWER_SAVE_OFF || STATION_ROLE != ROLE_STANDALONE
+#define POWER_UA_IDLE      95000   // Radio eveillee
+#elif POWER_SAVE == POWER_SAVE_LIGHT
+#define POWER_UA_IDLE      3000    // Light sleep entre deux balises
+#else
+#define POWER_UA_IDLE      22000   // 80 MHz, modem sleep
+#endif
+#endif
+#ifndef POWER_UA_SLEEP
+#define POWER_UA_SLEEP     10      // Deep sleep, RTC lente conservee
+#endif
+#if POWER_SAVE < POWER_SAVE_OFF || POWER_SAVE > POWER_SAVE_LIGHT
+#error "POWER_SAVE doit valoir POWER_SAVE_OFF, POWER_SAVE_MODEM ou POWER_SAVE_LIGHT"
+#endif
+#if (CPU_FREQ_IDLE_MHZ != 80 && CPU_FREQ_IDLE_MHZ != 160 && CPU_FREQ_IDLE_MHZ != 240) || \
+    (CPU_FREQ_BOOST_MHZ != 80 && CPU_FREQ_BOOST_MHZ != 160 && CPU_FREQ_BOOST_MHZ != 240)
+#error "CPU_FREQ_IDLE_MHZ et CPU_FREQ_BOOST_MHZ : 80, 160 ou 240 (la radio exige 80 MHz au moins)"
+#endif
+#if CPU_FREQ_IDLE_MHZ > CPU_FREQ_BOOST_MHZ
+#error "CPU_FREQ_IDLE_MHZ doit rester inferieur ou egal a CPU_FREQ_BOOST_MHZ"
+#endif
+
+// --- Historique sur flash (lib/MeteoCore/src/history_log.h) ---
+// HISTORY_LOG = 1 : chaque releve horodate est aussi ecrit dans la partition
+// HISTORY_PARTITION (journal circulaire de plusieurs jours), relu a la demande
+// sur MQTT_CMD_TOPIC et renvoye par lots sur MQTT_HISTORY_TOPIC.
+// Necessite une table de partitions avec cette partition (env:esp32dev-history)
+#ifndef HISTORY_LOG
+#define HISTORY_LOG            0
+#endif
+#ifndef HISTORY_PARTITION
+#define HISTORY_PARTITION      "history"  // Type data, sous-type 0x40 (partitions_history.csv)
+#endif
+#ifndef HISTORY_REPLY_BATCH
+#define HISTORY_REPLY_BATCH    30     // Releves lus par echeance de reponse
+#endif
+#ifndef HISTORY_PENDING_LEN
+#define HISTORY_PENDING_LEN    180    // Releves gardes en RAM en attente de l'heure (30 min, 3.6 Ko)
+#endif
+#ifndef HISTORY_REPLY_INTERVAL
+#define HISTORY_REPLY_INTERVAL 200    // Cadence des lots de reponse (ms)
+#endif
+#if HISTORY_LOG && POWER_MODE == POWER_DEEP_SLEEP
+#error "HISTORY_LOG suppose une station toujours connectee (POWER_ALWAYS_ON)"
+#endif
+#if HISTORY_LOG && STATION_ROLE == ROLE_LEAF
+#error "HISTORY_LOG n'est pas disponible sur une feuille ESP-NOW (pas de MQTT)"
+#endif
+
+// --- Serveur local HTTP/WebSocket (include/local_server.h) ---
+// LOCAL_SERVER = 1 : pour la mise en service, chaque releve est pousse sur
+// ws://{ip}/ws ; /recent (derniers releves) et /diag sont servis tels que
+// rendus par la tache reseau. Tache esp_http_server sur le coeur PRO, sous la
+// tache reseau : un client lent ne retarde ni l'acquisition ni la publication
+#ifndef LOCAL_SERVER
+#define LOCAL_SERVER           0
+#endif
+#define LOCAL_SERVER_PORT      80
+#define LOCAL_MAX_SOCKETS      6      // Connexions HTTP et WebSocket (<= CONFIG_LWIP_MAX_SOCKETS - 3)
+#define LOCAL_RECENT_LEN       30     // Releves servis par /recent (5 min a READ_INTERVAL = 10 s)
+#define LOCAL_FRAME_QUEUE      4      // Releves rendus en attente d'envoi WebSocket
+#define LOCAL_FRAME_MAX        640    // Releve JSON unitaire (~190 octets, ~460 avec agregation)
+#define LOCAL_SEND_TIMEOUT_S   1      // Client WebSocket deconnecte au-dela (s)
+#define LOCAL_TASK_STACK       4096
+#define LOCAL_TASK_PRIO        1      // Sous NET_TASK_PRIO
+#if LOCAL_SERVER && POWER_MODE == POWER_DEEP_SLEEP
+#error "LOCAL_SERVER suppose une station toujours connectee (POWER_ALWAYS_ON)"
+#endif
+#if LOCAL_SERVER && STATION_ROLE == ROLE_LEAF
+#error "LOCAL_SERVER n'est pas disponible sur une feuille ESP-NOW (pas de WiFi)"
+#endif
+
+// --- WiFi ---
+#define WIFI_CONNECT_TIMEOUT 20000  // Connexion complete (scan + DHCP) (ms)
+#define WIFI_FAST_TIMEOUT    1500   // Connexion rapide sur BSSID/canal/bail en cache (ms)
+#define WIFI_LEASE_DEFAULT_S 3600   // Bail suppose si le client DHCP ne donne pas sa duree (s)
+// Attente exponentielle avec gigue entre deux tentatives, plafonnee
+#define WIFI_BACKOFF_BASE    1000
+#define WIFI_BACKOFF_MAX     300000  // 5 min
+#define MQTT_BACKOFF_BASE    1000
+#define MQTT_BACKOFF_MAX     120000  // 2 min
+#define MQTT_SOCKET_TIMEOUT_S 5      // Attente max du CONNACK (s)
+#define ONESHOT_CONNECT_TIMEOUT 30000 // Connexion en mode deep sleep (ms)
+// IP statique optionnelle (sinon bail DHCP memorise), ex. dans credentials.h :
+//   #define WIFI_STATIC_IP      192, 168, 1, 50
+//   #define WIFI_STATIC_GATEWAY 192, 168, 1, 1
+//   #define WIFI_STATIC_MASK    255, 255, 255, 0
+//   #define WIFI_STATIC_DNS     192, 168, 1, 1
+
+// --- TLS ---
+#ifndef TLS_SESSION_RESUME
+#define TLS_SESSION_RESUME     1      // Reprise de session TLS (handshake abrege)
+#endif
+#define TLS_SESSION_CACHE_SIZE 2048   // Session serialisee en memoire RTC (octets)
+#define TLS_HANDSHAKE_TIMEOUT  5000   // Duree max d'un handshake (ms)
+#define TLS_WRITE_TIMEOUT      5000   // Duree max d'une ecriture (ms), session fermee au-dela
+
+// --- Telemetrie de diagnostic ---
+#ifndef DIAG_INTERVAL
+#define DIAG_INTERVAL       60000 // Publication sur MQTT_TOPIC/diag (ms)
+#endif
+// Chronometrage des etapes (DHT, ADC, logs, connexions, publication) : 0 = retire a la compilation
+#ifndef DIAG_STAGE_TIMING
+#define DIAG_STAGE_TIMING   1
+#endif
+#define STAGE_HIST_BINS     20    // Histogramme log2 en us : [2^i, 2^(i+1)), dernier >= 2^19 us
+// Budget de latence par etape (ms) : depassements comptes dans "stages" ("over")
+#ifndef STAGE_BUDGET_SAMPLE_MS
+#define STAGE_BUDGET_SAMPLE_MS    1000
+#endif
+#define STAGE_BUDGET_DHT_MS       100     // Trame DHT11 : ~25 ms
+// ADC : duree nominale de la salve du backend (ADC_BURST_MS) plus une marge
+#ifndef STAGE_BUDGET_ADC_MS
+#if ADC_BACKEND == ADC_BACKEND_DMA
+#define STAGE_BUDGET_ADC_MS       ADC_DMA_TIMEOUT_MS   // Delai max de adcSamplerRead()
+#else
+#define STAGE_BUDGET_ADC_MS       (ADC_BURST_MS * 3 / 2)
+#endif
+#endif
+#define STAGE_BUDGET_LOG_MS       100
+#define STAGE_BUDGET_CONNECT_MS   12000   // Handshake TLS puis CONNACK (TLS_HANDSHAKE_TIMEOUT + MQTT_SOCKET_TIMEOUT_S)
+#define STAGE_BUDGET_PUBLISH_MS   6000    // Ecriture TLS (TLS_WRITE_TIMEOUT)
+#define STAGE_BUDGET_MQTT_LOOP_MS 6000    // Lecture d'un paquet (MQTT_SOCKET_TIMEOUT_S)
+#define STAGE_BUDGET_COMPRESS_MS  200
+#if STAGE_BUDGET_ADC_MS <= ADC_BURST_MS
+#error "STAGE_BUDGET_ADC_MS doit depasser la duree nominale de la salve ADC (ADC_BURST_MS)"
+#endif
+#if STAGE_BUDGET_SAMPLE_MS <= STAGE_BUDGET_ADC_MS + STAGE_BUDGET_DHT_MS
+#error "STAGE_BUDGET_SAMPLE_MS doit couvrir les etapes ADC et DHT qu'il contient"
+#endif
+
+// --- Chien de garde logiciel (include/watchdog.h) ---
+// Une etape en cours depuis WATCHDOG_STALL_FACTOR budgets, ou la tache
+// reseau sans tour de boucle hors etape pendant WATCHDOG_LOOP_STALL_MS, est
+// un blocage : la cause est ecrite en memoire RTC, la station redemarre et
+// la publie dans le diagnostic suivant. Repose sur le chronometrage des etapes
+#ifndef WATCHDOG
+#define WATCHDOG               DIAG_STAGE_TIMING
+#endif
+#define WATCHDOG_CHECK_MS      1000    // Periode du surveillant (esp_timer)
+#ifndef WATCHDOG_STALL_FACTOR
+#define WATCHDOG_STALL_FACTOR  5       // Ex. publication bloquee 30 s, connexion 60 s
+#endif
+#ifndef WATCHDOG_LOOP_STALL_MS
+#define WATCHDOG_LOOP_STALL_MS 30000
+#endif
+// Deep sleep : connexion et attente NTP forment une seule etape "connect"
+#if WATCHDOG && ONESHOT_CONNECT_TIMEOUT + NTP_SYNC_TIMEOUT >= WATCHDOG_STALL_FACTOR * STAGE_BUDGET_CONNECT_MS
+#error "ONESHOT_CONNECT_TIMEOUT + NTP_SYNC_TIMEOUT doit rester sous la limite de blocage de la connexion"
+#endif
+#if WATCHDOG && !DIAG_STAGE_TIMING
+#error "WATCHDOG suppose DIAG_STAGE_TIMING (battements portes par STAGE_TIME)"
+#endif
+
+// --- Parametres de la thermistance NTC (calibres pour le module) ---
+// Equation Beta (Steinhart-Hart simplifiee) :
+//   1/T = 1/T0 + (1/B) * ln(R/R0)
+// R_SERIES   : resistance en serie sur le module (10k)
+// B_COEFF    : coefficient Beta de la thermistance
+// R_NOMINAL  : resistance de la thermistance a T_NOMINAL (calibree)
+// T_NOMINAL  : temperature de reference (25 C)
+#define R_SERIES   10000.0
+#define B_COEFF    3950.0
+#define R_NOMINAL  1760.0
+#define T_NOMINAL  25.0
+
+// --- NTP : fuseau horaire France (CET/CEST) ---
+#define NTP_SERVER "pool.ntp.org"
+// CET = UTC+1, CEST = UTC+2 (dernier dimanche de mars -> dernier dimanche d'octobre)
+#define TZ_FRANCE  "CET-1CEST,M3.5.0,M10.5.0/3"
+// Releves pris avant NTP : publication retenue au plus ce delai (ms, MQTT
+// connecte) pour les horodater a posteriori ; au-dela, publies sans heure
+#ifndef TIME_BACKFILL_WAIT
+#define TIME_BACKFILL_WAIT 30000
+#endif
+
+// --- MQTT : topic construit a partir des credentials ---
+// Format : sensors/{MQTT_USER}/{MQTT_DEVICE}
+#define MQTT_TOPIC "sensors/" MQTT_USER "/" MQTT_DEVICE
+#define MQTT_DIAG_TOPIC MQTT_TOPIC "/diag"
+#define MQTT_BATCH_TOPIC MQTT_TOPIC "/batch"
+#if PAYLOAD_ENCODING == ENCODING_CBOR
+#define MQTT_ENCODED_SUFFIX "/cbor"
+#else
+#define MQTT_ENCODED_SUFFIX "/bin"
+#endif
+#define MQTT_ENCODED_TOPIC MQTT_TOPIC MQTT_ENCODED_SUFFIX
+#define MQTT_COMPRESSED_TOPIC MQTT_TOPIC "/z"
+#define MQTT_CMD_TOPIC MQTT_TOPIC "/cmd"
+#define MQTT_HISTORY_TOPIC MQTT_TOPIC "/history"
+#define MQTT_HISTORY_DONE_TOPIC MQTT_TOPIC "/history/done"
+
+#endif
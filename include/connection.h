@@ -0,0 +1,60 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <stdint.h>
+#include <PubSubClient.h>
+#include "backoff.h"
+
+/**
+ * Machines a etats non bloquantes pour les connexions WiFi et MQTT.
+ *
+ * step() ne fait jamais d'attente active : il lance une connexion, en
+ * observe l'etat, ou attend l'echeance de la prochaine tentative (attente
+ * exponentielle avec gigue, plafonnee). La seule operation longue est une
+ * tentative MQTT unique, bornee par les timeouts TCP, TLS
+ * (TLS_HANDSHAKE_TIMEOUT) et CONNACK (MQTT_SOCKET_TIMEOUT_S).
+ */
+class ConnectionManager {
+ public:
+  enum WifiState : uint8_t { WIFI_IDLE, WIFI_CONNECTING_FAST, WIFI_CONNECTING_FULL, WIFI_UP, WIFI_BACKOFF };
+  enum MqttState : uint8_t { MQTT_DOWN, MQTT_BACKOFF, MQTT_UP };
+
+  explicit ConnectionManager(PubSubClient& mqtt);
+
+  /** Fait avancer les deux machines a etats d'un pas. */
+  void step(uint32_t now);
+
+  /** Demarre (ou non) la synchronisation NTP a la premiere connexion WiFi. */
+  void setNtpEnabled(bool enabled) { ntpEnabled_ = enabled; }
+
+  bool wifiUp() const { return wifi_ == WIFI_UP; }
+  bool mqttUp() const { return mqtt_ == MQTT_UP; }
+
+  // --- Statistiques pour le diagnostic ---
+  uint32_t wifiConnectMs() const { return wifiConnectMs_; }
+  bool wifiFastUsed() const { return wifiFast_; }
+  uint16_t wifiAttempts() const { return wifiBackoff_.attempts(); }
+  uint16_t mqttAttempts() const { return mqttBackoff_.attempts(); }
+  uint32_t wifiRetryInMs(uint32_t now) const;
+  uint32_t mqttRetryInMs(uint32_t now) const;
+
+ private:
+  void stepWifi(uint32_t now);
+  void stepMqtt(uint32_t now);
+  void onWifiUp(uint32_t now);
+
+  PubSubClient& client_;
+  WifiState wifi_ = WIFI_IDLE;
+  MqttState mqtt_ = MQTT_DOWN;
+  uint32_t wifiStart_ = 0;
+  uint32_t wifiRetryAt_ = 0;
+  uint32_t mqttRetryAt_ = 0;
+  Backoff wifiBackoff_;
+  Backoff mqttBackoff_;
+  uint32_t wifiConnectMs_ = 0;
+  bool wifiFast_ = false;
+  bool ntpEnabled_ = true;
+  bool ntpStarted_ = false;
+};
+
+#endif
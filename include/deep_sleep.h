@@ -0,0 +1,13 @@
+#ifndef DEEP_SLEEP_H
+#define DEEP_SLEEP_H
+
+/**
+ * Cycle de reveil du mode POWER_DEEP_SLEEP, appele depuis setup().
+ *
+ * Effectue un releve, l'ajoute au tampon en memoire RTC, et n'allume la
+ * radio que tous les DEEP_SLEEP_BATCH releves pour publier le lot.
+ * Ne retourne jamais : se termine par esp_deep_sleep_start().
+ */
+void runDeepSleepCycle();
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef DHT_SENSOR_H
+#define DHT_SENSOR_H
+
+#include <stdint.h>
+
+/**
+ * Capteur DHT (DHT_PIN, DHT_TYPE) : derniere valeur valide en cache,
+ * compteurs d'erreurs au lieu de NaN.
+ *
+ * Backend DHT_BACKEND_RMT : le signal de depart est emis en open-drain
+ * (attente passive), puis le peripherique RMT horodate les fronts de la
+ * trame et la remet par son ringbuffer ; la tache appelante est bloquee
+ * sans masquer les interruptions (WiFi non perturbe).
+ */
+
+struct DhtStats {
+  uint32_t reads;           // Trames valides
+  uint32_t checksumErrors;
+  uint32_t frameErrors;     // Trame incomplete ou durees hors tolerance
+  uint32_t timeouts;        // Aucune reponse
+  uint32_t cached;          // Valeurs servies depuis le cache
+};
+
+/** Initialise le backend choisi par DHT_BACKEND. */
+void dhtSensorBegin();
+
+/**
+ * Retourne la temperature (C) et l'humidite (%). Appele plus souvent que la
+ * cadence max du capteur (1 Hz DHT11, 0,5 Hz DHT22), sert la valeur en
+ * cache ; apres un echec, la derniere valeur valide de moins de DHT_STALE_MAX ms.
+ * Retourne false si aucune valeur valide n'est disponible.
+ */
+bool dhtSensorRead(float& temp, float& hum);
+
+/** Compteurs depuis le demarrage. */
+const DhtStats& dhtSensorStats();
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <stdint.h>
+#include "config.h"
+#include "espnow_frame.h"
+#include "reading.h"
+
+/**
+ * Passerelle ESP-NOW (STATION_ROLE == ROLE_GATEWAY).
+ *
+ * Les stations feuilles envoient leurs releves compacts en ESP-NOW, sans
+ * association WiFi ni TLS. La passerelle acquitte chaque trame (avec son
+ * heure, qui synchronise la feuille) et la garde dans une file de relais
+ * jusqu'a sa publication par la tache reseau : une trame donne un message
+ * groupe sur sensors/{MQTT_USER}/{nom de la feuille}. Une trame deja recue
+ * (acquittement perdu, meme numero) est acquittee sans etre relayee deux
+ * fois ; si la file est pleine, elle est refusee et la feuille la garde.
+ *
+ * Le callback de reception (tache WiFi) ne fait que copier la trame dans
+ * une file FreeRTOS ; tout le reste tourne dans la tache reseau.
+ */
+
+/** Trame relayee : releves d'une feuille. */
+struct RelayFrame {
+  uint8_t leaf;    // Index de la feuille (gatewayLeafName)
+  uint8_t count;
+  PackedReading readings[ESPNOW_FRAME_READINGS];
+};
+
+struct GatewayStats {
+  uint32_t frames;       // Trames acceptees
+  uint32_t duplicates;   // Retransmissions deja relayees
+  uint32_t rejected;     // Refusees (file de relais pleine, table des feuilles pleine)
+  uint32_t invalid;      // Format inconnu ou tronque
+  uint32_t rxDropped;    // Perdues avant traitement (file de reception pleine)
+  uint8_t leaves;
+};
+
+/** Demarre ESP-NOW sur l'interface STA (apres WiFi.mode(WIFI_STA)). */
+void gatewayBegin();
+
+/** Traite les trames recues : acquittement et file de relais. */
+void gatewayPoll();
+
+/** Trames en attente de publication. */
+uint16_t gatewayPending();
+
+/** Copie la trame d'indice i (0 = plus ancienne). Retourne false si absente. */
+bool gatewayPeek(uint16_t i, RelayFrame& out);
+
+/** Retire les `n` plus anciennes trames (publiees ou acquittees). */
+void gatewayConsume(uint32_t n);
+
+const char* gatewayLeafName(uint8_t leaf);
+
+const GatewayStats& gatewayStats();
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "history_log.h"
+#include "reading.h"
+
+/**
+ * Historique des releves sur la partition HISTORY_PARTITION (HISTORY_LOG,
+ * voir lib/MeteoCore/src/history_log.h pour le format).
+ *
+ * Chaque releve recu par la tache reseau y est ajoute, independamment de
+ * sa publication : la partition garde plusieurs jours de releves a pleine
+ * cadence (1 Mo : 43 520 releves, 5 jours a READ_INTERVAL = 10 s) et le
+ * backend peut en redemander une plage apres une ingestion manquee.
+ *
+ * Seuls les releves horodates sont conserves : ceux pris avant NTP (heure
+ * relative, timebase.h) attendent en RAM (HISTORY_PENDING_LEN) et sont
+ * ecrits, dans l'ordre, des que l'heure est connue. Au-dela, les plus
+ * anciens sont ecartes et comptes ("unstamped"), le tampon de coupure les
+ * publiant de toute facon.
+ *
+ * La lecture se fait dans la projection memoire de la partition
+ * (esp_partition_mmap), sans copie des enregistrements parcourus ; les
+ * effacements et ecritures passent par esp_partition_erase_range et
+ * esp_partition_write. A appeler depuis la seule tache reseau.
+ */
+
+/** Ouvre la partition et retrouve la position d'ajout. Retourne false si elle est absente. */
+bool historyBegin();
+
+/** Ajoute un releve (mis en attente tant qu'il n'a pas d'heure UNIX). */
+void historyAppend(const Reading& r);
+
+/** Curseur de lecture a partir de `from` (termine si l'historique est indisponible). */
+HistoryCursor historySeek(uint32_t from);
+
+/** Releves suivants de [from, to], au plus `max` (voir HistoryLog::read). */
+uint16_t historyRead(HistoryCursor& c, uint32_t from, uint32_t to, PackedReading* out,
+                     uint16_t max);
+
+/**
+ * Ecrit "history":{...} dans `buf` (etat du journal pour le diagnostic).
+ * Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t historyJson(char* buf, size_t len);
+
+#endif
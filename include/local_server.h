@@ -0,0 +1,40 @@
+#ifndef LOCAL_SERVER_H
+#define LOCAL_SERVER_H
+
+#include <stddef.h>
+#include "reading.h"
+
+/**
+ * Serveur local HTTP/WebSocket pour la mise en service (LOCAL_SERVER),
+ * sans passer par le broker :
+ *   /        page qui affiche le flux en direct
+ *   /ws      WebSocket : un message JSON unitaire par releve (format MQTT_TOPIC)
+ *   /recent  les LOCAL_RECENT_LEN derniers releves (format groupe)
+ *   /diag    le dernier diagnostic (format MQTT_DIAG_TOPIC)
+ *
+ * Tout est rendu une seule fois par la tache reseau, au fil des releves et
+ * des diagnostics : les clients recoivent les memes octets, sans encodage
+ * par client. Le serveur (esp_http_server) a sa propre tache sur le coeur
+ * PRO, de priorite inferieure a la tache reseau ; la tache reseau ne fait
+ * que copier le rendu, sans jamais attendre un client : un releve qui ne
+ * trouve pas de place dans la file d'envoi est ecarte (compte dans le
+ * diagnostic) et un client plus lent que LOCAL_SEND_TIMEOUT_S est deconnecte.
+ * L'acquisition (coeur APP) n'est pas concernee.
+ */
+
+/** Demarre le serveur (au premier appel, WiFi connecte). */
+void localServerBegin();
+
+/** Rend un nouveau releve pour /ws et /recent. A appeler depuis la tache reseau. */
+void localServerPush(const Reading& r);
+
+/** Remplace le diagnostic servi par /diag (copie de `json`). */
+void localServerSetDiag(const char* json, size_t len);
+
+/**
+ * Ecrit "local":{...} dans `buf` (clients, envois, releves ecartes).
+ * Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t localServerJson(char* buf, size_t len);
+
+#endif
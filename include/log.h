@@ -0,0 +1,64 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include "config.h"
+
+/**
+ * Journal serie asynchrone a niveaux fixes a la compilation.
+ *
+ * LOG_E / LOG_W / LOG_I / LOG_D prennent un format printf (sans '\n', ajoute
+ * automatiquement). Au-dessus de LOG_LEVEL, l'appel et ses arguments
+ * disparaissent du binaire. Sinon le message est formate dans un tampon
+ * circulaire (LOG_BUFFER_SIZE) qu'une tache de faible priorite vide vers
+ * l'UART : l'appelant n'attend jamais la liaison serie. Tampon plein : le
+ * message est perdu et compte.
+ */
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+/** Demarre la tache de vidage (messages anterieurs conserves). */
+void logBegin();
+
+/** Attend que le tampon soit vide et que l'UART ait tout emis (avant deep sleep). */
+void logFlush(uint32_t timeoutMs = 500);
+
+/** Messages perdus faute de place depuis le demarrage. */
+uint32_t logDropped();
+
+void logWrite(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#else
+
+inline void logBegin() {}
+inline void logFlush(uint32_t = 500) {}
+inline uint32_t logDropped() { return 0; }
+
+#endif
+
+#define LOG_NOP() do {} while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) logWrite("ERREUR " fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(...) LOG_NOP()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) logWrite(fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(...) LOG_NOP()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) logWrite(fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(...) LOG_NOP()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) logWrite(fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(...) LOG_NOP()
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef MQTT_LINK_H
+#define MQTT_LINK_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "config.h"
+#include "mqtt_packet.h"
+#include "ring_buffer.h"
+
+/**
+ * Transport MQTT intercale entre PubSubClient et le client TLS.
+ *
+ * PubSubClient ne publie qu'en QoS 0 et ignore les PUBACK : ce client
+ * relaie tous les appels vers `inner` et observe au passage le flux entrant
+ * (MqttAckParser) pour en extraire les identifiants acquittes. Les PUBLISH
+ * QoS 1 sont ecrits directement sur le transport, hors PubSubClient, qui
+ * continue de gerer connexion, keepalive et lecture des paquets.
+ */
+class MqttLink : public Client {
+ public:
+  explicit MqttLink(Client& inner) : inner_(inner) {}
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override { return inner_.write(b); }
+  size_t write(const uint8_t* buf, size_t size) override { return inner_.write(buf, size); }
+  int available() override { return inner_.available(); }
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override { return inner_.peek(); }
+  void flush() override { inner_.flush(); }
+  void stop() override { inner_.stop(); }
+  uint8_t connected() override { return inner_.connected(); }
+  operator bool() override { return connected(); }
+
+  /**
+   * Envoie un PUBLISH QoS 1 (`dup` pour une retransmission).
+   * Retourne false si l'ecriture est incomplete.
+   */
+  bool publishQos1(const char* topic, const uint8_t* payload, size_t len, uint16_t packetId,
+                   bool dup);
+
+  /** Retire le plus ancien identifiant acquitte. Retourne false s'il n'y en a pas. */
+  bool takeAck(uint16_t& packetId) { return acks_.pop(packetId); }
+
+  /** PUBACK perdus faute de place (le message sera retransmis). */
+  uint32_t acksDropped() const { return acksDropped_; }
+
+ private:
+  void feed(uint8_t b);
+
+  Client& inner_;
+  MqttAckParser parser_;
+  RingBuffer<uint16_t, MQTT_INFLIGHT_MAX * 2> acks_;
+  uint32_t acksDropped_ = 0;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "reading.h"
+
+/**
+ * Demarre la tache reseau sur le coeur PRO. Elle possede le client
+ * TLS (tls_client.h) et PubSubClient, maintient les connexions et publie
+ * les releves de `queue` dans l'ordre. Tant que MQTT est indisponible,
+ * les releves sont conserves dans le tampon de coupure (outage_buffer.h).
+ */
+void startNetwork(QueueHandle_t queue);
+
+// --- Mode ponctuel (deep sleep) : sans tache, appele depuis setup() ---
+
+/**
+ * Connexion WiFi puis MQTT. Si `syncTime`, attend une synchronisation NTP
+ * (au plus NTP_SYNC_TIMEOUT). Retourne true si MQTT est connecte.
+ */
+bool networkConnectOnce(bool syncTime);
+
+/**
+ * Publie des releves compacts dans l'ordre. Retourne le nombre de releves
+ * publies (s'arrete au premier echec).
+ */
+uint16_t networkPublishPacked(const PackedReading* batch, uint16_t n);
+
+/**
+ * Publie le bilan d'energie (power.h) et l'etat du chien de garde
+ * (watchdog.h) sur MQTT_DIAG_TOPIC ; sans effet sur une feuille.
+ */
+void networkPublishPower();
+
+/** Ferme proprement MQTT/TLS et coupe la radio avant la mise en veille. */
+void networkShutdown();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef OUTAGE_BUFFER_H
+#define OUTAGE_BUFFER_H
+
+#include <stdint.h>
+#include "config.h"
+#include "reading.h"
+#include "ring_buffer.h"
+
+/**
+ * Tampon de coupure : conserve les releves non publies (horodatage d'origine)
+ * pour les rejouer par lots apres reconnexion.
+ *
+ * Les releves sont gardes en RAM (OUTAGE_BUFFER_LEN). Avec OUTAGE_SPILL_FS,
+ * les plus anciens sont deplaces par blocs vers un fichier LittleFS quand la
+ * RAM est pleine ; le fichier est rejoue en premier pour respecter l'ordre.
+ * Au-dela, OUTAGE_POLICY decide quel releve est ecarte.
+ *
+ * Le nombre de releves deja rejoues depuis le fichier est garde dans
+ * OUTAGE_SPILL_POS : un redemarrage ne les renvoie pas. Le fichier est
+ * recopie sans eux (compactSpill) au demarrage, quand il atteint
+ * OUTAGE_SPILL_MAX et apres une ecriture incomplete, qui laisserait des
+ * releves desalignes en fin de fichier.
+ *
+ * Utilise uniquement par la tache reseau (pas de verrou).
+ */
+class OutageBuffer {
+ public:
+  /** Monte LittleFS si le debordement sur flash est active. */
+  void begin();
+
+  /** Ajoute un releve en fin de tampon (politique de debordement si plein). */
+  void push(const Reading& r);
+
+  /**
+   * Copie jusqu'a `max` releves parmi les plus anciens, sans les retirer,
+   * en sautant les `skip` premiers (messages deja en vol). Ne melange pas
+   * fichier et RAM. Retourne le nombre de releves copies.
+   */
+  uint16_t peekBatch(PackedReading* out, uint16_t max, uint32_t skip = 0);
+
+  /** Retire les `n` plus anciens releves (apres publication reussie). */
+  void consume(uint32_t n);
+
+  uint32_t depth() const { return ram_.size() + spilled(); }
+  uint32_t spilled() const { return spillCount_ - spillReadPos_; }
+  uint32_t dropped() const { return dropped_; }
+  /** Releves retires en tete sans publication : les index de peekBatch changent. */
+  uint32_t evicted() const { return evicted_; }
+  uint32_t highWater() const { return highWater_; }
+  static constexpr uint16_t capacity() { return OUTAGE_BUFFER_LEN; }
+  static const char* policyName();
+
+ private:
+  bool spillOldest();
+  bool compactSpill();
+  void discardSpill();
+  void updateHighWater();
+
+  RingBuffer<PackedReading, OUTAGE_BUFFER_LEN> ram_;
+  uint32_t spillCount_ = 0;    // Releves ecrits dans le fichier
+  uint32_t spillReadPos_ = 0;  // Releves deja rejoues depuis le fichier
+  uint32_t priorBoot_ = 0;     // Releves du fichier ecrits avant le demarrage
+  uint32_t dropped_ = 0;
+  uint32_t evicted_ = 0;
+  uint32_t highWater_ = 0;
+  bool fsReady_ = false;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Gestion de l'energie entre les taches (POWER_SAVE, voir config.h).
+ *
+ * Le CPU tourne a CPU_FREQ_IDLE_MHZ et la radio en modem sleep la plupart
+ * du temps : acquisition, attente des echeances, keepalive MQTT. Il ne
+ * remonte a CPU_FREQ_BOOST_MHZ que pendant un PowerBoost (handshake TLS,
+ * publication, rejeu compresse, session radio du deep sleep). Le temps
+ * passe dans chaque etat est mesure (power_meter.h) et publie dans le
+ * diagnostic avec le courant moyen estime.
+ *
+ * Avec POWER_SAVE_LIGHT et un SDK compile avec CONFIG_PM_ENABLE et le
+ * tickless idle, la frequence et le light sleep sont confies a esp_pm ;
+ * PowerBoost tient alors un verrou ESP_PM_CPU_FREQ_MAX.
+ *
+ * powerBoost/powerRelax s'emboitent et s'appellent depuis une seule tache
+ * (tache reseau, ou setup() en deep sleep).
+ */
+
+/** Frequence de repos, modem sleep ; a appeler au demarrage, avant le WiFi. */
+void powerBegin();
+
+void powerBoost();
+void powerRelax();
+
+/** CPU_FREQ_BOOST_MHZ pendant la portee englobante. */
+class PowerBoost {
+ public:
+  PowerBoost() { powerBoost(); }
+  ~PowerBoost() { powerRelax(); }
+  PowerBoost(const PowerBoost&) = delete;
+  PowerBoost& operator=(const PowerBoost&) = delete;
+};
+
+/** Deep sleep : compte le sommeil a venir dans le bilan (conserve en memoire RTC). */
+void powerDeepSleep(uint64_t sleepUs);
+
+/**
+ * Ecrit "power":{...} dans `buf` pour la fenetre en cours, sans la fermer.
+ * Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t powerJson(char* buf, size_t len);
+
+/** Diagnostic publie : retire de la fenetre ce que le dernier powerJson a rapporte. */
+void powerReported();
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <math.h>
+#include "adc_sampler.h"
+#include "dht_sensor.h"
+#include "log.h"
+#include "ntc_lut.h"
+#include "reading.h"
+#include "sensor_registry.h"
+#include "stage_stats.h"
+
+/**
+ * Capteurs de la station, declares pour SensorRegistry
+ * (lib/MeteoCore/src/sensor_registry.h). Fonctions statiques en ligne :
+ * la tache d'acquisition les appelle directement.
+ */
+
+/** DHT11 (RMT) : temperature et humidite. */
+struct DhtProbe {
+  static constexpr uint8_t MASK = (1 << CH_DHT_TEMP) | (1 << CH_DHT_HUM);
+
+  static void begin() { dhtSensorBegin(); }
+
+  static void sample(Reading& r) {
+    STAGE_TIME(STAGE_DHT);
+    float temp = NAN, hum = NAN;
+    if (dhtSensorRead(temp, hum)) {
+      r.valid |= MASK;
+    }
+    r.value[CH_DHT_TEMP] = temp;
+    r.value[CH_DHT_HUM] = hum;
+  }
+
+  static void log(const Reading& r) {
+    if (!readingValid(r, CH_DHT_TEMP)) {
+      LOG_D("DHT11           : erreur de lecture");
+    } else {
+      LOG_D("DHT11           : %.1f C | %.1f %%", r.value[CH_DHT_TEMP], r.value[CH_DHT_HUM]);
+    }
+  }
+};
+
+/** Voies analogiques (backend ADC_BACKEND) : NTC et LDR dans la meme rafale. */
+struct AnalogProbe {
+  static constexpr uint8_t MASK = (1 << CH_NTC_TEMP) | (1 << CH_LUMINOSITY);
+
+  static void begin() { adcSamplerBegin(); }
+
+  static void sample(Reading& r) {
+    STAGE_TIME(STAGE_ADC);
+    AdcSample adc;
+    if (!adcSamplerRead(adc)) {
+      return;
+    }
+    // Table Beta precalculee (lib/MeteoCore/src/ntc_lut.h)
+    r.value[CH_NTC_TEMP] = ntcTempFromRawInterp(adc.ntcRaw);
+    r.value[CH_LUMINOSITY] = ldrPctFromRaw(adc.ldrRaw);
+    r.valid |= MASK;
+  }
+
+  static void log(const Reading& r) {
+    if (!readingValid(r, CH_NTC_TEMP)) {
+      LOG_D("ADC             : erreur de lecture");
+    } else {
+      LOG_D("Temperature NTC : %.1f C", r.value[CH_NTC_TEMP]);
+      LOG_D("Luminosite      : %.0f %%", r.value[CH_LUMINOSITY]);
+    }
+  }
+};
+
+/** Capteurs lus a chaque releve, dans l'ordre d'acquisition. */
+using Sensors = SensorRegistry<DhtProbe, AnalogProbe>;
+
+static_assert(Sensors::MASK == ALL_CHANNELS, "Chaque canal doit etre rempli par un capteur");
+
+#endif
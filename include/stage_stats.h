@@ -0,0 +1,121 @@
+#ifndef STAGE_STATS_H
+#define STAGE_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * Chronometrage des etapes du cycle (esp_timer, en microsecondes).
+ *
+ * Chaque etape accumule min/max/moyenne et un histogramme log2 sur une
+ * fenetre, publies puis remis a zero par la tache de diagnostic
+ * (DIAG_INTERVAL). Mises a jour depuis les deux coeurs sous spinlock,
+ * quelques dizaines de cycles par mesure. Une mesure au-dela du budget de
+ * l'etape (STAGE_BUDGET_*_MS) est comptee a part ("over").
+ *
+ * Avec WATCHDOG, chaque etape est aussi un battement pour le chien de
+ * garde (watchdog.h) : son debut et sa fin sont suivis par coeur
+ * (stall_watch.h), une seule tache chronometree par coeur.
+ *
+ * Avec DIAG_STAGE_TIMING a 0, STAGE_TIME() ne genere aucun code.
+ */
+
+enum Stage : uint8_t {
+  STAGE_SAMPLE,     // Cycle d'acquisition complet
+  STAGE_DHT,        // Lecture DHT (protocole 1 fil)
+  STAGE_ADC,        // Rafale ADC NTC + LDR
+  STAGE_LOG,        // Affichage Serial du releve
+  STAGE_CONNECT,    // Machine d'etats WiFi/MQTT (y compris handshake TLS)
+  STAGE_PUBLISH,    // Formatage et envoi sur MQTT (ecriture TLS)
+  STAGE_MQTT_LOOP,  // Keepalive et messages entrants
+  STAGE_COMPRESS,   // Lot de rejeu compresse (REPLAY_COMPRESS)
+  STAGE_COUNT
+};
+
+struct StageStats {
+  uint32_t count;
+  uint32_t over;        // Mesures au-dela du budget
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint32_t hist[STAGE_HIST_BINS];
+};
+
+/** Classe d'histogramme d'une duree : floor(log2(us)), bornee. */
+inline uint8_t stageBin(uint32_t us) {
+  uint8_t bin = 0;
+  while (us > 1 && bin < STAGE_HIST_BINS - 1) {
+    us >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+#if DIAG_STAGE_TIMING
+
+#include <esp_timer.h>
+#include "stall_watch.h"
+
+/** Debut de l'etape `stage` (battement du chien de garde). */
+void stageBegin(Stage stage, int64_t startUs);
+
+/** Fin de l'etape : ajoute une mesure a `stage`. */
+void stageRecord(Stage stage, uint32_t us);
+
+/** Nom de l'etape dans le diagnostic, "none" pour WATCH_NONE. */
+const char* stageName(uint8_t stage);
+
+#if WATCHDOG
+/** Tour de boucle de la tache appelante, hors etape. */
+void stageBeat();
+
+/** Surveille le battement de boucle de la tache appelante (0 : non surveille). */
+void stageWatchLoop(uint32_t loopStallMs);
+
+/**
+ * Cherche un blocage sur chaque coeur (depuis le surveillant).
+ * Retourne true et remplit `core` et `out` au premier trouve.
+ */
+bool stageFindStall(uint32_t nowMs, uint8_t& core, Stall& out);
+#endif
+
+/**
+ * Ecrit "stages":{"dht":{...},...} dans `buf` pour la fenetre en cours, sans
+ * la fermer. Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t stageStatsJson(char* buf, size_t len);
+
+/**
+ * Diagnostic publie : retire de la fenetre les mesures rapportees par le
+ * dernier stageStatsJson. Les mesures prises depuis restent comptees ; min
+ * et max ne sont remis a zero que si la fenetre est vide.
+ */
+void stageStatsReported();
+
+/** Mesure la duree de la portee englobante. */
+class StageTimer {
+ public:
+  explicit StageTimer(Stage stage) : stage_(stage), start_(esp_timer_get_time()) {
+    stageBegin(stage, start_);
+  }
+  ~StageTimer() { stageRecord(stage_, (uint32_t)(esp_timer_get_time() - start_)); }
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+
+ private:
+  Stage stage_;
+  int64_t start_;
+};
+
+#define STAGE_CONCAT_(a, b) a##b
+#define STAGE_CONCAT(a, b) STAGE_CONCAT_(a, b)
+#define STAGE_TIME(stage) StageTimer STAGE_CONCAT(stageTimer_, __LINE__)(stage)
+
+#else
+
+#define STAGE_TIME(stage) do {} while (0)
+
+#endif
+
+#endif
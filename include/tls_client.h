@@ -0,0 +1,70 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFi.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl.h>
+
+/**
+ * Client TLS (mbedtls sur WiFiClient) avec reprise de session.
+ *
+ * WiFiClientSecure refait un handshake complet a chaque connexion. Ici la
+ * session negociee (ticket RFC 5077 ou identifiant de session) est
+ * serialisee en memoire RTC apres chaque handshake et proposee au serveur
+ * a la connexion suivante : un handshake abrege suffit, y compris apres un
+ * deep sleep. Le certificat du serveur n'est pas verifie (equivalent de
+ * WiFiClientSecure::setInsecure()).
+ */
+class TlsClient : public Client {
+ public:
+  TlsClient();
+  ~TlsClient();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+  /** Oublie la session en cache (prochain handshake complet). */
+  void forgetSession();
+
+  // --- Statistiques pour le diagnostic ---
+  uint32_t lastHandshakeMs() const { return lastHandshakeMs_; }
+  bool lastResumed() const { return lastResumed_; }
+  uint32_t handshakes() const { return handshakes_; }
+  uint32_t resumptions() const { return resumptions_; }
+
+ private:
+  bool setup();
+  bool handshake(const char* host);
+  void cacheSession();
+  static int sendCb(void* ctx, const unsigned char* buf, size_t len);
+  static int recvCb(void* ctx, unsigned char* buf, size_t len);
+
+  WiFiClient tcp_;
+  mbedtls_ssl_context ssl_;
+  mbedtls_ssl_config conf_;
+  mbedtls_entropy_context entropy_;
+  mbedtls_ctr_drbg_context drbg_;
+  bool ready_ = false;
+  bool connected_ = false;
+  int peeked_ = -1;
+
+  uint32_t lastHandshakeMs_ = 0;
+  bool lastResumed_ = false;
+  uint32_t handshakes_ = 0;
+  uint32_t resumptions_ = 0;
+};
+
+#endif
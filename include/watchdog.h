@@ -0,0 +1,36 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stddef.h>
+
+/**
+ * Chien de garde logiciel (WATCHDOG, voir lib/MeteoCore/src/stall_watch.h).
+ *
+ * Les etapes chronometrees (STAGE_TIME) servent de battements : un
+ * surveillant esp_timer verifie toutes les WATCHDOG_CHECK_MS qu'aucune
+ * n'est en cours depuis plus de WATCHDOG_STALL_FACTOR fois son budget
+ * (STAGE_BUDGET_*_MS), et que la tache reseau fait des tours de boucle hors
+ * etape. Sinon la station est bloquee (connexion WiFi/TLS, ecriture TLS dans
+ * une publication, lecture DHT...) : le coeur, l'etape et la duree sont
+ * ecrits en memoire RTC non initialisee, puis la station redemarre.
+ *
+ * Au demarrage suivant, le releve et la cause du redemarrage
+ * (esp_reset_reason) sont ajoutes au diagnostic, avec le nombre de
+ * blocages depuis la mise sous tension. Les redemarrages materiels
+ * (watchdog d'interruption, panique) n'ont pas de releve mais leur cause
+ * est rapportee.
+ */
+
+/** Relit le releve RTC et demarre le surveillant ; a appeler au plus tot dans setup(). */
+void watchdogBegin();
+
+/**
+ * Ecrit "watchdog":{...} dans `buf`.
+ * Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t watchdogJson(char* buf, size_t len);
+
+/** Diagnostic publie : le releve n'est plus rapporte aux demarrages suivants. */
+void watchdogReported();
+
+#endif
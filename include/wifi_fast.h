@@ -0,0 +1,39 @@
+#ifndef WIFI_FAST_H
+#define WIFI_FAST_H
+
+#include <stdint.h>
+
+/**
+ * Reconnexion WiFi rapide.
+ *
+ * Apres une connexion reussie, le BSSID, le canal et le bail DHCP (IP,
+ * passerelle, masque, DNS) sont memorises en memoire RTC (survit au deep
+ * sleep) et en NVS (survit a une coupure d'alimentation, ecrit seulement
+ * s'il change). La connexion suivante cible directement ce point d'acces
+ * sur ce canal et reutilise l'adresse, sans scan ni DHCP. En cas d'echec,
+ * le cache est invalide et une connexion complete est lancee.
+ *
+ * L'adresse reprise n'est pas renouvelee aupres du serveur : la duree du bail
+ * et son heure d'obtention sont memorisees, et une connexion complete (DHCP)
+ * est imposee des que la moitie du bail est ecoulee. Une connexion rapide
+ * suivie d'un echec MQTT ou DNS invalide aussi le cache (ConnectionManager).
+ *
+ * Avec WIFI_STATIC_IP defini, l'adresse statique remplace le bail DHCP.
+ */
+
+/**
+ * Lance la connexion en mode rapide si un cache valide existe.
+ * Retourne false si aucun cache n'est disponible (rien n'est lance).
+ */
+bool wifiBeginFast();
+
+/** Lance une connexion complete (scan + DHCP, ou IP statique). */
+void wifiBeginFull();
+
+/** Memorise les parametres de la connexion courante. */
+void wifiCacheStore();
+
+/** Invalide le cache (point d'acces change, bail refuse...). */
+void wifiCacheInvalidate();
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ADAPTIVE_RATE_H
+#define ADAPTIVE_RATE_H
+
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Cadence d'acquisition adaptative : l'intervalle entre deux releves suit la
+ * vitesse de variation des canaux.
+ *
+ * Chaque canal a un pas vise (centiemes) : la variation acceptable entre deux
+ * releves. Si un canal varie de plus que son pas, l'intervalle est reduit en
+ * proportion (intervalle * pas / variation) pour ramener la variation par
+ * releve sous le pas : une montee brusque (lever du soleil, porte ouverte) est
+ * suivie des le releve suivant. Apres `quietSamples` releves consecutifs ou
+ * tous les canaux restent sous la moitie de leur pas, l'intervalle est
+ * allonge de moitie. La comparaison porte sur le releve precedent, pas sur
+ * une valeur publiee ; un canal invalide sur l'un des deux releves est ignore.
+ *
+ * L'intervalle est borne a [minMs, maxMs] et arrondi a la seconde inferieure.
+ * Etat POD sans constructeur : peut etre place en memoire RTC (deep sleep).
+ */
+struct AdaptiveRate {
+  uint32_t intervalMs;         // Intervalle courant, 0 avant le premier releve
+  int16_t centi[CH_COUNT];     // Releve precedent par canal
+  uint8_t valid;               // Validite du releve precedent
+  uint8_t quiet;               // Releves calmes consecutifs
+};
+
+/**
+ * Prend en compte le releve `r` et retourne l'intervalle (ms) jusqu'au
+ * suivant. Le premier appel part de `maxMs` : la station demarre au calme
+ * et accelere des que le signal bouge.
+ */
+inline uint32_t adaptiveUpdate(AdaptiveRate& st, const Reading& r, const int16_t step[CH_COUNT],
+                               uint32_t minMs, uint32_t maxMs, uint8_t quietSamples) {
+  // Plus forte variation relative au pas, en 1/256 de pas
+  uint32_t activity = 0;
+  uint8_t both = st.intervalMs ? (r.valid & st.valid) : 0;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    int16_t c = readingCenti(r, (Channel)ch);
+    if (both & (1u << ch)) {
+      int32_t delta = (int32_t)c - st.centi[ch];
+      uint32_t a = (uint32_t)(delta < 0 ? -delta : delta) * 256 / (uint32_t)step[ch];
+      if (a > activity) {
+        activity = a;
+      }
+    }
+    st.centi[ch] = c;
+  }
+  st.valid = r.valid;
+
+  uint32_t next = st.intervalMs ? st.intervalMs : maxMs;
+  if (activity > 256) {
+    next = (uint32_t)((uint64_t)next * 256 / activity);
+    st.quiet = 0;
+  } else if (st.intervalMs && activity < 128) {
+    if (++st.quiet >= quietSamples) {
+      next += next / 2;
+      st.quiet = 0;
+    }
+  } else {
+    st.quiet = 0;
+  }
+  next = next / 1000 * 1000;
+  if (next < minMs) next = minMs;
+  if (next > maxMs) next = maxMs;
+  st.intervalMs = next;
+  return next;
+}
+
+#endif
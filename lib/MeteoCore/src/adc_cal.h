@@ -0,0 +1,50 @@
+#ifndef ADC_CAL_H
+#define ADC_CAL_H
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * Correction de la non-linearite de l'ADC ESP32 (attenuation 11 dB).
+ *
+ * Au demarrage, la caracterisation esp_adc_cal du composant (eFuse Two
+ * Point ou Vref, sinon ADC_CAL_DEFAULT_VREF) est evaluee une fois pour
+ * chaque code brut et rangee dans une table de 4096 entrees : le code
+ * "lineaire" equivalent, V / ADC_SUPPLY_MV * 4095, en 1/16 de LSB. Une
+ * mesure ne coute ensuite qu'une lecture de table ; le code corrige
+ * alimente la table NTC et la conversion LDR sans autre changement.
+ *
+ * La tension n'etant fournie qu'au mV pres, la courbe est lissee sur
+ * ADC_CAL_SMOOTH codes voisins pour garder la resolution sub-LSB.
+ */
+
+#define ADC_CAL_FRAC 16       // Sous-divisions de LSB des codes corriges
+#define ADC_CAL_SMOOTH 9      // Largeur du lissage de la courbe (codes, impair)
+
+/** Caracterise l'ADC et remplit la table (sans effet si ADC_CALIBRATION = 0). */
+void adcCalBegin();
+
+/** Origine de la caracterisation : "efuse_tp", "efuse_vref", "default" ou "off". */
+const char* adcCalSource();
+
+#if ADC_CALIBRATION
+extern uint16_t adcCalTable[4096];
+
+/** Code corrige en 1/16 de LSB d'un echantillon brut 12 bits. */
+inline uint16_t adcCalQ4(uint16_t raw) {
+  return adcCalTable[raw & 0x0FFF];
+}
+#else
+inline uint16_t adcCalQ4(uint16_t raw) {
+  return (raw & 0x0FFF) * ADC_CAL_FRAC;
+}
+#endif
+
+/**
+ * Construit la table a partir des tensions `mv[raw]` (mV) : lissage centre
+ * sur ADC_CAL_SMOOTH codes puis conversion en code lineaire 1/16 LSB.
+ * `table` peut etre `mv` lui-meme. Sans dependance materielle.
+ */
+void adcCalBuild(uint16_t* table, const uint16_t* mv, uint32_t supplyMv);
+
+#endif
@@ -0,0 +1,37 @@
+#include "adc_cal.h"
+
+#define ADC_CODES 4096
+#define ADC_CAL_MAX_Q4 (4095 * ADC_CAL_FRAC)
+
+void adcCalBuild(uint16_t* table, const uint16_t* mv, uint32_t supplyMv) {
+  // Fenetre glissante sur les tensions d'origine : les ADC_CAL_SMOOTH / 2
+  // dernieres valeurs sont gardees a part, `table` pouvant ecraser `mv`
+  const int half = ADC_CAL_SMOOTH / 2;
+  uint16_t pending[ADC_CAL_SMOOTH / 2 + 1];
+  uint32_t sum = 0;
+  int count = 0;
+  for (int j = 0; j <= half && j < ADC_CODES; j++) {
+    sum += mv[j];
+    count++;
+  }
+  for (int i = 0; i < ADC_CODES; i++) {
+    uint16_t own = mv[i];
+    int add = i + half + 1;
+    // Code lineaire equivalent : V / Vcc * 4095, en 1/16 de LSB
+    uint64_t q = ((uint64_t)sum * ADC_CAL_MAX_Q4 + (uint64_t)count * supplyMv / 2) /
+                 ((uint64_t)count * supplyMv);
+    uint16_t out = q > ADC_CAL_MAX_Q4 ? ADC_CAL_MAX_Q4 : (uint16_t)q;
+    int drop = i - half;
+    uint16_t dropped = drop >= 0 ? pending[drop % (half + 1)] : 0;
+    if (add < ADC_CODES) {
+      sum += mv[add];
+      count++;
+    }
+    pending[i % (half + 1)] = own;
+    table[i] = out;
+    if (drop >= 0) {
+      sum -= dropped;
+      count--;
+    }
+  }
+}
@@ -0,0 +1,125 @@
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+
+/**
+ * Filtres incrementaux des echantillons ADC (codes 16 bits : bruts 0-4095
+ * ou corriges en 1/16 de LSB par adc_cal.h).
+ *
+ * Les echantillons d'une salve sont regroupes en blocs de W valeurs, tries
+ * par insertion au fil de l'eau dans un tampon fixe. Chaque bloc est reduit
+ * (mediane ou moyenne tronquee) et la salve vaut la moyenne des blocs,
+ * ponderee par leur taille : un pic isole (ADC ESP32, emission WiFi) ne
+ * deplace plus la valeur, sans tampon proportionnel a la salve.
+ *
+ * - ADC_FILTER_MEAN    : moyenne arithmetique (comportement historique)
+ * - ADC_FILTER_MEDIAN  : mediane de chaque bloc
+ * - ADC_FILTER_TRIMMED : moyenne de chaque bloc, trimPct % des valeurs
+ *                        ecartees de chaque cote (garde la resolution sub-LSB)
+ * - ADC_FILTER_IIR     : passe-bas du premier ordre y += alpha (x - y), dont
+ *                        l'etat est conserve d'une salve a l'autre
+ */
+enum AdcFilterKind : uint8_t {
+  ADC_FILTER_MEAN = 0,
+  ADC_FILTER_MEDIAN,
+  ADC_FILTER_TRIMMED,
+  ADC_FILTER_IIR,
+};
+
+template<uint8_t W>
+class SampleFilter {
+ public:
+  SampleFilter(AdcFilterKind kind, uint8_t trimPct, float iirAlpha)
+    : kind_(kind), trimPct_(trimPct), alpha_(iirAlpha) {}
+
+  /** Debut d'une salve (l'etat du filtre IIR est conserve). */
+  void begin() {
+    len_ = 0;
+    count_ = 0;
+    total_ = 0;
+    sum_ = 0.0f;
+  }
+
+  void add(uint16_t raw) {
+    count_++;
+    switch (kind_) {
+      case ADC_FILTER_MEAN:
+        total_ += raw;
+        break;
+      case ADC_FILTER_IIR:
+        iir_ = iirReady_ ? iir_ + alpha_ * ((float)raw - iir_) : (float)raw;
+        iirReady_ = true;
+        break;
+      default: {
+        // Insertion triee dans le bloc courant
+        uint8_t i = len_;
+        while (i > 0 && block_[i - 1] > raw) {
+          block_[i] = block_[i - 1];
+          i--;
+        }
+        block_[i] = raw;
+        if (++len_ == W) {
+          closeBlock();
+        }
+        break;
+      }
+    }
+  }
+
+  /** Nombre d'echantillons recus depuis begin(). */
+  uint32_t count() const { return count_; }
+
+  /** Valeur filtree de la salve (0 si aucun echantillon). */
+  float result() {
+    if (count_ == 0) {
+      return 0.0f;
+    }
+    switch (kind_) {
+      case ADC_FILTER_IIR:
+        return iir_;
+      case ADC_FILTER_MEAN:
+        return (float)((double)total_ / count_);
+      default:
+        if (len_ > 0) {
+          closeBlock();  // Dernier bloc incomplet, pondere par sa taille
+        }
+        return sum_ / count_;
+    }
+  }
+
+ private:
+  /** Reduit le bloc trie courant et l'ajoute a la somme ponderee. */
+  void closeBlock() {
+    float v;
+    if (kind_ == ADC_FILTER_MEDIAN) {
+      v = (len_ & 1) ? block_[len_ / 2]
+                     : (block_[len_ / 2 - 1] + block_[len_ / 2]) * 0.5f;
+    } else {
+      uint8_t k = (uint16_t)len_ * trimPct_ / 100;
+      if (2 * k >= len_) {
+        k = (len_ - 1) / 2;
+      }
+      uint32_t s = 0;
+      for (uint8_t i = k; i < len_ - k; i++) {
+        s += block_[i];
+      }
+      v = (float)s / (len_ - 2 * k);
+    }
+    sum_ += v * len_;
+    len_ = 0;
+  }
+
+  AdcFilterKind kind_;
+  uint8_t trimPct_;
+  float alpha_;
+  uint16_t block_[W];
+  uint8_t len_ = 0;
+  uint32_t count_ = 0;
+  uint32_t total_ = 0;       // Somme exacte (MEAN) : 65535 echantillons de 16 bits au plus
+  float sum_ = 0.0f;         // Somme ponderee des blocs
+  float iir_ = 0.0f;
+  bool iirReady_ = false;
+};
+
+#endif
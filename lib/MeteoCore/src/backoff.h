@@ -0,0 +1,45 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+/**
+ * Attente exponentielle plafonnee avec gigue ("equal jitter").
+ *
+ * La n-ieme tentative attend d = min(cap, base * 2^n), tire uniformement
+ * dans [d/2, d] : les stations d'un meme site ne se reconnectent pas toutes
+ * au meme instant apres une panne du broker. Sans etat dynamique ni
+ * dependance materielle (l'alea est fourni par l'appelant).
+ */
+class Backoff {
+ public:
+  Backoff(uint32_t baseMs, uint32_t capMs) : baseMs_(baseMs), capMs_(capMs) {}
+
+  /** Delai avant la prochaine tentative ; `rnd` est un entier aleatoire. */
+  uint32_t next(uint32_t rnd) {
+    uint32_t d = capMs_;
+    if (attempts_ < 31 && (baseMs_ << attempts_) >> attempts_ == baseMs_) {
+      uint32_t exp = baseMs_ << attempts_;
+      if (exp < capMs_) {
+        d = exp;
+      }
+    }
+    if (attempts_ < UINT16_MAX) {
+      attempts_++;
+    }
+    uint32_t half = d / 2;
+    return half + rnd % (d - half + 1);
+  }
+
+  /** A appeler apres une connexion reussie. */
+  void reset() { attempts_ = 0; }
+
+  uint16_t attempts() const { return attempts_; }
+
+ private:
+  uint32_t baseMs_;
+  uint32_t capMs_;
+  uint16_t attempts_ = 0;
+};
+
+#endif
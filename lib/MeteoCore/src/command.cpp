@@ -0,0 +1,91 @@
+#include <string.h>
+#include "command.h"
+
+/** Position de la valeur de la cle `key` (apres ':' et les espaces), nullptr si absente. */
+static const char* findValue(const char* json, size_t len, const char* key) {
+  size_t k = strlen(key);
+  const char* end = json + len;
+  for (const char* p = json; p + k + 2 <= end; p++) {
+    if (*p != '"' || memcmp(p + 1, key, k) != 0 || p[k + 1] != '"') {
+      continue;
+    }
+    p += k + 2;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+      p++;
+    }
+    if (p >= end || *p != ':') {
+      continue;
+    }
+    p++;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+      p++;
+    }
+    return p < end ? p : nullptr;
+  }
+  return nullptr;
+}
+
+/** Entier non signe 32 bits ; false si absent, non numerique ou hors plage. */
+static bool findUint(const char* json, size_t len, const char* key, uint32_t& out) {
+  const char* p = findValue(json, len, key);
+  const char* end = json + len;
+  if (p == nullptr || p >= end || *p < '0' || *p > '9') {
+    return false;
+  }
+  uint64_t v = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    v = v * 10 + (*p++ - '0');
+    if (v > UINT32_MAX) {
+      return false;
+    }
+  }
+  out = (uint32_t)v;
+  return true;
+}
+
+/** Chaine sans echappement, tronquee a `size` - 1 ; false si absente. */
+static bool findString(const char* json, size_t len, const char* key, char* out, size_t size) {
+  const char* p = findValue(json, len, key);
+  const char* end = json + len;
+  if (p == nullptr || *p != '"') {
+    return false;
+  }
+  p++;
+  size_t n = 0;
+  while (p < end && *p != '"') {
+    if (*p == '\\') {
+      return false;
+    }
+    if (n + 1 < size) {
+      out[n++] = *p;
+    }
+    p++;
+  }
+  out[n] = '\0';
+  return p < end;
+}
+
+bool parseCommand(const char* json, size_t len, Command& cmd) {
+  cmd = {};
+  char name[16];
+  if (!findString(json, len, "cmd", name, sizeof(name))) {
+    return false;
+  }
+  if (strcmp(name, "history") == 0) {
+    if (!findUint(json, len, "from", cmd.from)) {
+      return false;
+    }
+    if (!findUint(json, len, "to", cmd.to)) {
+      cmd.to = UINT32_MAX;
+    }
+    if (cmd.to < cmd.from) {
+      return false;
+    }
+    if (!findString(json, len, "id", cmd.id, sizeof(cmd.id))) {
+      cmd.id[0] = '\0';
+    }
+    cmd.type = CMD_HISTORY;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,31 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Commandes recues sur MQTT_CMD_TOPIC.
+ *
+ * Objet JSON plat, cles dans un ordre quelconque :
+ *   {"cmd":"history","from":1770561000,"to":1770600000,"id":"rattrapage-12"}
+ * `to` est facultatif (jusqu'au releve le plus recent), `id` aussi (repris
+ * dans la reponse pour associer les lots a la requete). Les autres cles
+ * sont ignorees. Aucune allocation.
+ */
+
+#define COMMAND_ID_MAX 23
+
+enum CommandType : uint8_t { CMD_INVALID, CMD_HISTORY };
+
+struct Command {
+  CommandType type;
+  uint32_t from;
+  uint32_t to;
+  char id[COMMAND_ID_MAX + 1];
+};
+
+/** Decode `json` (sans '\0' final). Retourne false si la commande est inconnue ou incomplete. */
+bool parseCommand(const char* json, size_t len, Command& cmd);
+
+#endif
@@ -0,0 +1,311 @@
+#include <type_traits>
+#include "compress.h"
+
+// --- LZSS ---
+
+namespace {
+
+struct BitWriter {
+  uint8_t* buf;
+  size_t len;
+  size_t pos = 0;
+  uint8_t used = 0;  // Bits occupes dans l'octet courant
+  bool overflow = false;
+
+  BitWriter(uint8_t* b, size_t l) : buf(b), len(l) {}
+
+  void put(uint32_t v, uint8_t bits) {
+    while (bits-- > 0) {
+      if (used == 0) {
+        if (pos >= len) {
+          overflow = true;
+          return;
+        }
+        buf[pos++] = 0;
+      }
+      if ((v >> bits) & 1) {
+        buf[pos - 1] |= 0x80 >> used;
+      }
+      used = (used + 1) & 7;
+    }
+  }
+};
+
+struct BitReader {
+  const uint8_t* buf;
+  size_t len;
+  size_t bit = 0;
+  bool overrun = false;
+
+  BitReader(const uint8_t* b, size_t l) : buf(b), len(l) {}
+
+  uint32_t get(uint8_t bits) {
+    uint32_t v = 0;
+    while (bits-- > 0) {
+      if (bit >= len * 8) {
+        overrun = true;
+        return 0;
+      }
+      v = (v << 1) | ((buf[bit >> 3] >> (7 - (bit & 7))) & 1);
+      bit++;
+    }
+    return v;
+  }
+};
+
+}  // namespace
+
+size_t lzssCompress(uint8_t* out, size_t outLen, const uint8_t* in, size_t inLen) {
+  const size_t window = 1u << LZSS_WINDOW_BITS;
+  BitWriter w(out, outLen);
+  size_t i = 0;
+  while (i < inLen && !w.overflow) {
+    size_t maxLen = inLen - i < LZSS_MAX_MATCH ? inLen - i : LZSS_MAX_MATCH;
+    size_t start = i > window ? i - window : 0;
+    size_t bestLen = 0;
+    size_t bestDist = 0;
+    // Du plus proche au plus lointain ; une copie peut chevaucher la position courante
+    for (size_t j = i; j-- > start && bestLen < maxLen;) {
+      size_t l = 0;
+      while (l < maxLen && in[j + l] == in[i + l]) {
+        l++;
+      }
+      if (l > bestLen) {
+        bestLen = l;
+        bestDist = i - j;
+      }
+    }
+    if (bestLen >= LZSS_MIN_MATCH) {
+      w.put(0, 1);
+      w.put(bestDist - 1, LZSS_WINDOW_BITS);
+      w.put(bestLen - LZSS_MIN_MATCH, LZSS_LENGTH_BITS);
+      i += bestLen;
+    } else {
+      w.put(1, 1);
+      w.put(in[i], 8);
+      i++;
+    }
+  }
+  return w.overflow ? 0 : w.pos;
+}
+
+size_t lzssDecompress(uint8_t* out, size_t outLen, const uint8_t* in, size_t inLen) {
+  BitReader r(in, inLen);
+  size_t o = 0;
+  while (o < outLen) {
+    if (r.get(1)) {
+      uint8_t b = r.get(8);
+      if (r.overrun) {
+        return 0;
+      }
+      out[o++] = b;
+      continue;
+    }
+    size_t dist = r.get(LZSS_WINDOW_BITS) + 1;
+    size_t l = r.get(LZSS_LENGTH_BITS) + LZSS_MIN_MATCH;
+    if (r.overrun || dist > o || l > outLen - o) {
+      return 0;
+    }
+    while (l-- > 0) {
+      out[o] = out[o - dist];
+      o++;
+    }
+  }
+  return o;
+}
+
+// --- Colonnes delta ---
+
+namespace {
+
+struct ByteWriter {
+  uint8_t* p;
+  const uint8_t* end;
+  bool overflow = false;
+
+  void varint(uint32_t v) {
+    do {
+      if (p >= end) {
+        overflow = true;
+        return;
+      }
+      uint8_t b = v & 0x7F;
+      v >>= 7;
+      *p++ = v ? (b | 0x80) : b;
+    } while (v);
+  }
+};
+
+struct ByteReader {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool overrun = false;
+
+  uint32_t varint() {
+    uint32_t v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+      if (p >= end) {
+        overrun = true;
+        return 0;
+      }
+      uint8_t b = *p++;
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) {
+        return v;
+      }
+    }
+    overrun = true;
+    return 0;
+  }
+};
+
+inline uint32_t zigzag(uint32_t delta) {
+  int32_t d = (int32_t)delta;
+  return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+inline uint32_t unzigzag(uint32_t z) {
+  return (z >> 1) ^ (0u - (z & 1));
+}
+
+/** Applique `f(champ)` a chaque champ de PackedReading, dans l'ordre des colonnes. */
+template <typename R, typename F>
+void forEachField(R& r, F f) {
+  f(r.seq);
+  f(r.epoch);
+  f(r.valid);
+  f(r.omitted);
+  f(r.intervalS);
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    f(r.centi[ch]);
+  }
+#if AGGREGATE_WINDOW > 0
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    f(r.stats[ch].min);
+    f(r.stats[ch].max);
+    f(r.stats[ch].stddev);
+    f(r.stats[ch].n);
+  }
+#endif
+}
+
+constexpr int fieldCount() {
+  return 5 + CH_COUNT + (AGGREGATE_WINDOW > 0 ? 4 * CH_COUNT : 0);
+}
+
+}  // namespace
+
+size_t columnarEncode(uint8_t* out, size_t len, const PackedReading* batch, uint16_t n) {
+  ByteWriter w{out, out + len};
+  for (int field = 0; field < fieldCount() && !w.overflow; field++) {
+    uint32_t prev = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      int k = 0;
+      forEachField(batch[i], [&](auto v) {
+        if (k++ == field) {
+          // Ecart modulo 2^32 : les champs signes donnent de petits ecarts
+          uint32_t cur = (uint32_t)v;
+          w.varint(zigzag(cur - prev));
+          prev = cur;
+        }
+      });
+    }
+  }
+  return w.overflow ? 0 : w.p - out;
+}
+
+bool columnarDecode(PackedReading* out, uint16_t n, const uint8_t* in, size_t len) {
+  ByteReader r{in, in + len};
+  for (uint16_t i = 0; i < n; i++) {
+    out[i] = {};
+  }
+  for (int field = 0; field < fieldCount(); field++) {
+    uint32_t prev = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      prev += unzigzag(r.varint());
+      int k = 0;
+      forEachField(out[i], [&](auto& v) {
+        if (k++ == field) {
+          v = (typename std::remove_reference<decltype(v)>::type)prev;
+        }
+      });
+    }
+  }
+  return !r.overrun && r.p == r.end;
+}
+
+// --- Message ---
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+size_t encodeCompressed(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                        uint16_t& count, uint8_t* scratch, size_t scratchLen) {
+  count = 0;
+  if (len <= COMPRESS_HEADER_SIZE) {
+    return 0;
+  }
+  uint16_t k = n < 255 ? n : 255;
+  while (k > 0) {
+    size_t cols = columnarEncode(scratch, scratchLen, batch, k);
+    if (cols > 0 && cols <= UINT16_MAX) {
+      uint8_t* data = buf + COMPRESS_HEADER_SIZE;
+      size_t room = len - COMPRESS_HEADER_SIZE;
+      // Incompressible : colonnes brutes si elles sont plus courtes
+      size_t z = lzssCompress(data, room, scratch, cols);
+      uint8_t method = COMPRESS_LZSS;
+      if (z == 0 || z >= cols) {
+        method = COMPRESS_STORED;
+        z = cols <= room ? cols : 0;
+        for (size_t i = 0; i < z; i++) {
+          data[i] = scratch[i];
+        }
+      }
+      if (z > 0) {
+        buf[0] = COMPRESS_VERSION;
+        buf[1] = sizeof(PackedReading);
+        buf[2] = (uint8_t)k;
+        buf[3] = method;
+        putU16(buf + 4, (uint16_t)cols);
+        count = k;
+        return COMPRESS_HEADER_SIZE + z;
+      }
+    }
+    k /= 2;
+  }
+  return 0;
+}
+
+bool decodeCompressed(const uint8_t* buf, size_t len, PackedReading* out, uint16_t max,
+                      uint16_t& count, uint8_t* scratch, size_t scratchLen) {
+  count = 0;
+  if (len < COMPRESS_HEADER_SIZE || buf[0] != COMPRESS_VERSION ||
+      buf[1] != sizeof(PackedReading) || buf[2] == 0 || buf[2] > max) {
+    return false;
+  }
+  uint16_t n = buf[2];
+  size_t cols = buf[4] | (size_t)buf[5] << 8;
+  const uint8_t* data = buf + COMPRESS_HEADER_SIZE;
+  size_t dataLen = len - COMPRESS_HEADER_SIZE;
+  if (cols > scratchLen) {
+    return false;
+  }
+  if (buf[3] == COMPRESS_LZSS) {
+    if (lzssDecompress(scratch, cols, data, dataLen) != cols) {
+      return false;
+    }
+  } else if (buf[3] == COMPRESS_STORED && dataLen == cols) {
+    for (size_t i = 0; i < cols; i++) {
+      scratch[i] = data[i];
+    }
+  } else {
+    return false;
+  }
+  if (!columnarDecode(out, n, scratch, cols)) {
+    return false;
+  }
+  count = n;
+  return true;
+}
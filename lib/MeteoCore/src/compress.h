@@ -0,0 +1,75 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Lots compresses pour le rejeu d'une longue coupure (MQTT_TOPIC/z).
+ *
+ * Deux etages, sans allocation :
+ *   1. colonnes delta : chaque champ de PackedReading (seq, epoch, valid,
+ *      omitted, intervalS, puis chaque canal, puis les resumes
+ *      d'AGGREGATE_WINDOW) est ecrit pour tout le lot, en ecart au releve
+ *      precedent (premier releve : ecart a 0), zigzag puis varint LEB128.
+ *      Une serie reguliere devient une suite de petits octets repetes ;
+ *   2. LZSS facon heatshrink : fenetre de 2^LZSS_WINDOW_BITS octets,
+ *      flux de bits MSB d'abord, 1 + 8 bits par litteral, ou 0 + distance
+ *      - 1 (LZSS_WINDOW_BITS) + longueur - LZSS_MIN_MATCH (LZSS_LENGTH_BITS)
+ *      par reference arriere. Le decodeur n'a besoin que de la fenetre.
+ *
+ * Message : version (u8 = 1), taille d'un releve (u8 = sizeof(PackedReading)),
+ * nombre de releves (u8), methode (u8 : 0 colonnes brutes, 1 LZSS),
+ * longueur des colonnes (u16 LE), puis les donnees.
+ *
+ * Entierement deterministe : reencoder les memes releves (retransmission
+ * QoS 1) redonne les memes octets.
+ */
+
+#define COMPRESS_VERSION      1
+#define COMPRESS_HEADER_SIZE  6
+#define COMPRESS_STORED       0
+#define COMPRESS_LZSS         1
+
+#define LZSS_WINDOW_BITS  8
+#define LZSS_LENGTH_BITS  4
+#define LZSS_MIN_MATCH    2
+#define LZSS_MAX_MATCH    (LZSS_MIN_MATCH + (1 << LZSS_LENGTH_BITS) - 1)
+
+/**
+ * Compresse `in` vers `out`. Retourne la longueur ecrite, 0 si `out` est
+ * trop petit.
+ */
+size_t lzssCompress(uint8_t* out, size_t outLen, const uint8_t* in, size_t inLen);
+
+/**
+ * Decompresse exactement `outLen` octets. Retourne `outLen`, 0 si le flux
+ * est tronque ou reference avant le debut.
+ */
+size_t lzssDecompress(uint8_t* out, size_t outLen, const uint8_t* in, size_t inLen);
+
+/** Colonnes delta de `n` releves. Retourne la longueur, 0 si `len` ne suffit pas. */
+size_t columnarEncode(uint8_t* out, size_t len, const PackedReading* batch, uint16_t n);
+
+/** Inverse de columnarEncode. Retourne false si les colonnes sont incompletes. */
+bool columnarDecode(PackedReading* out, uint16_t n, const uint8_t* in, size_t len);
+
+/**
+ * Encode au plus `n` releves (255 au plus) en message compresse. Les
+ * colonnes sont construites dans `scratch` ; si elles ou le message ne
+ * tiennent pas, le lot est reduit de moitie. `count` recoit le nombre de
+ * releves encodes. Retourne la longueur ecrite, 0 si rien ne tient.
+ */
+size_t encodeCompressed(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                        uint16_t& count, uint8_t* scratch, size_t scratchLen);
+
+/**
+ * Decode un message compresse dans `out` (au plus `max` releves), en se
+ * servant de `scratch` pour les colonnes. Retourne false si le message est
+ * invalide ou d'un autre format de releve.
+ */
+bool decodeCompressed(const uint8_t* buf, size_t len, PackedReading* out, uint16_t max,
+                      uint16_t& count, uint8_t* scratch, size_t scratchLen);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Publication par exception : un canal n'est publie que s'il s'ecarte de sa
+ * derniere valeur publiee d'au moins sa bande morte (en centiemes), ou si sa
+ * validite change. Un releve complet est force pour garder la station
+ * visible des que la somme des `step` depuis le dernier releve complet
+ * atteint `heartbeat` : un releve par pas (cadence fixe), ou la duree ecoulee
+ * depuis le releve precedent (cadence adaptative).
+ *
+ * La reference est la derniere valeur publiee (et non le releve precedent) :
+ * une derive lente finit toujours par franchir la bande.
+ *
+ * Etat POD sans constructeur : peut etre place en memoire RTC (deep sleep).
+ */
+struct DeadbandState {
+  uint8_t primed;              // 0 tant qu'aucun releve n'a ete publie
+  uint8_t valid;               // Validite publiee par canal
+  int16_t centi[CH_COUNT];     // Derniere valeur publiee par canal
+  uint32_t sinceFull;          // Pas cumules depuis le dernier releve complet
+};
+
+/**
+ * Renseigne `r.omitted` avec les canaux inchanges.
+ * Retourne false si aucun canal n'a change (releve a ne pas publier).
+ */
+inline bool deadbandApply(DeadbandState& st, Reading& r, const int16_t band[CH_COUNT],
+                          uint32_t heartbeat, uint32_t step = 1) {
+  st.sinceFull += step;
+  bool full = !st.primed || st.sinceFull >= heartbeat;
+  r.omitted = 0;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    uint8_t bit = 1u << ch;
+    int16_t c = readingCenti(r, (Channel)ch);
+    bool changed;
+    if ((r.valid ^ st.valid) & bit) {
+      changed = true;
+    } else if (r.valid & bit) {
+      int32_t delta = (int32_t)c - st.centi[ch];
+      changed = (delta < 0 ? -delta : delta) >= band[ch];
+    } else {
+      changed = false;  // Toujours invalide
+    }
+    if (changed || full) {
+      st.centi[ch] = c;
+    } else {
+      r.omitted |= bit;
+    }
+  }
+  st.valid = r.valid;
+  if (full) {
+    st.primed = 1;
+    st.sinceFull = 0;
+    return true;
+  }
+  return r.omitted != (1u << CH_COUNT) - 1;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "dht_decoder.h"
+
+DhtStatus dhtDecodeFrame(const DhtPulse* pulses, size_t n, uint8_t data[5]) {
+  // Compte des niveaux hauts utiles (hors repos final)
+  size_t highs = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (pulses[i].level && pulses[i].us > 0) {
+      highs++;
+    }
+  }
+  if (highs == 0) {
+    return DHT_ERR_TIMEOUT;
+  }
+  if (highs < DHT_FRAME_BITS) {
+    return DHT_ERR_FRAME;
+  }
+
+  for (int i = 0; i < 5; i++) {
+    data[i] = 0;
+  }
+  size_t skip = highs - DHT_FRAME_BITS;
+  size_t bit = 0;
+  for (size_t i = 0; i < n && bit < DHT_FRAME_BITS; i++) {
+    if (!pulses[i].level || pulses[i].us == 0) {
+      continue;
+    }
+    if (skip > 0) {
+      skip--;
+      continue;
+    }
+    if (pulses[i].us > DHT_BIT_MAX_US) {
+      return DHT_ERR_FRAME;
+    }
+    data[bit / 8] <<= 1;
+    if (pulses[i].us > DHT_BIT_ONE_US) {
+      data[bit / 8] |= 1;
+    }
+    bit++;
+  }
+
+  uint8_t sum = data[0] + data[1] + data[2] + data[3];
+  return sum == data[4] ? DHT_OK : DHT_ERR_CHECKSUM;
+}
+
+void dhtConvert(const uint8_t data[5], uint8_t type, float& temp, float& hum) {
+  if (type == DHT11) {
+    // Partie decimale sur 4 bits, bit 7 : temperature negative (comme DHT.cpp)
+    hum = data[0] + data[1] * 0.1f;
+    temp = data[2];
+    if (data[3] & 0x80) {
+      temp = -1 - temp;
+    }
+    temp += (data[3] & 0x0F) * 0.1f;
+  } else {
+    hum = ((data[0] << 8) | data[1]) * 0.1f;
+    temp = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+    if (data[2] & 0x80) {
+      temp = -temp;
+    }
+  }
+}
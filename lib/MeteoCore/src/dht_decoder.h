@@ -0,0 +1,50 @@
+#ifndef DHT_DECODER_H
+#define DHT_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Decodage d'une trame DHT11/DHT22 a partir des durees de niveaux capturees
+ * (RMT ou interruptions GPIO), sans dependance materielle.
+ *
+ * Trame : reponse du capteur (80 us bas, 80 us haut) puis 40 bits, chacun
+ * 50 us bas suivi d'un niveau haut de 26-28 us (0) ou 70 us (1).
+ * Octets : humidite (2), temperature (2), somme de controle.
+ */
+
+// Memes valeurs que la bibliotheque Adafruit (DHT.h)
+#ifndef DHT11
+#define DHT11 11
+#endif
+#ifndef DHT22
+#define DHT22 22
+#endif
+
+#define DHT_FRAME_BITS  40
+#define DHT_BIT_ONE_US  50    // Niveau haut plus long : bit a 1
+#define DHT_BIT_MAX_US  100   // Niveau haut plus long : trame invalide
+
+enum DhtStatus : uint8_t {
+  DHT_OK = 0,
+  DHT_ERR_TIMEOUT,     // Aucune reponse du capteur
+  DHT_ERR_FRAME,       // Trame incomplete ou durees hors tolerance
+  DHT_ERR_CHECKSUM,    // Somme de controle fausse
+};
+
+/** Segment de niveau constant, dans l'ordre de capture. */
+struct DhtPulse {
+  uint8_t level;
+  uint16_t us;         // 0 : fin de capture (ligne au repos)
+};
+
+/**
+ * Extrait les 5 octets de la trame : les 40 derniers niveaux hauts sont les
+ * bits (ceux qui precedent sont la liberation de la ligne et la reponse).
+ */
+DhtStatus dhtDecodeFrame(const DhtPulse* pulses, size_t n, uint8_t data[5]);
+
+/** Convertit les octets d'une trame valide en C et % (type DHT11 ou DHT22). */
+void dhtConvert(const uint8_t data[5], uint8_t type, float& temp, float& hum);
+
+#endif
@@ -0,0 +1,128 @@
+#include "encoder.h"
+
+// Taille maximale d'un releve CBOR : tableau (1) + epoch u32 (5) + 4 x int16 (3)
+#define CBOR_RECORD_MAX (1 + 5 + 3 * CH_COUNT)
+// En-tete CBOR : tableau(2) + version + tableau(count <= 65535)
+#define CBOR_HEADER_MAX (1 + 1 + 3)
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+size_t encodeBinary(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                    uint16_t& count) {
+  count = 0;
+  if (len < BINARY_HEADER_SIZE + BINARY_RECORD_SIZE || n == 0) {
+    return 0;
+  }
+#if REPORT_BY_EXCEPTION
+  // Releves de taille variable : on encode tant qu'un releve complet tient
+  uint8_t* p = buf + BINARY_HEADER_SIZE;
+  const uint8_t* end = buf + len;
+  while (count < n && count < 255 && end - p >= BINARY_RECORD_SIZE) {
+    const PackedReading& r = batch[count];
+    uint8_t present = ~r.omitted & ((1u << CH_COUNT) - 1);
+    putU32(p, r.epoch);
+    p += 4;
+    *p++ = r.valid;
+    *p++ = present;
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      if ((present & r.valid) & (1u << ch)) {
+        putU16(p, (uint16_t)r.centi[ch]);
+        p += 2;
+      }
+    }
+    count++;
+  }
+  buf[0] = BINARY_VERSION;
+  buf[1] = (uint8_t)count;
+#else
+  size_t fit = (len - BINARY_HEADER_SIZE) / BINARY_RECORD_SIZE;
+  count = n < fit ? n : fit;
+  if (count > 255) {
+    count = 255;
+  }
+
+  uint8_t* p = buf;
+  *p++ = BINARY_VERSION;
+  *p++ = (uint8_t)count;
+  for (uint16_t i = 0; i < count; i++) {
+    const PackedReading& r = batch[i];
+    putU32(p, r.epoch);
+    p += 4;
+    *p++ = r.valid;
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      putU16(p, (uint16_t)r.centi[ch]);
+      p += 2;
+    }
+  }
+#endif
+  return p - buf;
+}
+
+/**
+ * Ecrit un en-tete CBOR (type majeur + argument) sous sa forme la plus courte.
+ */
+static uint8_t* cborHead(uint8_t* p, uint8_t major, uint32_t arg) {
+  major <<= 5;
+  if (arg < 24) {
+    *p++ = major | arg;
+  } else if (arg <= 0xFF) {
+    *p++ = major | 24;
+    *p++ = arg;
+  } else if (arg <= 0xFFFF) {
+    *p++ = major | 25;
+    *p++ = arg >> 8;
+    *p++ = arg & 0xFF;
+  } else {
+    *p++ = major | 26;
+    *p++ = arg >> 24;
+    *p++ = (arg >> 16) & 0xFF;
+    *p++ = (arg >> 8) & 0xFF;
+    *p++ = arg & 0xFF;
+  }
+  return p;
+}
+
+static uint8_t* cborInt(uint8_t* p, int32_t v) {
+  // Entier negatif : type majeur 1, argument -1 - v
+  return v >= 0 ? cborHead(p, 0, v) : cborHead(p, 1, (uint32_t)(-1 - v));
+}
+
+size_t encodeCbor(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                  uint16_t& count) {
+  count = 0;
+  if (len < CBOR_HEADER_MAX + CBOR_RECORD_MAX || n == 0) {
+    return 0;
+  }
+  size_t fit = (len - CBOR_HEADER_MAX) / CBOR_RECORD_MAX;
+  count = n < fit ? n : fit;
+
+  uint8_t* p = buf;
+  p = cborHead(p, 4, 2);             // [version, releves]
+  p = cborInt(p, CBOR_VERSION);
+  p = cborHead(p, 4, count);
+  for (uint16_t i = 0; i < count; i++) {
+    const PackedReading& r = batch[i];
+    p = cborHead(p, 4, 1 + CH_COUNT);
+    p = cborHead(p, 0, r.epoch);
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      if ((r.omitted >> ch) & 1) {
+        *p++ = 0xF7;                 // undefined : inchange
+      } else if ((r.valid >> ch) & 1) {
+        p = cborInt(p, r.centi[ch]);
+      } else {
+        *p++ = 0xF6;                 // null
+      }
+    }
+  }
+  return p - buf;
+}
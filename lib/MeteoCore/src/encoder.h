@@ -0,0 +1,57 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Encodeurs binaires des releves, alternatives compactes au JSON.
+ *
+ * Format BINARY v1 (little-endian), publie sur MQTT_TOPIC/bin :
+ *   en-tete  : version (u8 = 1), nombre de releves (u8)
+ *   releve   : epoch (u32, 0 si inconnu), masque de validite (u8),
+ *              puis un int16 par canal en centiemes (ordre de l'enum Channel)
+ *   => 2 + 13 octets par releve.
+ *
+ * Format BINARY v2 (REPORT_BY_EXCEPTION), meme en-tete (version = 2) :
+ *   releve   : epoch (u32), masque de validite (u8), masque des canaux
+ *              presents (u8), puis un int16 par canal present et valide
+ *   => 6 a 14 octets par releve ; un canal absent est inchange.
+ *
+ * Format CBOR (RFC 8949), publie sur MQTT_TOPIC/cbor :
+ *   [1, [[epoch, c0, c1, c2, c3], ...]]
+ *   avec ci entier en centiemes ou null si le canal est invalide.
+ *   Version 2 (REPORT_BY_EXCEPTION) : undefined pour un canal inchange.
+ */
+
+#include "config.h"
+
+#define BINARY_HEADER_SIZE  2
+#if REPORT_BY_EXCEPTION
+#define BINARY_VERSION      2
+#define BINARY_RECORD_SIZE  (4 + 1 + 1 + 2 * CH_COUNT)  // Taille maximale
+#define CBOR_VERSION        2
+#else
+#define BINARY_VERSION      1
+#define BINARY_RECORD_SIZE  (4 + 1 + 2 * CH_COUNT)
+#define CBOR_VERSION        1
+#endif
+
+/**
+ * Encode au plus `n` releves au format BINARY_VERSION (limite a 255 et a la
+ * place disponible). `count` recoit le nombre de releves encodes.
+ * Retourne la longueur ecrite, 0 si rien n'a pu etre encode.
+ */
+size_t encodeBinary(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                    uint16_t& count);
+
+/**
+ * Encode au plus `n` releves au format CBOR (limite a la place disponible).
+ * `count` recoit le nombre de releves encodes.
+ * Retourne la longueur ecrite, 0 si rien n'a pu etre encode.
+ */
+size_t encodeCbor(uint8_t* buf, size_t len, const PackedReading* batch, uint16_t n,
+                  uint16_t& count);
+
+#endif
@@ -0,0 +1,127 @@
+#include <string.h>
+#include "espnow_frame.h"
+
+static uint8_t* header(uint8_t* p, uint8_t type) {
+  *p++ = ESPNOW_MAGIC;
+  *p++ = ESPNOW_VERSION;
+  *p++ = type;
+  return p;
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+  *p++ = v & 0xFF;
+  *p++ = v >> 8;
+  return p;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t v) {
+  p = putU16(p, v & 0xFFFF);
+  return putU16(p, v >> 16);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return getU16(p) | (uint32_t)getU16(p + 2) << 16;
+}
+
+uint8_t espnowFrameType(const uint8_t* buf, size_t len) {
+  if (len < 3 || buf[0] != ESPNOW_MAGIC || buf[1] != ESPNOW_VERSION) {
+    return 0;
+  }
+  return buf[2];
+}
+
+size_t espnowEncodeReadings(uint8_t* buf, size_t len, uint16_t frameSeq, uint32_t clock,
+                            const char* device, const PackedReading* batch, uint16_t n,
+                            uint16_t& count) {
+  count = 0;
+  size_t nameLen = strlen(device);
+  if (nameLen == 0 || nameLen > ESPNOW_DEVICE_MAX) {
+    return 0;
+  }
+  if (len > ESPNOW_FRAME_MAX) {
+    len = ESPNOW_FRAME_MAX;
+  }
+  size_t head = ESPNOW_READINGS_HEAD + nameLen;
+  if (len < head + sizeof(PackedReading)) {
+    return 0;
+  }
+  size_t fit = (len - head) / sizeof(PackedReading);
+  uint16_t k = n < fit ? n : fit;
+  if (k == 0) {
+    return 0;
+  }
+  uint8_t* p = header(buf, ESPNOW_READINGS);
+  p = putU16(p, frameSeq);
+  p = putU32(p, clock);
+  *p++ = sizeof(PackedReading);
+  *p++ = nameLen;
+  memcpy(p, device, nameLen);
+  p += nameLen;
+  *p++ = k;
+  memcpy(p, batch, k * sizeof(PackedReading));
+  p += k * sizeof(PackedReading);
+  count = k;
+  return p - buf;
+}
+
+void espnowSetClock(uint8_t* buf, size_t len, uint32_t clock) {
+  if (espnowFrameType(buf, len) == ESPNOW_READINGS && len >= ESPNOW_READINGS_HEAD) {
+    putU32(buf + 5, clock);
+  }
+}
+
+bool espnowDecodeReadings(const uint8_t* buf, size_t len, uint16_t& frameSeq, uint32_t& clock,
+                          char* device, PackedReading* out, uint16_t max, uint16_t& count) {
+  count = 0;
+  if (espnowFrameType(buf, len) != ESPNOW_READINGS || len < ESPNOW_READINGS_HEAD) {
+    return false;
+  }
+  const uint8_t* p = buf + 3;
+  frameSeq = getU16(p);
+  clock = getU32(p + 2);
+  p += 6;
+  if (*p++ != sizeof(PackedReading)) {
+    return false;
+  }
+  size_t nameLen = *p++;
+  if (nameLen == 0 || nameLen > ESPNOW_DEVICE_MAX || len < ESPNOW_READINGS_HEAD + nameLen) {
+    return false;
+  }
+  memcpy(device, p, nameLen);
+  device[nameLen] = '\0';
+  p += nameLen;
+  uint8_t k = *p++;
+  if (k == 0 || k > max || (size_t)(buf + len - p) != k * sizeof(PackedReading)) {
+    return false;
+  }
+  memcpy(out, p, k * sizeof(PackedReading));
+  count = k;
+  return true;
+}
+
+size_t espnowEncodeAck(uint8_t* buf, size_t len, uint16_t frameSeq, uint32_t epoch,
+                       bool accepted) {
+  if (len < ESPNOW_ACK_SIZE) {
+    return 0;
+  }
+  uint8_t* p = header(buf, ESPNOW_ACK);
+  p = putU16(p, frameSeq);
+  p = putU32(p, epoch);
+  *p++ = accepted ? 1 : 0;
+  return p - buf;
+}
+
+bool espnowDecodeAck(const uint8_t* buf, size_t len, uint16_t& frameSeq, uint32_t& epoch,
+                     bool& accepted) {
+  if (espnowFrameType(buf, len) != ESPNOW_ACK || len != ESPNOW_ACK_SIZE) {
+    return false;
+  }
+  frameSeq = getU16(buf + 3);
+  epoch = getU32(buf + 5);
+  accepted = buf[9] != 0;
+  return true;
+}
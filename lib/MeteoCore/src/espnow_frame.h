@@ -0,0 +1,72 @@
+#ifndef ESPNOW_FRAME_H
+#define ESPNOW_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Trames ESP-NOW entre stations feuilles et passerelle (250 octets max).
+ *
+ * En-tete commun : magic (u8 = 0x4D), version (u8 = 2), type (u8).
+ *
+ * ESPNOW_READINGS (feuille -> passerelle) :
+ *   numero de trame (u16), horloge monotone de la feuille a l'envoi (u32,
+ *   horodatage relatif, timebase.h), taille d'un releve (u8),
+ *   longueur du nom (u8), nom de la feuille (MQTT_DEVICE, sans '\0'),
+ *   nombre de releves (u8), puis les PackedReading bruts.
+ *   La taille d'un releve verifie que feuille et passerelle partagent le
+ *   meme format (AGGREGATE_WINDOW). Une feuille sans heure envoie des
+ *   horodatages relatifs : la passerelle les convertit par rapport a
+ *   l'horloge de la trame (epochFromPeer).
+ *
+ * ESPNOW_ACK (passerelle -> feuille) :
+ *   numero de la trame acquittee (u16), heure UNIX de la passerelle (u32,
+ *   0 si inconnue), accepte (u8, 0 si la file de relais est pleine).
+ *
+ * Entiers little-endian (ESP32 des deux cotes). Aucune dependance materielle.
+ */
+
+#define ESPNOW_MAGIC          0x4D
+#define ESPNOW_VERSION        2
+#define ESPNOW_READINGS       0x01
+#define ESPNOW_ACK            0x02
+#define ESPNOW_FRAME_MAX      250    // ESP_NOW_MAX_DATA_LEN
+#define ESPNOW_DEVICE_MAX     31     // Longueur max du nom d'une feuille
+#define ESPNOW_READINGS_HEAD  (3 + 2 + 4 + 1 + 1 + 1)  // Hors nom
+#define ESPNOW_ACK_SIZE       (3 + 2 + 4 + 1)
+
+/** Releves au plus par trame (nom d'un caractere). */
+#define ESPNOW_FRAME_READINGS \
+  ((ESPNOW_FRAME_MAX - ESPNOW_READINGS_HEAD - 1) / sizeof(PackedReading))
+
+/** Type de la trame (ESPNOW_READINGS, ESPNOW_ACK), 0 si en-tete invalide. */
+uint8_t espnowFrameType(const uint8_t* buf, size_t len);
+
+/**
+ * Encode autant de releves de `batch` que la trame le permet (au plus `n`).
+ * `count` recoit le nombre de releves encodes.
+ * Retourne la longueur ecrite, 0 si le nom est trop long ou rien ne tient.
+ */
+size_t espnowEncodeReadings(uint8_t* buf, size_t len, uint16_t frameSeq, uint32_t clock,
+                            const char* device, const PackedReading* batch, uint16_t n,
+                            uint16_t& count);
+
+/** Met a jour l'horloge d'une trame ESPNOW_READINGS avant un renvoi. */
+void espnowSetClock(uint8_t* buf, size_t len, uint32_t clock);
+
+/**
+ * Decode une trame ESPNOW_READINGS. `device` recoit le nom termine par
+ * '\0' (ESPNOW_DEVICE_MAX + 1 octets), `out` au plus `max` releves.
+ * Retourne false si la trame est tronquee, d'un autre format ou vide.
+ */
+bool espnowDecodeReadings(const uint8_t* buf, size_t len, uint16_t& frameSeq, uint32_t& clock,
+                          char* device, PackedReading* out, uint16_t max, uint16_t& count);
+
+size_t espnowEncodeAck(uint8_t* buf, size_t len, uint16_t frameSeq, uint32_t epoch,
+                       bool accepted);
+
+bool espnowDecodeAck(const uint8_t* buf, size_t len, uint16_t& frameSeq, uint32_t& epoch,
+                     bool& accepted);
+
+#endif
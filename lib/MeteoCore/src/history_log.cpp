@@ -0,0 +1,262 @@
+#include <string.h>
+#include "history_log.h"
+
+namespace {
+
+struct SectorHeader {
+  uint32_t magic;
+  uint32_t gen;
+  uint32_t genInv;       // ~gen : en-tete ecrit entierement
+  uint16_t recordSize;
+  uint16_t reserved;
+};
+static_assert(sizeof(SectorHeader) == HISTORY_HEADER_SIZE, "En-tete de secteur de 16 octets");
+
+/** CRC-16/CCITT-FALSE. */
+uint16_t crc16(const uint8_t* p, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len-- > 0) {
+    crc ^= (uint16_t)*p++ << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+bool erased(const uint8_t* p, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (p[i] != 0xFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool HistoryLog::sectorGen(uint16_t s, uint32_t& gen) const {
+  SectorHeader h;
+  memcpy(&h, sectorData(s), sizeof(h));
+  if (h.magic != HISTORY_MAGIC || h.genInv != ~h.gen || h.recordSize != HISTORY_RECORD_SIZE) {
+    return false;
+  }
+  gen = h.gen;
+  return true;
+}
+
+uint16_t HistoryLog::usedSlots(uint16_t s) const {
+  for (uint16_t i = 0; i < HISTORY_SLOTS; i++) {
+    if (erased(slotData(s, i), HISTORY_RECORD_SIZE)) {
+      return i;
+    }
+  }
+  return HISTORY_SLOTS;
+}
+
+bool HistoryLog::recordAt(uint16_t s, uint16_t i, PackedReading& out) const {
+  const uint8_t* p = slotData(s, i);
+  uint16_t crc = p[sizeof(PackedReading)] | (uint16_t)p[sizeof(PackedReading) + 1] << 8;
+  if (crc != crc16(p, sizeof(PackedReading)) || erased(p, HISTORY_RECORD_SIZE)) {
+    return false;
+  }
+  memcpy(&out, p, sizeof(out));
+  return true;
+}
+
+bool HistoryLog::begin() {
+  sectors_ = flash_.size() / HISTORY_SECTOR_SIZE;
+  head_ = -1;
+  headSlot_ = 0;
+  headGen_ = 0;
+  records_ = 0;
+  newest_ = 0;
+  corrupt_ = 0;
+  if (sectors_ < 2) {
+    sectors_ = 0;
+    return false;
+  }
+  uint32_t valid = 0;
+  for (uint16_t s = 0; s < sectors_; s++) {
+    uint32_t gen;
+    if (!sectorGen(s, gen)) {
+      continue;
+    }
+    valid++;
+    if (head_ < 0 || gen > headGen_) {
+      head_ = s;
+      headGen_ = gen;
+    }
+  }
+  if (head_ < 0) {
+    return true;  // Partition neuve ou d'un autre format
+  }
+  headSlot_ = usedSlots(head_);
+  // Secteurs scelles supposes pleins ; le courant est compte exactement
+  records_ = (valid - 1) * HISTORY_SLOTS + headSlot_;
+  PackedReading r;
+  for (uint16_t i = 0; i < headSlot_; i++) {
+    if (recordAt(head_, i, r)) {
+      newest_ = r.epoch;
+    } else {
+      corrupt_++;  // Ecriture interrompue par un redemarrage
+    }
+  }
+  if (newest_ == 0) {
+    // Secteur courant sans releve : dernier du secteur precedent
+    uint16_t prev = (head_ + sectors_ - 1) % sectors_;
+    uint32_t gen;
+    for (uint16_t i = HISTORY_SLOTS; i-- > 0 && sectorGen(prev, gen) && gen < headGen_;) {
+      if (recordAt(prev, i, r)) {
+        newest_ = r.epoch;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool HistoryLog::openNextSector() {
+  uint16_t next = head_ < 0 ? 0 : (head_ + 1) % sectors_;
+  uint32_t gen;
+  bool recycled = sectorGen(next, gen);
+  if (!flash_.erase((uint32_t)next * HISTORY_SECTOR_SIZE)) {
+    flashErrors_++;
+    return false;  // Secteur intact : rien n'est decompte
+  }
+  erases_++;
+  if (recycled && records_ >= HISTORY_SLOTS) {
+    records_ -= HISTORY_SLOTS;  // Bloc le plus ancien recycle
+  }
+  SectorHeader h = {HISTORY_MAGIC, headGen_ + 1, ~(headGen_ + 1), HISTORY_RECORD_SIZE, 0xFFFF};
+  if (!flash_.write((uint32_t)next * HISTORY_SECTOR_SIZE, &h, sizeof(h))) {
+    flashErrors_++;
+    return false;
+  }
+  head_ = next;
+  headGen_++;
+  headSlot_ = 0;
+  return true;
+}
+
+bool HistoryLog::append(const PackedReading& r) {
+  if (sectors_ == 0) {
+    return false;
+  }
+  if ((head_ < 0 || headSlot_ >= HISTORY_SLOTS) && !openNextSector()) {
+    return false;
+  }
+  uint8_t rec[HISTORY_RECORD_SIZE];
+  memcpy(rec, &r, sizeof(r));
+  uint16_t crc = crc16(rec, sizeof(r));
+  rec[sizeof(r)] = crc & 0xFF;
+  rec[sizeof(r) + 1] = crc >> 8;
+  rec[sizeof(r) + 2] = 0;  // Jamais tout a 0xFF
+  rec[sizeof(r) + 3] = 0;
+  uint32_t offset = (uint32_t)(slotData(head_, headSlot_) - flash_.data());
+  // Emplacement consomme meme en cas d'echec : il n'est jamais reecrit sans effacement
+  headSlot_++;
+  if (!flash_.write(offset, rec, sizeof(rec))) {
+    flashErrors_++;
+    return false;
+  }
+  records_++;
+  newest_ = r.epoch;
+  return true;
+}
+
+int32_t HistoryLog::oldestSector() const {
+  if (head_ < 0) {
+    return -1;
+  }
+  uint32_t gen;
+  for (uint16_t i = 1; i <= sectors_; i++) {
+    uint16_t s = (head_ + i) % sectors_;
+    if (sectorGen(s, gen)) {
+      return s;
+    }
+  }
+  return -1;
+}
+
+uint32_t HistoryLog::oldestEpoch() const {
+  int32_t s = oldestSector();
+  PackedReading r;
+  for (uint16_t i = 0; s >= 0 && i < HISTORY_SLOTS; i++) {
+    if (recordAt(s, i, r)) {
+      return r.epoch;
+    }
+  }
+  return 0;
+}
+
+HistoryCursor HistoryLog::seek(uint32_t from) const {
+  HistoryCursor c = {0, 0, 0, true};
+  int32_t start = oldestSector();
+  if (start < 0) {
+    return c;
+  }
+  c.sector = start;
+  c.done = false;
+  sectorGen(start, c.gen);
+  // Dernier bloc commencant au plus tard a `from`, dans l'ordre du journal
+  PackedReading first;
+  for (uint16_t i = 0; i < sectors_; i++) {
+    uint16_t s = (start + i) % sectors_;
+    uint32_t gen;
+    if (sectorGen(s, gen) && recordAt(s, 0, first)) {
+      if (first.epoch > from) {
+        break;
+      }
+      c.sector = s;
+      c.gen = gen;
+    }
+    if (s == head_) {
+      break;
+    }
+  }
+  return c;
+}
+
+uint16_t HistoryLog::read(HistoryCursor& c, uint32_t from, uint32_t to, PackedReading* out,
+                          uint16_t max) const {
+  uint16_t n = 0;
+  while (!c.done && n < max) {
+    uint32_t gen;
+    if (!sectorGen(c.sector, gen) || gen != c.gen) {
+      // Secteur recycle depuis l'appel precedent : les releves suivants sont perdus
+      int32_t s = oldestSector();
+      if (s < 0 || !sectorGen(s, c.gen)) {
+        c.done = true;
+        break;
+      }
+      c.sector = s;
+      c.slot = 0;
+      continue;
+    }
+    bool current = c.sector == head_;
+    if (c.slot >= (current ? headSlot_ : HISTORY_SLOTS)) {
+      uint16_t next = (c.sector + 1) % sectors_;
+      if (current || !sectorGen(next, gen) || gen <= c.gen) {
+        c.done = true;
+        break;
+      }
+      c.sector = next;
+      c.slot = 0;
+      c.gen = gen;
+      continue;
+    }
+    PackedReading r;
+    if (recordAt(c.sector, c.slot, r)) {
+      if (c.slot == 0 && r.epoch > to) {
+        c.done = true;  // Bloc entierement apres la fin de la plage
+        break;
+      }
+      if (r.epoch >= from && r.epoch <= to) {
+        out[n++] = r;
+      }
+    }
+    c.slot++;
+  }
+  return n;
+}
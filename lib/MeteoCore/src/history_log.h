@@ -0,0 +1,126 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Historique des releves sur une partition flash dediee : journal circulaire
+ * d'enregistrements de taille fixe, en ajout seul.
+ *
+ * La partition est decoupee en secteurs de HISTORY_SECTOR_SIZE (unite
+ * d'effacement). Chaque secteur commence par un en-tete de 16 octets :
+ * magic (u32), generation (u32, croissante), ~generation (u32), taille
+ * d'un enregistrement (u16), reserve (u16). Suivent des enregistrements
+ * PackedReading + CRC-16 (u16) + 0 (u16) ; un emplacement tout a 0xFF est
+ * libre, un CRC faux signale une ecriture interrompue (ignoree).
+ *
+ * Usure : un secteur n'est efface qu'au moment ou le journal le reutilise,
+ * un tour complet plus tard, et aucun octet n'est reecrit entre deux
+ * effacements (ni index ni compteur en place). Toute la partition s'use
+ * au meme rythme.
+ *
+ * Index : chaque secteur couvre un bloc de temps, commencant a l'epoch de
+ * son premier enregistrement. Une requete choisit le bloc de depart sur
+ * ces seuls premiers enregistrements, puis parcourt les enregistrements
+ * en place dans la projection memoire de la partition (lecture sans
+ * copie) ; seuls les releves retenus sont copies.
+ *
+ * Au demarrage, la generation la plus haute designe le secteur en cours
+ * d'ecriture et le premier emplacement libre la position d'ajout. Les
+ * secteurs d'un autre format (AGGREGATE_WINDOW change) sont reutilises
+ * comme s'ils etaient vides.
+ *
+ * Sans dependance materielle : l'acces a la flash passe par HistoryFlash.
+ */
+
+#define HISTORY_SECTOR_SIZE   4096
+#define HISTORY_HEADER_SIZE   16
+#define HISTORY_MAGIC         0x3153484Du  // "MHS1"
+#define HISTORY_RECORD_SIZE   (sizeof(PackedReading) + 4)
+#define HISTORY_SLOTS \
+  ((HISTORY_SECTOR_SIZE - HISTORY_HEADER_SIZE) / HISTORY_RECORD_SIZE)
+
+/** Acces a la partition : lecture par projection memoire, ecriture et effacement par secteur. */
+class HistoryFlash {
+ public:
+  /** Partition entiere projetee en memoire (esp_partition_mmap). */
+  virtual const uint8_t* data() const = 0;
+  virtual uint32_t size() const = 0;
+  /** Efface le secteur a `offset` (multiple de HISTORY_SECTOR_SIZE). */
+  virtual bool erase(uint32_t offset) = 0;
+  virtual bool write(uint32_t offset, const void* src, uint32_t len) = 0;
+};
+
+/** Position de lecture d'une requete, invalidee si son secteur est recycle. */
+struct HistoryCursor {
+  uint16_t sector;
+  uint16_t slot;
+  uint32_t gen;
+  bool done;
+};
+
+class HistoryLog {
+ public:
+  explicit HistoryLog(HistoryFlash& flash) : flash_(flash) {}
+
+  /** Relit les en-tetes et retrouve la position d'ajout. Retourne false si la partition est trop petite. */
+  bool begin();
+
+  /** Ajoute un releve ; efface le secteur le plus ancien si besoin. Retourne false sur erreur flash. */
+  bool append(const PackedReading& r);
+
+  /** Curseur sur le bloc de temps qui contient `from` (le plus ancien si `from` le precede). */
+  HistoryCursor seek(uint32_t from) const;
+
+  /**
+   * Copie dans `out` au plus `max` releves d'epoch comprise dans
+   * [from, to], dans l'ordre d'ecriture, et avance le curseur. `c.done`
+   * passe a true a la position d'ajout ou au premier bloc posterieur a
+   * `to`. Si le secteur du curseur a ete recycle entre deux appels, la
+   * lecture reprend au plus ancien secteur restant.
+   */
+  uint16_t read(HistoryCursor& c, uint32_t from, uint32_t to, PackedReading* out,
+                uint16_t max) const;
+
+  uint32_t records() const { return records_; }
+  uint32_t capacity() const { return (uint32_t)sectors_ * HISTORY_SLOTS; }
+  uint16_t sectors() const { return sectors_; }
+  /** Epoch du plus ancien et du plus recent releve, 0 si vide. */
+  uint32_t oldestEpoch() const;
+  uint32_t newestEpoch() const { return newest_; }
+  uint32_t erases() const { return erases_; }
+  uint32_t corrupt() const { return corrupt_; }
+  uint32_t flashErrors() const { return flashErrors_; }
+
+ private:
+  const uint8_t* sectorData(uint16_t s) const {
+    return flash_.data() + (uint32_t)s * HISTORY_SECTOR_SIZE;
+  }
+  const uint8_t* slotData(uint16_t s, uint16_t i) const {
+    return sectorData(s) + HISTORY_HEADER_SIZE + (uint32_t)i * HISTORY_RECORD_SIZE;
+  }
+  /** Generation du secteur, false s'il est vide ou d'un autre format. */
+  bool sectorGen(uint16_t s, uint32_t& gen) const;
+  /** Emplacements occupes (jusqu'au premier libre). */
+  uint16_t usedSlots(uint16_t s) const;
+  /** Releve de l'emplacement, false s'il est libre ou corrompu. */
+  bool recordAt(uint16_t s, uint16_t i, PackedReading& out) const;
+  /** Premier secteur valide dans l'ordre du journal (le plus ancien), -1 si vide. */
+  int32_t oldestSector() const;
+  bool openNextSector();
+
+  HistoryFlash& flash_;
+  uint16_t sectors_ = 0;
+  int32_t head_ = -1;       // Secteur en cours d'ecriture, -1 si journal vide
+  uint16_t headSlot_ = 0;   // Premier emplacement libre du secteur courant
+  uint32_t headGen_ = 0;
+  uint32_t records_ = 0;
+  uint32_t newest_ = 0;
+  uint32_t erases_ = 0;
+  uint32_t corrupt_ = 0;
+  uint32_t flashErrors_ = 0;
+};
+
+#endif
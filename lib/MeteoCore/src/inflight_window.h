@@ -0,0 +1,113 @@
+#ifndef INFLIGHT_WINDOW_H
+#define INFLIGHT_WINDOW_H
+
+#include <stdint.h>
+
+/**
+ * Fenetre des PUBLISH QoS 1 en attente de PUBACK.
+ *
+ * Chaque message couvre `count` releves consecutifs d'une file (tampon de
+ * coupure ou lot RTC), dans l'ordre d'envoi : le message i commence au
+ * releve offset(i). Les releves ne sont retires de la file qu'une fois
+ * acquittes, par prefixe (popAcked) ; un message est retransmis en
+ * reencodant ses releves depuis la file, sans copie de sa charge utile.
+ *
+ * Les identifiants de paquet vont de `firstId` a `lastId` (1 a 65535 par
+ * defaut, 0 est reserve par MQTT) : deux fenetres sur la meme connexion
+ * utilisent des plages disjointes.
+ */
+struct InflightSlot {
+  uint16_t id;
+  uint16_t count;      // Releves couverts par le message
+  uint32_t sentMs;     // Dernier envoi (premier ou retransmission)
+  bool acked;
+};
+
+template <uint8_t N>
+class InflightWindow {
+ public:
+  explicit InflightWindow(uint16_t firstId = 1, uint16_t lastId = UINT16_MAX)
+      : firstId_(firstId), lastId_(lastId), nextId_(firstId) {}
+
+  bool full() const { return n_ >= N; }
+  bool empty() const { return n_ == 0; }
+  uint8_t size() const { return n_; }
+  const InflightSlot& slot(uint8_t i) const { return slots_[i]; }
+
+  /** Releves couverts par les messages en vol. */
+  uint32_t readings() const { return offset(n_); }
+
+  /** Premier releve du message i dans la file. */
+  uint32_t offset(uint8_t i) const {
+    uint32_t off = 0;
+    for (uint8_t k = 0; k < i && k < n_; k++) {
+      off += slots_[k].count;
+    }
+    return off;
+  }
+
+  /** Identifiant du prochain message. */
+  uint16_t peekId() const { return nextId_; }
+
+  /** Enregistre un message envoye ; retourne son identifiant (0 si la fenetre est pleine). */
+  uint16_t add(uint16_t count, uint32_t now) {
+    if (full()) {
+      return 0;
+    }
+    uint16_t id = nextId_;
+    nextId_ = nextId_ >= lastId_ ? firstId_ : nextId_ + 1;
+    slots_[n_++] = {id, count, now, false};
+    return id;
+  }
+
+  /** Marque un message acquitte. Retourne false si l'identifiant est inconnu. */
+  bool ack(uint16_t id) {
+    for (uint8_t i = 0; i < n_; i++) {
+      if (slots_[i].id == id && !slots_[i].acked) {
+        slots_[i].acked = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Retire les messages acquittes en tete ; retourne le nombre de releves liberes. */
+  uint32_t popAcked() {
+    uint8_t k = 0;
+    uint32_t released = 0;
+    while (k < n_ && slots_[k].acked) {
+      released += slots_[k].count;
+      k++;
+    }
+    for (uint8_t i = k; i < n_; i++) {
+      slots_[i - k] = slots_[i];
+    }
+    n_ -= k;
+    return released;
+  }
+
+  /** Plus ancien message non acquitte envoye il y a au moins `timeoutMs`, -1 sinon. */
+  int expired(uint32_t now, uint32_t timeoutMs) const {
+    for (uint8_t i = 0; i < n_; i++) {
+      if (!slots_[i].acked && now - slots_[i].sentMs >= timeoutMs) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /** Note la retransmission du message i. */
+  void resent(uint8_t i, uint32_t now) { slots_[i].sentMs = now; }
+
+  /** Oublie les messages en vol (deconnexion) : ils seront renvoyes. */
+  void clear() { n_ = 0; }
+
+ private:
+  InflightSlot slots_[N];
+  uint8_t n_ = 0;
+  uint16_t firstId_;
+  uint16_t lastId_;
+  uint16_t nextId_;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "mqtt_packet.h"
+
+size_t mqttPublishHeader(uint8_t* buf, size_t len, const char* topic, size_t payloadLen,
+                         uint16_t packetId, bool dup) {
+  size_t topicLen = strlen(topic);
+  if (packetId == 0 || topicLen > UINT16_MAX) {
+    return 0;
+  }
+  // Topic (2 + n), identifiant (2), charge utile
+  uint64_t remaining = 2 + topicLen + 2 + (uint64_t)payloadLen;
+  if (remaining > MQTT_REMAINING_MAX) {
+    return 0;
+  }
+  uint8_t varint[4];
+  size_t varLen = 0;
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    varint[varLen++] = digit | (remaining > 0 ? 0x80 : 0);
+  } while (remaining > 0);
+
+  size_t total = 1 + varLen + 2 + topicLen + 2;
+  if (total > len) {
+    return 0;
+  }
+  size_t pos = 0;
+  buf[pos++] = MQTT_PUBLISH_QOS1 | (dup ? MQTT_PUBLISH_DUP : 0);
+  memcpy(buf + pos, varint, varLen);
+  pos += varLen;
+  buf[pos++] = topicLen >> 8;
+  buf[pos++] = topicLen & 0xFF;
+  memcpy(buf + pos, topic, topicLen);
+  pos += topicLen;
+  buf[pos++] = packetId >> 8;
+  buf[pos++] = packetId & 0xFF;
+  return pos;
+}
+
+bool MqttAckParser::feed(uint8_t b, uint16_t& packetId) {
+  switch (state_) {
+    case HEADER:
+      type_ = b & 0xF0;
+      remaining_ = 0;
+      shift_ = 0;
+      pos_ = 0;
+      id_ = 0;
+      state_ = LENGTH;
+      return false;
+
+    case LENGTH:
+      remaining_ |= (uint32_t)(b & 0x7F) << shift_;
+      shift_ += 7;
+      if (b & 0x80) {
+        if (shift_ >= 28) {
+          state_ = HEADER;  // Longueur invalide : resynchronisation au paquet suivant
+        }
+        return false;
+      }
+      if (remaining_ == 0) {
+        state_ = HEADER;
+        return false;
+      }
+      state_ = BODY;
+      return false;
+
+    case BODY:
+      if (pos_ < 2) {
+        id_ = (id_ << 8) | b;
+      }
+      if (++pos_ < remaining_) {
+        return false;
+      }
+      state_ = HEADER;
+      if (type_ == MQTT_PUBACK && remaining_ == 2) {
+        packetId = id_;
+        return true;
+      }
+      return false;
+  }
+  return false;
+}
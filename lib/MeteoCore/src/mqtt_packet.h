@@ -0,0 +1,53 @@
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Fragments du protocole MQTT 3.1.1 absents de PubSubClient (QoS 0
+ * uniquement en publication) : en-tete d'un PUBLISH QoS 1 et reperage des
+ * PUBACK dans le flux entrant, sans dependance materielle.
+ */
+
+#define MQTT_PUBLISH_QOS1   0x32   // PUBLISH, QoS 1, sans retain
+#define MQTT_PUBLISH_DUP    0x08   // Drapeau DUP (retransmission)
+#define MQTT_PUBACK         0x40
+#define MQTT_REMAINING_MAX  268435455UL
+
+/**
+ * Ecrit l'en-tete d'un PUBLISH QoS 1 : en-tete fixe, longueur restante,
+ * topic et identifiant de paquet ; la charge utile (`payloadLen` octets)
+ * suit sans copie. Retourne la longueur ecrite, 0 si le tampon est trop
+ * petit, le topic trop long ou `packetId` nul.
+ */
+size_t mqttPublishHeader(uint8_t* buf, size_t len, const char* topic, size_t payloadLen,
+                         uint16_t packetId, bool dup);
+
+/**
+ * Suit le decoupage en paquets du flux entrant, octet par octet, et
+ * signale chaque PUBACK complet. Les autres paquets sont ignores ; ils
+ * restent lus et traites par PubSubClient.
+ */
+class MqttAckParser {
+ public:
+  /** A appeler a chaque nouvelle connexion (debut de paquet). */
+  void reset() {
+    state_ = HEADER;
+  }
+
+  /** Retourne true quand `b` termine un PUBACK ; `packetId` recoit son identifiant. */
+  bool feed(uint8_t b, uint16_t& packetId);
+
+ private:
+  enum State : uint8_t { HEADER, LENGTH, BODY };
+
+  State state_ = HEADER;
+  uint8_t type_ = 0;
+  uint8_t shift_ = 0;
+  uint32_t remaining_ = 0;
+  uint32_t pos_ = 0;
+  uint16_t id_ = 0;
+};
+
+#endif
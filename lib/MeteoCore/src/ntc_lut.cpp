@@ -0,0 +1,9 @@
+#include "ntc_lut.h"
+
+constexpr ntc::Lut NTC_LUT = ntc::makeLut();
+
+// Verifications a la compilation : point de reference et monotonie
+static_assert(NTC_LUT.centi[613] > 2450 && NTC_LUT.centi[613] < 2550,
+              "NTC_LUT : R_NOMINAL doit correspondre a ~T_NOMINAL");
+static_assert(NTC_LUT.centi[1000] > NTC_LUT.centi[3000],
+              "NTC_LUT : la temperature doit decroitre avec le code ADC");
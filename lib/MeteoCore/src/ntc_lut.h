@@ -0,0 +1,109 @@
+#ifndef NTC_LUT_H
+#define NTC_LUT_H
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * Table de conversion ADC -> temperature NTC generee a la compilation.
+ *
+ * Les 4096 entrees (une par code ADC) sont calculees par le compilateur a
+ * partir de R_SERIES, B_COEFF, R_NOMINAL et T_NOMINAL avec l'equation Beta,
+ * et stockees en centiemes de degre (int16_t, 8 Ko en flash). A l'execution,
+ * la conversion se resume a une lecture indexee : plus de log() ni de
+ * division en double emulee.
+ */
+
+#define ADC_MAX     4095
+#define NTC_LUT_SIZE (ADC_MAX + 1)
+
+namespace ntc {
+
+constexpr double LN2 = 0.69314718055994530942;
+constexpr double KELVIN = 273.15;
+
+/**
+ * Logarithme neperien evaluable a la compilation (x > 0).
+ * Reduction x = m * 2^k avec m dans [0.75, 1.5), puis serie
+ * ln(m) = 2 * atanh((m - 1) / (m + 1)).
+ */
+constexpr double ln(double x) {
+  int k = 0;
+  while (x >= 1.5) { x /= 2.0; k++; }
+  while (x < 0.75) { x *= 2.0; k--; }
+  double y = (x - 1.0) / (x + 1.0);
+  double y2 = y * y;
+  double term = y;
+  double sum = 0.0;
+  for (int n = 1; n < 32; n += 2) {
+    sum += term / n;
+    term *= y2;
+  }
+  return 2.0 * sum + k * LN2;
+}
+
+/**
+ * Temperature (C) pour un code ADC, equation Beta sur le pont diviseur.
+ * Les codes extremes (0 et ADC_MAX) sont ramenes a leurs voisins.
+ */
+constexpr double tempFromRaw(int raw) {
+  if (raw < 1) raw = 1;
+  if (raw > ADC_MAX - 1) raw = ADC_MAX - 1;
+  double resistance = R_SERIES * raw / ((double)ADC_MAX - raw);
+  double tempK = 1.0 / (1.0 / (T_NOMINAL + KELVIN) + ln(resistance / R_NOMINAL) / B_COEFF);
+  return tempK - KELVIN;
+}
+
+constexpr int16_t toCenti(double t) {
+  double c = t * 100.0 + (t >= 0 ? 0.5 : -0.5);
+  if (c > 32767.0) c = 32767.0;
+  if (c < -32768.0) c = -32768.0;
+  return (int16_t)c;
+}
+
+struct Lut {
+  int16_t centi[NTC_LUT_SIZE];
+};
+
+constexpr Lut makeLut() {
+  Lut lut = {};
+  for (int raw = 0; raw < NTC_LUT_SIZE; raw++) {
+    lut.centi[raw] = toCenti(tempFromRaw(raw));
+  }
+  return lut;
+}
+
+}  // namespace ntc
+
+// Table unique, definie dans src/ntc_lut.cpp (placee en flash)
+extern const ntc::Lut NTC_LUT;
+
+/**
+ * Temperature NTC (C) pour un code ADC entier : une seule lecture indexee.
+ */
+inline float ntcTempFromRaw(uint16_t raw) {
+  return NTC_LUT.centi[raw > ADC_MAX ? ADC_MAX : raw] * 0.01f;
+}
+
+/**
+ * Temperature NTC (C) pour une moyenne ADC fractionnaire (sur-echantillonnage) :
+ * interpolation lineaire entre deux entrees de la table.
+ */
+inline float ntcTempFromRawInterp(float raw) {
+  if (raw <= 0.0f) return ntcTempFromRaw(0);
+  if (raw >= (float)ADC_MAX) return ntcTempFromRaw(ADC_MAX);
+  uint16_t i = (uint16_t)raw;
+  float frac = raw - i;
+  float a = NTC_LUT.centi[i];
+  float b = NTC_LUT.centi[i + 1];
+  return (a + (b - a) * frac) * 0.01f;
+}
+
+/**
+ * Luminosite (%) pour une moyenne ADC, en simple precision.
+ */
+inline float ldrPctFromRaw(float raw) {
+  return raw * (100.0f / ADC_MAX);
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include <string.h>
+#include "config.h"
+#include "payload.h"
+#include "sensor_registry.h"
+#include "timefmt.h"
+
+/**
+ * Ecriture sequentielle dans un tampon fixe, sans allocation ni printf.
+ * Au premier depassement, `ok` passe a false et le tampon reste termine
+ * par '\0' ; les ecritures suivantes sont ignorees.
+ */
+struct JsonOut {
+  char* buf;
+  size_t len;
+  size_t pos;
+  bool ok;
+
+  JsonOut(char* b, size_t l) : buf(b), len(l), pos(0), ok(l > 0) {
+    if (ok) {
+      buf[0] = '\0';
+    }
+  }
+
+  void raw(const char* s, size_t n) {
+    if (!ok || pos + n >= len) {
+      ok = false;
+      return;
+    }
+    memcpy(buf + pos, s, n);
+    pos += n;
+    buf[pos] = '\0';
+  }
+
+  void raw(const char* s) { raw(s, strlen(s)); }
+
+  /** Valeur en centiemes ecrite avec une decimale (2351 -> 23.5). */
+  void centi1(int16_t centi) {
+    int32_t v = centi;
+    bool neg = v < 0;
+    uint32_t deci = (uint32_t)((neg ? -v : v) + 5) / 10;
+    char tmp[8];
+    char* p = tmp + sizeof(tmp);
+    *--p = '0' + deci % 10;
+    *--p = '.';
+    deci /= 10;
+    do {
+      *--p = '0' + deci % 10;
+      deci /= 10;
+    } while (deci > 0);
+    if (neg) {
+      *--p = '-';
+    }
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+  void u32(uint32_t v) {
+    char tmp[10];
+    char* p = tmp + sizeof(tmp);
+    do {
+      *--p = '0' + v % 10;
+      v /= 10;
+    } while (v > 0);
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+#if AGGREGATE_WINDOW > 0
+  /** Ecart-type en centiemes ecrit avec deux decimales (12 -> 0.12). */
+  void centi2(uint16_t centi) {
+    char tmp[8];
+    char* p = tmp + sizeof(tmp);
+    uint32_t v = centi;
+    *--p = '0' + v % 10;
+    v /= 10;
+    *--p = '0' + v % 10;
+    v /= 10;
+    *--p = '.';
+    do {
+      *--p = '0' + v % 10;
+      v /= 10;
+    } while (v > 0);
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+  /**
+   * Resume de fenetre : ,"window_s":60,"stats":{"cle":{"n":..,"min":..,
+   * "max":..,"stddev":..},...} pour les canaux publies et valides.
+   */
+  void stats(const PackedReading& p) {
+    raw(",\"window_s\":");
+    u32(AGGREGATE_WINDOW / 1000);
+    raw(",\"stats\":{");
+    bool first = true;
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      if ((p.omitted & (1u << ch)) || !(p.valid & (1u << ch))) {
+        continue;
+      }
+      const PackedStats& st = p.stats[ch];
+      raw(first ? "\"" : ",\"");
+      first = false;
+      raw(CHANNELS[ch].key);
+      raw("\":{\"n\":");
+      u32(st.n);
+      raw(",\"min\":");
+      centi1(st.min);
+      raw(",\"max\":");
+      centi1(st.max);
+      raw(",\"stddev\":");
+      centi2(st.stddev);
+      raw("}");
+    }
+    raw("}");
+  }
+#endif
+
+  /** Champ "timestamp":"..." (ou "null" si l'heure est inconnue). */
+  void timestamp(uint32_t epoch) {
+    char ts[TIMESTAMP_LEN];
+    size_t n = formatTimestamp(ts, sizeof(ts), epoch);
+    raw("\"timestamp\":\"");
+    raw(ts, n);
+    raw("\"");
+  }
+
+  /**
+   * Champs des canaux : ,"cle":valeur ou null si invalide. Les canaux
+   * inchanges (publication par exception) sont omis. Avec ADAPTIVE_INTERVAL,
+   * suivis de la cadence en vigueur ,"interval_s":N.
+   */
+  void channels(const PackedReading& p) {
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      if (p.omitted & (1u << ch)) {
+        continue;
+      }
+      raw(",\"");
+      raw(CHANNELS[ch].key);
+      raw("\":");
+      if (p.valid & (1u << ch)) {
+        centi1(p.centi[ch]);
+      } else {
+        raw("null");
+      }
+    }
+#if ADAPTIVE_INTERVAL
+    if (p.intervalS > 0) {
+      raw(",\"interval_s\":");
+      u32(p.intervalS);
+    }
+#endif
+  }
+};
+
+size_t formatReadingJson(char* buf, size_t len, const PackedReading& r, const char* device) {
+  JsonOut out(buf, len);
+  out.raw("{");
+  out.timestamp(r.epoch);
+  out.raw(",\"user\":\"" MQTT_USER "\",\"device\":\"");
+  out.raw(device);
+  out.raw("\"");
+  out.channels(r);
+#if AGGREGATE_WINDOW > 0
+  out.stats(r);
+#endif
+  out.raw("}");
+  return out.ok ? out.pos : 0;
+}
+
+size_t formatBatchJson(char* buf, size_t len, const PackedReading* batch, uint16_t n,
+                       uint16_t& count, const char* device) {
+  count = 0;
+  // Reserve la place de la fermeture "]}"
+  const size_t closing = 2;
+  if (len <= closing) {
+    return 0;
+  }
+  JsonOut out(buf, len - closing);
+  out.raw("{\"user\":\"" MQTT_USER "\",\"device\":\"");
+  out.raw(device);
+  out.raw("\",\"readings\":[");
+  for (uint16_t i = 0; i < n && out.ok; i++) {
+    size_t mark = out.pos;
+    if (i > 0) {
+      out.raw(",");
+    }
+    out.raw("{");
+    out.timestamp(batch[i].epoch);
+    out.channels(batch[i]);
+#if AGGREGATE_WINDOW > 0
+    out.stats(batch[i]);
+#endif
+    out.raw("}");
+    if (!out.ok) {
+      // Releve incomplet : on le retire et on ferme le tableau
+      buf[mark] = '\0';
+      out.pos = mark;
+      break;
+    }
+    count++;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  out.len = len;
+  out.ok = true;
+  out.raw("]}");
+  return out.pos;
+}
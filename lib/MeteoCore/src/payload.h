@@ -0,0 +1,36 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Construction des payloads JSON publies sur MQTT.
+ *
+ * Format unitaire (MQTT_TOPIC) : un releve par message, avec user/device.
+ * Format groupe (MQTT_BATCH_TOPIC) : un en-tete user/device puis un tableau
+ * de releves horodates, pour amortir le cout par message du broker et du TLS.
+ *
+ * Aucune allocation : le JSON est ecrit directement dans le tampon de
+ * l'appelant a partir des valeurs compactes (centiemes, arrondies a une
+ * decimale en arithmetique entiere) et de l'horodatage de timefmt.h.
+ */
+
+/**
+ * Ecrit le payload unitaire d'un releve dans `buf`, au nom de `device`
+ * (une feuille ESP-NOW pour la passerelle).
+ * Retourne la longueur ecrite, 0 si le tampon est trop petit.
+ */
+size_t formatReadingJson(char* buf, size_t len, const PackedReading& r,
+                         const char* device = MQTT_DEVICE);
+
+/**
+ * Ecrit un payload groupe avec autant de releves de `batch` que possible
+ * (au plus `n`), au nom de `device`. `count` recoit le nombre de releves inclus.
+ * Retourne la longueur ecrite, 0 si aucun releve ne tient dans le tampon.
+ */
+size_t formatBatchJson(char* buf, size_t len, const PackedReading* batch, uint16_t n,
+                       uint16_t& count, const char* device = MQTT_DEVICE);
+
+#endif
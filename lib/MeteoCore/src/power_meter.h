@@ -0,0 +1,93 @@
+#ifndef POWER_METER_H
+#define POWER_METER_H
+
+#include <stdint.h>
+
+/**
+ * Bilan d'energie : temps passe dans chaque etat d'alimentation sur une
+ * fenetre, et courant moyen estime a partir d'un courant par etat.
+ *
+ * Les etats sont ceux que le firmware choisit lui-meme : CPU au maximum
+ * (handshake TLS, publication), CPU ralenti entre les taches (modem ou
+ * light sleep selon POWER_SAVE), deep sleep. Le temps passe en light sleep
+ * automatique n'est pas observable et reste compte dans PSTATE_IDLE.
+ *
+ * Etat POD sans constructeur : peut etre place en memoire RTC (deep sleep).
+ * Horloge en microsecondes fournie par l'appelant.
+ */
+
+enum PowerState : uint8_t {
+  PSTATE_BOOST,  // CPU a CPU_FREQ_BOOST_MHZ
+  PSTATE_IDLE,   // CPU a CPU_FREQ_IDLE_MHZ
+  PSTATE_SLEEP,  // Deep sleep
+  PSTATE_COUNT
+};
+
+struct PowerMeter {
+  uint64_t us[PSTATE_COUNT];  // Temps cumule par etat sur la fenetre
+  uint64_t sinceUs;           // Entree dans l'etat courant
+  uint8_t state;              // Etat courant (PowerState)
+};
+
+/** Cloture l'etat courant a `nowUs` et passe dans `s`. */
+inline void powerMeterEnter(PowerMeter& m, PowerState s, uint64_t nowUs) {
+  if (nowUs > m.sinceUs) {
+    m.us[m.state] += nowUs - m.sinceUs;
+  }
+  m.sinceUs = nowUs;
+  m.state = s;
+}
+
+/** Ajoute `us` a l'etat `s` sans changer l'etat courant (sommeil a venir). */
+inline void powerMeterAdd(PowerMeter& m, PowerState s, uint64_t us) {
+  m.us[s] += us;
+}
+
+/** Ouvre une nouvelle fenetre a `nowUs`, dans l'etat courant. */
+inline void powerMeterReset(PowerMeter& m, uint64_t nowUs) {
+  for (int s = 0; s < PSTATE_COUNT; s++) {
+    m.us[s] = 0;
+  }
+  m.sinceUs = nowUs;
+}
+
+/**
+ * Retire la fenetre deja publiee (`reported`, copie de m.us prise au rendu) :
+ * le temps ecoule depuis ce rendu reste dans la fenetre suivante.
+ */
+inline void powerMeterConsume(PowerMeter& m, const uint64_t reported[PSTATE_COUNT]) {
+  for (int s = 0; s < PSTATE_COUNT; s++) {
+    m.us[s] = m.us[s] > reported[s] ? m.us[s] - reported[s] : 0;
+  }
+}
+
+inline uint64_t powerMeterTotal(const PowerMeter& m) {
+  uint64_t t = 0;
+  for (int s = 0; s < PSTATE_COUNT; s++) {
+    t += m.us[s];
+  }
+  return t;
+}
+
+/** Part du temps CPU au maximum (rapport cyclique, en %), 0 si la fenetre est vide. */
+inline uint8_t powerMeterDutyPct(const PowerMeter& m) {
+  uint64_t t = powerMeterTotal(m);
+  return t ? (uint8_t)((m.us[PSTATE_BOOST] * 100 + t / 2) / t) : 0;
+}
+
+/** Courant moyen (uA) pondere par le temps passe dans chaque etat. */
+inline uint32_t powerMeterMeanUa(const PowerMeter& m, const uint32_t ua[PSTATE_COUNT]) {
+  uint64_t t = powerMeterTotal(m);
+  if (t == 0) {
+    return 0;
+  }
+  // us * uA depasse 2^64 au-dela de ~40 h a 120 mA : calcul en ms
+  uint64_t charge = 0;
+  for (int s = 0; s < PSTATE_COUNT; s++) {
+    charge += (m.us[s] / 1000) * ua[s];
+  }
+  uint64_t ms = t / 1000;
+  return ms ? (uint32_t)(charge / ms) : ua[m.state];
+}
+
+#endif
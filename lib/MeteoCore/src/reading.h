@@ -0,0 +1,144 @@
+#ifndef READING_H
+#define READING_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Heure minimale consideree comme synchronisee (2020-01-01)
+#define EPOCH_VALID_MIN 1577836800UL
+
+/**
+ * Canaux de mesure de la station, dans l'ordre du payload JSON.
+ */
+enum Channel : uint8_t {
+  CH_DHT_TEMP = 0,   // Temperature DHT11 (C)
+  CH_DHT_HUM,        // Humidite DHT11 (%)
+  CH_NTC_TEMP,       // Temperature NTC (C)
+  CH_LUMINOSITY,     // Luminosite LDR (%)
+  CH_COUNT
+};
+
+#if AGGREGATE_WINDOW > 0
+/**
+ * Resume d'une fenetre d'agregation pour un canal ; la valeur du releve
+ * porte la moyenne.
+ */
+struct ChannelStats {
+  float min;
+  float max;
+  float stddev;              // Ecart-type d'echantillon
+  uint16_t n;                // Echantillons valides dans la fenetre
+};
+#endif
+
+/**
+ * Releve horodate de taille fixe, echange entre la tache d'acquisition
+ * et la tache reseau via une file FreeRTOS (copie par valeur).
+ */
+struct Reading {
+  uint32_t seq;              // Numero de sequence (detection des trous)
+  uint32_t epoch;            // Heure UNIX, relative avant NTP (timebase.h), 0 si inconnue
+  float value[CH_COUNT];     // Valeurs par canal
+  uint8_t valid;             // Bit i a 1 si le canal i est valide
+  uint8_t omitted;           // Bit i a 1 si le canal i est inchange (non publie)
+  uint16_t intervalS;        // Cadence en vigueur (s), 0 si fixe (ADAPTIVE_INTERVAL = 0)
+#if AGGREGATE_WINDOW > 0
+  ChannelStats stats[CH_COUNT];  // Fenetre resumee (epoch = debut de fenetre)
+#endif
+};
+
+inline bool readingValid(const Reading& r, Channel ch) {
+  return (r.valid >> ch) & 1;
+}
+
+#if AGGREGATE_WINDOW > 0
+/** Resume compact d'un canal : centiemes, ecart-type non signe. */
+struct PackedStats {
+  int16_t min;
+  int16_t max;
+  uint16_t stddev;
+  uint16_t n;
+};
+#endif
+
+/**
+ * Releve compact (20 octets, 52 avec AGGREGATE_WINDOW) pour le stockage :
+ * valeurs en centiemes (C, % ou % de luminosite), horodatage d'origine conserve.
+ */
+struct PackedReading {
+  uint32_t seq;
+  uint32_t epoch;
+  int16_t centi[CH_COUNT];
+  uint8_t valid;
+  uint8_t omitted;           // 0 = releve complet (compatible ancien fichier de coupure)
+  uint16_t intervalS;        // 0 = cadence fixe (compatible ancien fichier de coupure)
+#if AGGREGATE_WINDOW > 0
+  PackedStats stats[CH_COUNT];   // + 32 octets par releve resume
+#endif
+};
+
+#if AGGREGATE_WINDOW > 0
+static_assert(sizeof(PackedReading) == 52, "PackedReading doit rester compact");
+#else
+static_assert(sizeof(PackedReading) == 20, "PackedReading doit rester compact");
+#endif
+
+/** Valeur en centiemes, arrondie et bornee a int16 (NaN -> 0). */
+inline int16_t toCenti(float v) {
+  float c = v * 100.0f;
+  if (c != c) {
+    c = 0.0f;
+  }
+  if (c > 32767.0f) c = 32767.0f;
+  if (c < -32768.0f) c = -32768.0f;
+  return (int16_t)(c + (c >= 0 ? 0.5f : -0.5f));
+}
+
+/**
+ * Valeur d'un canal en centiemes, arrondie et bornee a int16 (0 si invalide).
+ */
+inline int16_t readingCenti(const Reading& r, Channel ch) {
+  return ((r.valid >> ch) & 1) ? toCenti(r.value[ch]) : 0;
+}
+
+inline PackedReading packReading(const Reading& r) {
+  PackedReading p = {};
+  p.seq = r.seq;
+  p.epoch = r.epoch;
+  p.valid = r.valid;
+  p.omitted = r.omitted;
+  p.intervalS = r.intervalS;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    p.centi[ch] = readingCenti(r, (Channel)ch);
+#if AGGREGATE_WINDOW > 0
+    const ChannelStats& st = r.stats[ch];
+    p.stats[ch].min = toCenti(st.min);
+    p.stats[ch].max = toCenti(st.max);
+    float sd = st.stddev * 100.0f + 0.5f;
+    p.stats[ch].stddev = sd >= 65535.0f ? 65535 : (sd > 0.0f ? (uint16_t)sd : 0);
+    p.stats[ch].n = st.n;
+#endif
+  }
+  return p;
+}
+
+inline Reading unpackReading(const PackedReading& p) {
+  Reading r = {};
+  r.seq = p.seq;
+  r.epoch = p.epoch;
+  r.valid = p.valid;
+  r.omitted = p.omitted;
+  r.intervalS = p.intervalS;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    r.value[ch] = p.centi[ch] * 0.01f;
+#if AGGREGATE_WINDOW > 0
+    r.stats[ch].min = p.stats[ch].min * 0.01f;
+    r.stats[ch].max = p.stats[ch].max * 0.01f;
+    r.stats[ch].stddev = p.stats[ch].stddev * 0.01f;
+    r.stats[ch].n = p.stats[ch].n;
+#endif
+  }
+  return r;
+}
+
+#endif
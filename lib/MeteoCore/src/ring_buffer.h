@@ -0,0 +1,76 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+
+/**
+ * Tampon circulaire de capacite fixe N, sans allocation dynamique.
+ * L'element d'indice 0 est toujours le plus ancien.
+ */
+template <typename T, uint16_t N>
+class RingBuffer {
+ public:
+  static constexpr uint16_t capacity() { return N; }
+  uint16_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  bool full() const { return count_ == N; }
+
+  /** Ajoute en fin de tampon. Retourne false si plein. */
+  bool push(const T& v) {
+    if (full()) {
+      return false;
+    }
+    buf_[(head_ + count_) % N] = v;
+    count_++;
+    return true;
+  }
+
+  /** Ajoute en ecrasant le plus ancien si plein. Retourne true si ecrasement. */
+  bool pushOverwrite(const T& v) {
+    bool overwrite = full();
+    if (overwrite) {
+      drop(1);
+    }
+    push(v);
+    return overwrite;
+  }
+
+  /** Lit l'element d'indice i (0 = plus ancien) sans le retirer. */
+  bool peek(T& out, uint16_t i = 0) const {
+    if (i >= count_) {
+      return false;
+    }
+    out = buf_[(head_ + i) % N];
+    return true;
+  }
+
+  /** Retire le plus ancien element. */
+  bool pop(T& out) {
+    if (!peek(out)) {
+      return false;
+    }
+    drop(1);
+    return true;
+  }
+
+  /** Retire les n plus anciens elements. */
+  void drop(uint16_t n) {
+    if (n > count_) {
+      n = count_;
+    }
+    head_ = (head_ + n) % N;
+    count_ -= n;
+  }
+
+  void clear() {
+    head_ = 0;
+    count_ = 0;
+  }
+
+ private:
+  T buf_[N];
+  uint16_t head_ = 0;
+  uint16_t count_ = 0;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "scheduler.h"
+
+// Comparaison robuste au debordement de millis() (~49 jours)
+static inline bool isDue(uint32_t now, uint32_t due) {
+  return (int32_t)(now - due) >= 0;
+}
+
+bool Scheduler::add(const char* name, TaskFn fn, uint32_t periodMs, uint32_t now, uint32_t offsetMs) {
+  if (count_ >= SCHED_MAX_TASKS || periodMs == 0) {
+    return false;
+  }
+  SchedTask& t = tasks_[count_++];
+  t.name = name;
+  t.fn = fn;
+  t.periodMs = periodMs;
+  t.nextDue = now + offsetMs;
+  t.overruns = 0;
+  return true;
+}
+
+bool Scheduler::setPeriod(TaskFn fn, uint32_t periodMs) {
+  if (periodMs == 0) {
+    return false;
+  }
+  for (int i = 0; i < count_; i++) {
+    if (tasks_[i].fn == fn) {
+      tasks_[i].periodMs = periodMs;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t Scheduler::run(uint32_t now) {
+  for (int i = 0; i < count_; i++) {
+    SchedTask& t = tasks_[i];
+    if (!isDue(now, t.nextDue)) {
+      continue;
+    }
+    t.fn();
+    // Echeance suivante sur la grille fixe ; saut des echeances manquees
+    uint32_t late = now - t.nextDue;
+    uint32_t missed = late / t.periodMs;
+    t.overruns += missed;
+    t.nextDue += (missed + 1) * t.periodMs;
+  }
+
+  uint32_t wait = UINT32_MAX;
+  for (int i = 0; i < count_; i++) {
+    const SchedTask& t = tasks_[i];
+    uint32_t dt = isDue(now, t.nextDue) ? 0 : t.nextDue - now;
+    if (dt < wait) {
+      wait = dt;
+    }
+  }
+  return wait;
+}
@@ -0,0 +1,57 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/**
+ * Ordonnanceur cooperatif a echeances fixes (base millis()).
+ *
+ * Chaque tache a une periode et une prochaine echeance. L'echeance est
+ * avancee d'une periode exacte apres execution (et non "maintenant + periode"),
+ * ce qui evite la derive de la cadence. Si une tache a manque plusieurs
+ * echeances (blocage reseau), elle n'est executee qu'une fois et reprend
+ * sur sa grille de phase d'origine.
+ */
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*TaskFn)();
+
+struct SchedTask {
+  const char* name;
+  TaskFn fn;
+  uint32_t periodMs;
+  uint32_t nextDue;
+  uint32_t overruns;  // Nombre d'echeances manquees
+};
+
+class Scheduler {
+ public:
+  /**
+   * Ajoute une tache. La premiere execution a lieu a now + offsetMs.
+   * Retourne false si la table est pleine.
+   */
+  bool add(const char* name, TaskFn fn, uint32_t periodMs, uint32_t now, uint32_t offsetMs = 0);
+
+  /**
+   * Execute les taches arrivees a echeance.
+   * Retourne le delai (ms) jusqu'a la prochaine echeance.
+   */
+  uint32_t run(uint32_t now);
+
+  /**
+   * Change la periode de la tache `fn`. Appele depuis la tache elle-meme,
+   * l'echeance suivante est avancee de la nouvelle periode.
+   * Retourne false si la tache est inconnue ou la periode nulle.
+   */
+  bool setPeriod(TaskFn fn, uint32_t periodMs);
+
+  const SchedTask* task(int i) const { return (i >= 0 && i < count_) ? &tasks_[i] : nullptr; }
+  int count() const { return count_; }
+
+ private:
+  SchedTask tasks_[SCHED_MAX_TASKS];
+  int count_ = 0;
+};
+
+#endif
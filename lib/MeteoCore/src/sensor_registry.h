@@ -0,0 +1,77 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <stdint.h>
+#include "config.h"
+#include "reading.h"
+
+/**
+ * Registre des canaux et des capteurs, resolu a la compilation.
+ *
+ * CHANNELS decrit chaque canal de l'enum Channel (cle JSON, bande morte,
+ * pas de la cadence adaptative) : encodeurs, filtres et cadence l'indexent
+ * par canal. Un capteur est un type sans etat d'instance qui declare les
+ * canaux qu'il remplit (MASK) et fournit des fonctions statiques :
+ *
+ *   static constexpr uint8_t MASK;          // Bits des canaux remplis
+ *   static void begin();                    // Initialisation materielle
+ *   static void sample(Reading& r);         // value[] et bits valid de MASK
+ *   static void log(const Reading& r);      // Affichage du releve
+ *
+ * SensorRegistry<S...> enchaine ces appels par expansion de pack : pas de
+ * table virtuelle, pas d'allocation, appels directs que le compilateur peut
+ * mettre en ligne. Ajouter une sonde = un canal dans l'enum Channel, une
+ * ligne dans CHANNELS et un type dans la liste `Sensors` (include/sensors.h).
+ */
+
+struct ChannelInfo {
+  const char* key;       // Cle JSON
+  int16_t deadband;      // Bande morte (centiemes), REPORT_BY_EXCEPTION
+  int16_t adaptStep;     // Variation visee entre deux releves (centiemes), ADAPTIVE_INTERVAL
+};
+
+/** Description des canaux, dans l'ordre de l'enum Channel. */
+constexpr ChannelInfo CHANNELS[CH_COUNT] = {
+  {"dht_temperature", DEADBAND_DHT_TEMP, ADAPT_STEP_DHT_TEMP},
+  {"dht_humidity", DEADBAND_DHT_HUM, ADAPT_STEP_DHT_HUM},
+  {"ntc_temperature", DEADBAND_NTC_TEMP, ADAPT_STEP_NTC_TEMP},
+  {"luminosity", DEADBAND_LUMINOSITY, ADAPT_STEP_LUMINOSITY},
+};
+
+static_assert(CH_COUNT <= 8, "Les masques de canaux tiennent sur 8 bits");
+
+/** Un parametre par canal, extrait de CHANNELS a la compilation. */
+struct ChannelValues {
+  int16_t v[CH_COUNT];
+};
+
+constexpr ChannelValues channelValues(int16_t ChannelInfo::*field) {
+  ChannelValues out = {};
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    out.v[ch] = CHANNELS[ch].*field;
+  }
+  return out;
+}
+
+constexpr uint8_t ALL_CHANNELS = (1u << CH_COUNT) - 1;
+
+template <typename... S>
+struct SensorRegistry {
+  /** Canaux couverts par au moins un capteur. */
+  static constexpr uint8_t MASK = (0 | ... | S::MASK);
+
+  // Deux capteurs ne remplissent jamais le meme canal : la somme des masques
+  // egale leur union seulement si les bits sont disjoints
+  static_assert((0 + ... + (unsigned)S::MASK) == MASK, "Canal rempli par deux capteurs");
+
+  static constexpr uint8_t count() { return sizeof...(S); }
+
+  static void begin() { (S::begin(), ...); }
+
+  /** Lit tous les capteurs dans l'ordre de la liste. */
+  static void sample(Reading& r) { (S::sample(r), ...); }
+
+  static void log(const Reading& r) { (S::log(r), ...); }
+};
+
+#endif
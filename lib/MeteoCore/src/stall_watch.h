@@ -0,0 +1,121 @@
+#ifndef STALL_WATCH_H
+#define STALL_WATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Chien de garde logiciel : detection et attribution des blocages.
+ *
+ * Chaque tache surveillee a un WatchSlot : la pile des etapes en cours
+ * (STAGE_TIME s'emboite, ex. "sample" puis "dht") avec leur heure de
+ * debut, et un battement de boucle pour le temps passe hors etape. Un
+ * surveillant periodique (autre contexte d'execution) appelle watchCheck :
+ * l'etape la plus interne qui depasse sa limite est designee ; si aucune
+ * etape n'est en cours, c'est le battement de boucle qui est juge.
+ *
+ * Le releve du blocage (StallRecord) est ecrit en memoire RTC non
+ * initialisee avant le redemarrage et relu au demarrage suivant : le
+ * magic et la somme de controle distinguent un releve valide du contenu
+ * aleatoire d'une mise sous tension.
+ *
+ * Etats POD, horloge en millisecondes fournie par l'appelant ; la
+ * synchronisation entre la tache et le surveillant est laissee au firmware.
+ */
+
+#define WATCH_DEPTH       4       // Etapes emboitees suivies par tache
+#define WATCH_NONE        0xFF    // Hors etape (battement de boucle)
+#define STALL_MAGIC       0x4C415453u  // "STAL"
+
+struct WatchSlot {
+  uint32_t beatMs;               // Dernier tour de boucle ou fin d'etape
+  uint32_t loopStallMs;          // 0 : battement de boucle non surveille
+  uint8_t depth;                 // Etapes en cours (au-dela de WATCH_DEPTH : non suivies)
+  uint8_t stage[WATCH_DEPTH];
+  uint32_t startMs[WATCH_DEPTH];
+};
+
+/** Blocage constate : etape (ou WATCH_NONE), duree ecoulee et limite depassee. */
+struct Stall {
+  uint8_t stage;
+  uint32_t elapsedMs;
+  uint32_t limitMs;
+};
+
+inline void watchEnter(WatchSlot& w, uint8_t stage, uint32_t nowMs) {
+  if (w.depth < WATCH_DEPTH) {
+    w.stage[w.depth] = stage;
+    w.startMs[w.depth] = nowMs;
+  }
+  w.depth++;
+}
+
+inline void watchExit(WatchSlot& w, uint32_t nowMs) {
+  if (w.depth > 0) {
+    w.depth--;
+  }
+  w.beatMs = nowMs;
+}
+
+inline void watchBeat(WatchSlot& w, uint32_t nowMs) {
+  w.beatMs = nowMs;
+}
+
+/**
+ * Cherche un blocage a `nowMs`, `stallMs` donnant la limite par etape
+ * (0 : etape non surveillee). Retourne true et remplit `out` si la tache
+ * est bloquee.
+ */
+inline bool watchCheck(const WatchSlot& w, uint32_t nowMs, const uint32_t* stallMs, Stall& out) {
+  uint8_t depth = w.depth < WATCH_DEPTH ? w.depth : WATCH_DEPTH;
+  for (uint8_t i = depth; i-- > 0;) {
+    uint32_t limit = stallMs[w.stage[i]];
+    uint32_t elapsed = nowMs - w.startMs[i];
+    if (limit > 0 && elapsed > limit) {
+      out = {w.stage[i], elapsed, limit};
+      return true;
+    }
+  }
+  if (w.depth == 0 && w.loopStallMs > 0 && nowMs - w.beatMs > w.loopStallMs) {
+    out = {WATCH_NONE, nowMs - w.beatMs, w.loopStallMs};
+    return true;
+  }
+  return false;
+}
+
+/** Dernier blocage, conserve en memoire RTC a travers le redemarrage. */
+struct StallRecord {
+  uint32_t magic;
+  uint8_t core;          // Coeur de la tache bloquee
+  uint8_t stage;         // Etape en cause, WATCH_NONE hors etape
+  uint8_t fresh;         // Ecrit avant le dernier redemarrage, pas encore rapporte
+  uint8_t reserved;
+  uint16_t stalls;       // Redemarrages sur blocage depuis la mise sous tension
+  uint16_t reserved2;
+  uint32_t elapsedMs;
+  uint32_t limitMs;
+  uint32_t uptimeS;      // Depuis le demarrage precedent
+  uint32_t epoch;        // Heure UNIX du blocage, 0 si inconnue
+  uint32_t check;
+};
+
+/** FNV-1a des champs qui precedent `check`. */
+inline uint32_t stallRecordSum(const StallRecord& r) {
+  const uint8_t* p = (const uint8_t*)&r;
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < offsetof(StallRecord, check); i++) {
+    h = (h ^ p[i]) * 16777619u;
+  }
+  return h;
+}
+
+inline void stallRecordSeal(StallRecord& r) {
+  r.magic = STALL_MAGIC;
+  r.check = stallRecordSum(r);
+}
+
+inline bool stallRecordValid(const StallRecord& r) {
+  return r.magic == STALL_MAGIC && r.check == stallRecordSum(r);
+}
+
+#endif
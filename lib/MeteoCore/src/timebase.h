@@ -0,0 +1,88 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include "reading.h"
+
+/**
+ * Horodatage des releves pris avant la synchronisation NTP.
+ *
+ * L'acquisition demarre des la mise sous tension. Tant que l'heure est
+ * inconnue, `epoch` porte un horodatage relatif : secondes du temps
+ * monotone (esp_timer) + 1, toujours sous EPOCH_VALID_MIN, 0 restant
+ * "heure inconnue". Quand l'heure est connue, l'heure UNIX du demarrage
+ * en est deduite une fois pour toutes et les releves en attente sont
+ * completes : rejouer un releve donne toujours le meme horodatage.
+ *
+ * Sans dependance materielle : l'heure et le temps monotone sont fournis
+ * par l'appelant.
+ */
+
+inline bool epochIsRelative(uint32_t epoch) {
+  return epoch != 0 && epoch < EPOCH_VALID_MIN;
+}
+
+/** Horodatage d'un releve : heure UNIX si `now` est valide, sinon relatif. */
+inline uint32_t epochStamp(uint32_t now, uint64_t monoUs) {
+  return now >= EPOCH_VALID_MIN ? now : (uint32_t)(monoUs / 1000000ULL) + 1;
+}
+
+class BootClock {
+ public:
+  /** Fige l'heure du demarrage a la premiere heure valide. Retourne known(). */
+  bool observe(uint32_t now, uint64_t monoUs) {
+    if (bootEpoch_ == 0 && now >= EPOCH_VALID_MIN) {
+      bootEpoch_ = now - (uint32_t)(monoUs / 1000000ULL);
+    }
+    return known();
+  }
+
+  bool known() const { return bootEpoch_ != 0; }
+
+  /** Heure UNIX du temps monotone 0, 0 si inconnue. */
+  uint32_t bootEpoch() const { return bootEpoch_; }
+
+  /** Heure UNIX d'un horodatage relatif ; les autres sont inchanges. */
+  uint32_t resolve(uint32_t epoch) const {
+    return epochIsRelative(epoch) && known() ? bootEpoch_ + epoch - 1 : epoch;
+  }
+
+  /** Complete `batch`. Retourne false s'il reste des horodatages relatifs. */
+  bool resolve(PackedReading* batch, uint16_t n) const {
+    bool done = true;
+    for (uint16_t i = 0; i < n; i++) {
+      batch[i].epoch = resolve(batch[i].epoch);
+      done = done && !epochIsRelative(batch[i].epoch);
+    }
+    return done;
+  }
+
+ private:
+  uint32_t bootEpoch_ = 0;
+};
+
+/**
+ * Heure UNIX d'un horodatage relatif d'une autre station, connaissant son
+ * horloge `peerClock` (epochStamp) a l'instant `now` : l'ecart est compte
+ * depuis maintenant. 0 si l'une des deux heures manque ou est incoherente.
+ */
+inline uint32_t epochFromPeer(uint32_t epoch, uint32_t peerClock, uint32_t now) {
+  if (!epochIsRelative(epoch)) {
+    return epoch;
+  }
+  if (!epochIsRelative(peerClock) || peerClock < epoch || now < EPOCH_VALID_MIN) {
+    return 0;
+  }
+  return now - (peerClock - epoch);
+}
+
+/** Remplace les horodatages relatifs par 0 (publies sans heure). */
+inline void clearRelativeEpochs(PackedReading* batch, uint16_t n) {
+  for (uint16_t i = 0; i < n; i++) {
+    if (epochIsRelative(batch[i].epoch)) {
+      batch[i].epoch = 0;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include <string.h>
+#include <time.h>
+#include "timefmt.h"
+
+#define SECS_PER_DAY 86400L
+#define TZ_SCAN_DAYS 200  // Recherche d'un changement d'heure de part et d'autre
+
+int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const uint32_t yoe = (uint32_t)(y - era * 400);
+  const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+void civilFromDays(int32_t z, int32_t& y, uint32_t& m, uint32_t& d) {
+  z += 719468;
+  const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const uint32_t doe = (uint32_t)(z - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = (int32_t)yoe + era * 400 + (m <= 2);
+}
+
+static inline char* put2(char* p, uint32_t v) {
+  *p++ = '0' + v / 10;
+  *p++ = '0' + v % 10;
+  return p;
+}
+
+size_t formatIso8601(char* buf, size_t len, uint32_t epoch, int32_t offsetSec) {
+  if (len < TIMESTAMP_LEN) {
+    return 0;
+  }
+  int64_t local = (int64_t)epoch + offsetSec;
+  int32_t days = (int32_t)(local / SECS_PER_DAY);
+  int32_t secs = (int32_t)(local % SECS_PER_DAY);
+  if (secs < 0) {
+    secs += SECS_PER_DAY;
+    days--;
+  }
+  int32_t y;
+  uint32_t m, d;
+  civilFromDays(days, y, m, d);
+
+  char* p = buf;
+  p = put2(p, (uint32_t)y / 100 % 100);
+  p = put2(p, (uint32_t)y % 100);
+  *p++ = '-';
+  p = put2(p, m);
+  *p++ = '-';
+  p = put2(p, d);
+  *p++ = 'T';
+  p = put2(p, secs / 3600);
+  *p++ = ':';
+  p = put2(p, secs / 60 % 60);
+  *p++ = ':';
+  p = put2(p, secs % 60);
+  int32_t off = offsetSec;
+  *p++ = off < 0 ? '-' : '+';
+  if (off < 0) {
+    off = -off;
+  }
+  p = put2(p, off / 3600);
+  *p++ = ':';
+  p = put2(p, off / 60 % 60);
+  *p = '\0';
+  return p - buf;
+}
+
+/**
+ * Decalage reel du fuseau a `epoch` : heure locale (libc) moins heure UTC.
+ */
+static int32_t computeOffset(uint32_t epoch) {
+  time_t t = epoch;
+  struct tm l;
+  localtime_r(&t, &l);
+  int64_t localSecs = (int64_t)daysFromCivil(l.tm_year + 1900, l.tm_mon + 1, l.tm_mday) * SECS_PER_DAY +
+                      l.tm_hour * 3600 + l.tm_min * 60 + l.tm_sec;
+  return (int32_t)(localSecs - epoch);
+}
+
+/**
+ * Premier instant dans ]lo, hi] dont le decalage differe de `off`
+ * (recherche dichotomique, lo a le decalage `off`, hi un autre).
+ */
+static uint32_t findTransition(uint32_t lo, uint32_t hi, int32_t off) {
+  while (hi - lo > 1) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (computeOffset(mid) == off) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+// Intervalle [from, until) sur lequel le decalage est constant
+static struct {
+  bool valid;
+  uint32_t from;
+  uint32_t until;
+  int32_t offset;
+} tzCache = {false, 0, 0, 0};
+
+int32_t tzOffsetAt(uint32_t epoch) {
+  if (tzCache.valid && epoch >= tzCache.from && epoch < tzCache.until) {
+    return tzCache.offset;
+  }
+  int32_t off = computeOffset(epoch);
+
+  // Changement d'heure suivant (pas d'un jour puis dichotomie)
+  uint32_t until = epoch;
+  int day = 0;
+  while (day < TZ_SCAN_DAYS && computeOffset(until + SECS_PER_DAY) == off) {
+    until += SECS_PER_DAY;
+    day++;
+  }
+  until = (day < TZ_SCAN_DAYS) ? findTransition(until, until + SECS_PER_DAY, off) : until;
+
+  // Changement d'heure precedent (releves rejoues apres une longue coupure)
+  uint32_t from = epoch;
+  day = 0;
+  while (day < TZ_SCAN_DAYS && from >= SECS_PER_DAY && computeOffset(from - SECS_PER_DAY) == off) {
+    from -= SECS_PER_DAY;
+    day++;
+  }
+  if (day < TZ_SCAN_DAYS && from >= SECS_PER_DAY) {
+    from = findTransition(from - SECS_PER_DAY, from, computeOffset(from - SECS_PER_DAY));
+  }
+
+  tzCache.valid = true;
+  tzCache.from = from;
+  tzCache.until = until;
+  tzCache.offset = off;
+  return off;
+}
+
+size_t formatTimestamp(char* buf, size_t len, uint32_t epoch) {
+  if (epoch == 0) {
+    if (len < 5) {
+      return 0;
+    }
+    memcpy(buf, "null", 5);
+    return 4;
+  }
+  return formatIso8601(buf, len, epoch, tzOffsetAt(epoch));
+}
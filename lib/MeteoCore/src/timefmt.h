@@ -0,0 +1,42 @@
+#ifndef TIMEFMT_H
+#define TIMEFMT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Formatage d'horodatages ISO 8601 sans allocation.
+ *
+ * La conversion date/heure se fait en arithmetique entiere (algorithme
+ * "days from civil") ; seul le decalage du fuseau horaire passe par la libc
+ * (localtime_r), et il est mis en cache avec son intervalle de validite :
+ * il n'est recalcule qu'au passage d'un changement d'heure (CET/CEST).
+ */
+
+#define TIMESTAMP_LEN 26  // "2026-02-08T15:30:00+01:00" + '\0'
+
+/** Nombre de jours depuis 1970-01-01 pour une date civile (calendrier gregorien). */
+int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d);
+
+/** Date civile correspondant a un nombre de jours depuis 1970-01-01. */
+void civilFromDays(int32_t z, int32_t& y, uint32_t& m, uint32_t& d);
+
+/**
+ * Ecrit `epoch` en heure locale de decalage `offsetSec` (ex: +3600),
+ * au format 2026-02-08T15:30:00+01:00. Retourne la longueur ecrite,
+ * 0 si le tampon est trop petit (TIMESTAMP_LEN requis).
+ */
+size_t formatIso8601(char* buf, size_t len, uint32_t epoch, int32_t offsetSec);
+
+/**
+ * Decalage (s) du fuseau configure (TZ) a l'instant `epoch`, via le cache.
+ */
+int32_t tzOffsetAt(uint32_t epoch);
+
+/**
+ * Horodatage ISO 8601 en heure locale (fuseau TZ), ou "null" si `epoch`
+ * vaut 0 (heure inconnue). Retourne la longueur ecrite.
+ */
+size_t formatTimestamp(char* buf, size_t len, uint32_t epoch);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WELFORD_H
+#define WELFORD_H
+
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Statistiques incrementales d'une voie (algorithme de Welford) :
+ * moyenne, min, max et ecart-type en O(1) memoire, numeriquement stable
+ * en simple precision (FPU de l'ESP32) meme sur de longues fenetres.
+ */
+struct Welford {
+  uint32_t n;
+  float mean;
+  float m2;      // Somme des carres des ecarts a la moyenne
+  float min;
+  float max;
+
+  void reset() {
+    n = 0;
+    mean = m2 = min = max = 0.0f;
+  }
+
+  void add(float x) {
+    n++;
+    if (n == 1) {
+      mean = min = max = x;
+      m2 = 0.0f;
+      return;
+    }
+    float delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+    if (x < min) min = x;
+    if (x > max) max = x;
+  }
+
+  /** Ecart-type d'echantillon (n - 1), 0 avec moins de deux valeurs. */
+  float stddev() const {
+    return n > 1 ? sqrtf(m2 / (n - 1)) : 0.0f;
+  }
+};
+
+#endif
@@ -0,0 +1,211 @@
+/**
+ * Tache d'acquisition : lecture periodique des capteurs sur le coeur APP.
+ *
+ * Elle ne touche jamais au reseau, ce qui garantit une cadence
+ * d'echantillonnage reguliere meme pendant une reconnexion WiFi/MQTT.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include "config.h"
+#include "acquisition.h"
+#include "adaptive_rate.h"
+#include "boot_time.h"
+#include "deadband.h"
+#include "log.h"
+#include "reading.h"
+#include "scheduler.h"
+#include "sensor_registry.h"
+#include "sensors.h"
+#include "stage_stats.h"
+#include "welford.h"
+
+static Scheduler acqScheduler;
+static QueueHandle_t readingQueue = nullptr;
+// Conserve en memoire RTC : la sequence continue a travers les deep sleeps
+static RTC_DATA_ATTR uint32_t nextSeq = 0;
+static volatile uint32_t queueDropped = 0;
+
+#if REPORT_BY_EXCEPTION
+#if AGGREGATE_WINDOW > 0
+#define SAMPLE_PERIOD AGGREGATE_WINDOW
+#elif POWER_MODE == POWER_DEEP_SLEEP
+#define SAMPLE_PERIOD DEEP_SLEEP_INTERVAL
+#else
+#define SAMPLE_PERIOD READ_INTERVAL
+#endif
+static constexpr ChannelValues DEADBANDS = channelValues(&ChannelInfo::deadband);
+#if !ADAPTIVE_INTERVAL
+static const uint32_t HEARTBEAT_EVERY =
+  REPORT_HEARTBEAT / SAMPLE_PERIOD > 0 ? REPORT_HEARTBEAT / SAMPLE_PERIOD : 1;
+#endif
+static RTC_DATA_ATTR DeadbandState deadband = {};
+#endif
+
+#if ADAPTIVE_INTERVAL
+static constexpr ChannelValues ADAPT_STEPS = channelValues(&ChannelInfo::adaptStep);
+static RTC_DATA_ATTR AdaptiveRate adaptive = {};
+static RTC_DATA_ATTR uint32_t sampleGapMs = 0;  // Ecart avec le releve precedent
+#endif
+
+/**
+ * Pousse un releve dans la file. Si elle est pleine (coupure reseau longue),
+ * le plus ancien est ecarte.
+ */
+static void pushReading(const Reading& r) {
+  if (xQueueSend(readingQueue, &r, 0) != pdTRUE) {
+    Reading dropped;
+    xQueueReceive(readingQueue, &dropped, 0);
+    xQueueSend(readingQueue, &r, 0);
+    queueDropped++;
+    LOG_W("File pleine, releve #%u ecarte", dropped.seq);
+  }
+}
+
+void acquireReading(Reading& r) {
+  r = {};
+  r.seq = nextSeq++;
+  r.epoch = stampNow();  // Relatif avant NTP, complete a la publication
+
+  // --- Capteurs du registre (include/sensors.h), dans l'ordre de la liste ---
+  Sensors::sample(r);
+
+#if ADAPTIVE_INTERVAL
+  // Cadence suivante selon la variation depuis le releve precedent
+  uint32_t prevMs = adaptive.intervalMs;
+  sampleGapMs = prevMs;
+  uint32_t nextMs = adaptiveUpdate(adaptive, r, ADAPT_STEPS.v, READ_INTERVAL_MIN,
+                                   READ_INTERVAL_MAX, ADAPT_QUIET_SAMPLES);
+  r.intervalS = nextMs / 1000;
+  if (nextMs != prevMs) {
+    LOG_D("Intervalle de releve : %u s", r.intervalS);
+  }
+#endif
+
+  // --- Affichage des releves ---
+  STAGE_TIME(STAGE_LOG);
+  LOG_D("--- Releve capteurs #%u ---", r.seq);
+  Sensors::log(r);
+}
+
+bool acquisitionReport(Reading& r) {
+#if REPORT_BY_EXCEPTION && ADAPTIVE_INTERVAL
+  // Cadence variable : heartbeat sur la duree ecoulee, pas sur un nombre de releves
+  if (!deadbandApply(deadband, r, DEADBANDS.v, REPORT_HEARTBEAT, sampleGapMs)) {
+    LOG_D("Releve #%u inchange, non publie", r.seq);
+    return false;
+  }
+#elif REPORT_BY_EXCEPTION
+  if (!deadbandApply(deadband, r, DEADBANDS.v, HEARTBEAT_EVERY)) {
+    LOG_D("Releve #%u inchange, non publie", r.seq);
+    return false;
+  }
+#else
+  (void)r;
+#endif
+  return true;
+}
+
+#if AGGREGATE_WINDOW > 0
+// Fenetre d'agregation courante : un accumulateur de Welford par canal
+static Welford window[CH_COUNT];
+static uint16_t windowSamples = 0;
+static uint32_t windowEpoch = 0;
+static uint32_t windowSeq = 0;
+
+/**
+ * Ajoute un echantillon a la fenetre courante. Quand elle compte
+ * AGGREGATE_SAMPLES echantillons, remplit `out` avec le releve resume
+ * (moyenne par canal et statistiques) et retourne true.
+ */
+static bool aggregateSample(const Reading& sample, Reading& out) {
+  if (windowSamples == 0) {
+    for (int ch = 0; ch < CH_COUNT; ch++) {
+      window[ch].reset();
+    }
+    windowEpoch = 0;
+  }
+  if (windowEpoch == 0) {
+    windowEpoch = sample.epoch;  // Premier echantillon horodate de la fenetre
+  }
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    if (readingValid(sample, (Channel)ch)) {
+      window[ch].add(sample.value[ch]);
+    }
+  }
+  if (++windowSamples < AGGREGATE_SAMPLES) {
+    return false;
+  }
+  windowSamples = 0;
+
+  out = {};
+  out.seq = windowSeq++;
+  out.epoch = windowEpoch;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    const Welford& w = window[ch];
+    if (w.n == 0) {
+      continue;  // Canal invalide sur toute la fenetre
+    }
+    out.value[ch] = w.mean;
+    out.valid |= 1 << ch;
+    out.stats[ch] = {w.min, w.max, w.stddev(), (uint16_t)w.n};
+  }
+  return true;
+}
+#endif
+
+/**
+ * Tache d'acquisition : lecture de tous les capteurs et envoi a la tache
+ * reseau, directement ou resumes par fenetre (AGGREGATE_WINDOW).
+ */
+static void taskSample() {
+  STAGE_TIME(STAGE_SAMPLE);
+  Reading r;
+  acquireReading(r);
+#if ADAPTIVE_INTERVAL
+  acqScheduler.setPeriod(taskSample, acquisitionInterval());
+#endif
+#if AGGREGATE_WINDOW > 0
+  Reading summary;
+  if (!aggregateSample(r, summary)) {
+    return;
+  }
+  r = summary;
+#endif
+  if (acquisitionReport(r)) {
+    pushReading(r);
+  }
+}
+
+static void acquisitionTask(void*) {
+  acqScheduler.add("releve", taskSample, acquisitionInterval(), millis());
+  for (;;) {
+    uint32_t wait = acqScheduler.run(millis());
+    vTaskDelay(pdMS_TO_TICKS(wait > 0 ? wait : 1));
+  }
+}
+
+void acquisitionBegin() {
+  Sensors::begin();
+}
+
+void startAcquisition(QueueHandle_t queue) {
+  readingQueue = queue;
+  acquisitionBegin();
+  xTaskCreatePinnedToCore(acquisitionTask, "acquisition", ACQ_TASK_STACK, nullptr,
+                          ACQ_TASK_PRIO, nullptr, ACQ_TASK_CORE);
+}
+
+uint32_t acquisitionInterval() {
+#if ADAPTIVE_INTERVAL
+  return adaptive.intervalMs ? adaptive.intervalMs : READ_INTERVAL_MAX;
+#elif POWER_MODE == POWER_DEEP_SLEEP
+  return DEEP_SLEEP_INTERVAL;
+#else
+  return READ_INTERVAL;
+#endif
+}
+
+uint32_t acquisitionDropped() {
+  return queueDropped;
+}
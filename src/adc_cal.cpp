@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include "adc_cal.h"
+#include "log.h"
+
+#define ADC_CODES 4096
+
+#if ADC_CALIBRATION
+#include <esp_adc_cal.h>
+
+uint16_t adcCalTable[ADC_CODES];
+static const char* calSource = "default";
+
+void adcCalBegin() {
+  esp_adc_cal_characteristics_t chars;
+  esp_adc_cal_value_t source = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                                        ADC_CAL_DEFAULT_VREF, &chars);
+  calSource = (source == ESP_ADC_CAL_VAL_EFUSE_TP)   ? "efuse_tp"
+            : (source == ESP_ADC_CAL_VAL_EFUSE_VREF) ? "efuse_vref"
+                                                     : "default";
+  // Tensions d'abord, puis conversion en place
+  for (int raw = 0; raw < ADC_CODES; raw++) {
+    adcCalTable[raw] = (uint16_t)esp_adc_cal_raw_to_voltage(raw, &chars);
+  }
+  LOG_I("Calibration ADC (%s) : 0 -> %u mV, 4095 -> %u mV", calSource,
+        adcCalTable[0], adcCalTable[ADC_CODES - 1]);
+  adcCalBuild(adcCalTable, adcCalTable, ADC_SUPPLY_MV);
+}
+
+const char* adcCalSource() {
+  return calSource;
+}
+
+#else
+
+void adcCalBegin() {}
+
+const char* adcCalSource() {
+  return "off";
+}
+
+#endif
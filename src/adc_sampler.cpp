@@ -0,0 +1,129 @@
+/**
+ * Backends d'acquisition ADC pour les voies NTC (GPIO 34) et LDR (GPIO 35).
+ *
+ * - ONESHOT : analogRead() successifs espaces de 5 ms (~200 ms par canal).
+ * - DMA     : le controleur numerique de l'ADC1 scanne les deux canaux en
+ *             materiel a ADC_DMA_SAMPLE_FREQ et remplit un tampon DMA.
+ *             La tache ne fait que filtrer les trames recues : elle est
+ *             bloquee (CPU libre) pendant la conversion.
+ *
+ * Chaque echantillon est corrige par la table de calibration (adc_cal.h,
+ * une lecture par echantillon) puis passe par un SampleFilter
+ * (ADC_FILTER_NTC, ADC_FILTER_LDR) plutot qu'une simple moyenne.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "adc_cal.h"
+#include "adc_filter.h"
+#include "adc_sampler.h"
+
+static SampleFilter<ADC_FILTER_WINDOW> ntcFilter((AdcFilterKind)ADC_FILTER_NTC,
+                                                 ADC_FILTER_TRIM_PCT, ADC_FILTER_IIR_ALPHA);
+static SampleFilter<ADC_FILTER_WINDOW> ldrFilter((AdcFilterKind)ADC_FILTER_LDR,
+                                                 ADC_FILTER_TRIM_PCT, ADC_FILTER_IIR_ALPHA);
+
+#if ADC_BACKEND == ADC_BACKEND_DMA
+#include <driver/adc.h>
+
+// GPIO 34 = ADC1_CH6, GPIO 35 = ADC1_CH7
+#define NTC_ADC_CHANNEL ADC1_CHANNEL_6
+#define LDR_ADC_CHANNEL ADC1_CHANNEL_7
+
+static uint8_t dmaFrame[ADC_DMA_FRAME_BYTES];
+
+void adcSamplerBegin() {
+  adcCalBegin();
+  adc_digi_init_config_t initCfg = {};
+  initCfg.max_store_buf_size = ADC_DMA_FRAME_BYTES * 4;
+  initCfg.conv_num_each_intr = ADC_DMA_FRAME_BYTES;
+  initCfg.adc1_chan_mask = BIT(NTC_ADC_CHANNEL) | BIT(LDR_ADC_CHANNEL);
+  initCfg.adc2_chan_mask = 0;
+  ESP_ERROR_CHECK(adc_digi_initialize(&initCfg));
+
+  static adc_digi_pattern_config_t pattern[2] = {};
+  const adc_channel_t channels[2] = {(adc_channel_t)NTC_ADC_CHANNEL, (adc_channel_t)LDR_ADC_CHANNEL};
+  for (int i = 0; i < 2; i++) {
+    pattern[i].atten = ADC_ATTEN_DB_11;   // Plage 0-3.3V
+    pattern[i].channel = channels[i];
+    pattern[i].unit = 0;                  // ADC1
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_configuration_t digCfg = {};
+  digCfg.conv_limit_en = true;            // Obligatoire sur ESP32
+  digCfg.conv_limit_num = 250;
+  digCfg.pattern_num = 2;
+  digCfg.adc_pattern = pattern;
+  digCfg.sample_freq_hz = ADC_DMA_SAMPLE_FREQ;
+  digCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  digCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  ESP_ERROR_CHECK(adc_digi_controller_configure(&digCfg));
+}
+
+bool adcSamplerRead(AdcSample& out) {
+  SampleFilter<ADC_FILTER_WINDOW>* filters[2] = {&ntcFilter, &ldrFilter};
+  uint32_t count[2] = {0, 0};
+  ntcFilter.begin();
+  ldrFilter.begin();
+
+  // Salve a la demande : les donnees sont toujours fraiches, et le DMA
+  // ne tourne pas entre deux releves
+  adc_digi_start();
+  const uint32_t timeoutMs = ADC_DMA_TIMEOUT_MS;
+  uint32_t start = millis();
+  while ((count[0] < ADC_DMA_OVERSAMPLE || count[1] < ADC_DMA_OVERSAMPLE) &&
+         millis() - start < timeoutMs) {
+    uint32_t len = 0;
+    if (adc_digi_read_bytes(dmaFrame, sizeof(dmaFrame), &len, timeoutMs) != ESP_OK) {
+      continue;
+    }
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      const adc_digi_output_data_t* p = (const adc_digi_output_data_t*)&dmaFrame[i];
+      int idx = (p->type1.channel == NTC_ADC_CHANNEL) ? 0
+              : (p->type1.channel == LDR_ADC_CHANNEL) ? 1 : -1;
+      if (idx >= 0 && count[idx] < ADC_DMA_OVERSAMPLE) {
+        filters[idx]->add(adcCalQ4(p->type1.data));
+        count[idx]++;
+      }
+    }
+  }
+  adc_digi_stop();
+
+  if (count[0] == 0 || count[1] == 0) {
+    return false;
+  }
+  out.ntcRaw = ntcFilter.result() / ADC_CAL_FRAC;
+  out.ldrRaw = ldrFilter.result() / ADC_CAL_FRAC;
+  out.count = count[0] < count[1] ? count[0] : count[1];
+  return true;
+}
+
+#else  // ADC_BACKEND_ONESHOT
+
+/**
+ * Lecture analogique filtree pour eliminer le bruit de l'ADC ESP32.
+ * Effectue NB_SAMPLES lectures espacees de 5ms et retourne la valeur filtree.
+ */
+static float analogReadFiltered(int pin, SampleFilter<ADC_FILTER_WINDOW>& filter) {
+  filter.begin();
+  for (int i = 0; i < NB_SAMPLES; i++) {
+    filter.add(adcCalQ4(analogRead(pin)));
+    delay(5);
+  }
+  return filter.result() / ADC_CAL_FRAC;
+}
+
+void adcSamplerBegin() {
+  adcCalBegin();
+  analogSetAttenuation(ADC_11db);  // Plage 0-3.3V pour l'ADC
+}
+
+bool adcSamplerRead(AdcSample& out) {
+  out.ntcRaw = analogReadFiltered(TEMP_AO_PIN, ntcFilter);
+  out.ldrRaw = analogReadFiltered(LDR_PIN, ldrFilter);
+  out.count = NB_SAMPLES;
+  return true;
+}
+
+#endif
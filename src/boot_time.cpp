@@ -0,0 +1,26 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <time.h>
+#include "boot_time.h"
+#include "timebase.h"
+
+// Duree cumulee des deep sleeps, remise a zero a la mise sous tension
+static RTC_DATA_ATTR uint64_t sleptUs = 0;
+static BootClock bootClock;
+
+uint64_t monotonicUs() {
+  return sleptUs + esp_timer_get_time();
+}
+
+uint32_t stampNow() {
+  return epochStamp((uint32_t)time(nullptr), monotonicUs());
+}
+
+bool backfillEpochs(PackedReading* batch, uint16_t n) {
+  bootClock.observe((uint32_t)time(nullptr), monotonicUs());
+  return bootClock.resolve(batch, n);
+}
+
+void bootTimeSleep(uint64_t sleepUs) {
+  sleptUs += esp_timer_get_time() + sleepUs;
+}
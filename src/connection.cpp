@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+#include "connection.h"
+#include "log.h"
+#include "power.h"
+#include "wifi_fast.h"
+
+static inline bool reached(uint32_t now, uint32_t at) {
+  return (int32_t)(now - at) >= 0;
+}
+
+ConnectionManager::ConnectionManager(PubSubClient& mqtt)
+    : client_(mqtt),
+      wifiBackoff_(WIFI_BACKOFF_BASE, WIFI_BACKOFF_MAX),
+      mqttBackoff_(MQTT_BACKOFF_BASE, MQTT_BACKOFF_MAX) {}
+
+void ConnectionManager::step(uint32_t now) {
+  stepWifi(now);
+  stepMqtt(now);
+}
+
+void ConnectionManager::onWifiUp(uint32_t now) {
+  wifi_ = WIFI_UP;
+  wifiConnectMs_ = now - wifiStart_;
+  wifiBackoff_.reset();
+  wifiCacheStore();
+  LOG_I("Connecte ! IP : %s (%u ms, %s)", WiFi.localIP().toString().c_str(),
+        wifiConnectMs_, wifiFast_ ? "rapide" : "complete");
+  if (ntpEnabled_ && !ntpStarted_) {
+    // Synchronisation NTP (fuseau France) en arriere-plan
+    configTzTime(TZ_FRANCE, NTP_SERVER);
+    LOG_I("Synchronisation NTP...");
+    ntpStarted_ = true;
+  }
+}
+
+void ConnectionManager::stepWifi(uint32_t now) {
+  bool linked = WiFi.status() == WL_CONNECTED;
+  switch (wifi_) {
+    case WIFI_IDLE:
+      // L'auto-reconnexion du SDK est desactivee : c'est cette machine qui decide
+      WiFi.setAutoReconnect(false);
+      wifiStart_ = now;
+      wifiFast_ = wifiBeginFast();
+      if (!wifiFast_) {
+        wifiBeginFull();
+      }
+      wifi_ = wifiFast_ ? WIFI_CONNECTING_FAST : WIFI_CONNECTING_FULL;
+      break;
+
+    case WIFI_CONNECTING_FAST:
+      if (linked) {
+        onWifiUp(now);
+      } else if (now - wifiStart_ > WIFI_FAST_TIMEOUT) {
+        LOG_W("Echec connexion rapide, connexion complete");
+        wifiCacheInvalidate();
+        wifiFast_ = false;
+        wifiBeginFull();
+        wifi_ = WIFI_CONNECTING_FULL;
+      }
+      break;
+
+    case WIFI_CONNECTING_FULL:
+      if (linked) {
+        onWifiUp(now);
+      } else if (now - wifiStart_ > WIFI_CONNECT_TIMEOUT) {
+        WiFi.disconnect();
+        uint32_t wait = wifiBackoff_.next(esp_random());
+        LOG_W("Echec connexion (status: %d), nouvel essai dans %u ms",
+              WiFi.status(), wait);
+        wifiRetryAt_ = now + wait;
+        wifi_ = WIFI_BACKOFF;
+      }
+      break;
+
+    case WIFI_UP:
+      if (!linked) {
+        LOG_W("WiFi perdu, reconnexion...");
+        wifi_ = WIFI_IDLE;
+      }
+      break;
+
+    case WIFI_BACKOFF:
+      if (reached(now, wifiRetryAt_)) {
+        wifi_ = WIFI_IDLE;
+      }
+      break;
+  }
+}
+
+void ConnectionManager::stepMqtt(uint32_t now) {
+  if (wifi_ != WIFI_UP) {
+    if (mqtt_ == MQTT_UP) {
+      client_.disconnect();
+    }
+    mqtt_ = (mqtt_ == MQTT_BACKOFF) ? MQTT_BACKOFF : MQTT_DOWN;
+    return;
+  }
+
+  switch (mqtt_) {
+    case MQTT_DOWN: {
+      // Une seule tentative par pas, bornee par les timeouts TCP/TLS/CONNACK
+      LOG_I("Connexion MQTT a %s...", MQTT_SERVER);
+      PowerBoost boost;  // Handshake TLS
+      if (client_.connect(MQTT_DEVICE, MQTT_USER, MQTT_PASS)) {
+        LOG_I("MQTT connecte !");
+        mqttBackoff_.reset();
+        mqtt_ = MQTT_UP;
+      } else if (wifiFast_) {
+        // Adresse en cache peut-etre reattribuee (DNS, route) : DHCP puis nouvel essai
+        LOG_W("Echec MQTT (rc=%d) apres connexion rapide, connexion complete", client_.state());
+        wifiCacheInvalidate();
+        WiFi.disconnect();
+        wifiFast_ = false;
+        wifi_ = WIFI_IDLE;
+      } else {
+        uint32_t wait = mqttBackoff_.next(esp_random());
+        LOG_W("Echec MQTT (rc=%d), nouvel essai dans %u ms", client_.state(), wait);
+        mqttRetryAt_ = millis() + wait;
+        mqtt_ = MQTT_BACKOFF;
+      }
+      break;
+    }
+
+    case MQTT_UP:
+      if (!client_.connected()) {
+        LOG_W("MQTT perdu, reconnexion...");
+        mqtt_ = MQTT_DOWN;
+      }
+      break;
+
+    case MQTT_BACKOFF:
+      if (reached(now, mqttRetryAt_)) {
+        mqtt_ = MQTT_DOWN;
+      }
+      break;
+  }
+}
+
+uint32_t ConnectionManager::wifiRetryInMs(uint32_t now) const {
+  return (wifi_ == WIFI_BACKOFF && !reached(now, wifiRetryAt_)) ? wifiRetryAt_ - now : 0;
+}
+
+uint32_t ConnectionManager::mqttRetryInMs(uint32_t now) const {
+  return (mqtt_ == MQTT_BACKOFF && !reached(now, mqttRetryAt_)) ? mqttRetryAt_ - now : 0;
+}
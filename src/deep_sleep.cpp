@@ -0,0 +1,123 @@
+/**
+ * Mode deep sleep : accumulation des releves en memoire RTC.
+ *
+ * La memoire RTC lente (8 Ko) est conservee pendant le deep sleep, de meme
+ * que l'horloge systeme (timer RTC) : une fois l'heure NTP obtenue, les
+ * releves suivants sont horodates sans WiFi. NTP n'est resynchronise que
+ * toutes les DEEP_SLEEP_NTP_EVERY publications pour compenser la derive
+ * de l'oscillateur RTC. Avant la premiere heure connue, les releves portent
+ * un horodatage relatif (boot_time.h), complete a la publication.
+ */
+
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "acquisition.h"
+#include "boot_time.h"
+#include "deep_sleep.h"
+#include "log.h"
+#include "network.h"
+#include "power.h"
+#include "reading.h"
+#include "stage_stats.h"
+#include "timebase.h"
+
+#if POWER_MODE == POWER_DEEP_SLEEP
+
+static RTC_DATA_ATTR PackedReading rtcBatch[DEEP_SLEEP_RTC_LEN];
+static RTC_DATA_ATTR uint16_t rtcCount = 0;
+static RTC_DATA_ATTR uint32_t rtcDropped = 0;
+static RTC_DATA_ATTR uint16_t publishesSinceSync = 0;
+static RTC_DATA_ATTR bool timeSynced = false;
+
+/**
+ * Ajoute un releve au tampon RTC ; ecarte le plus ancien s'il est plein
+ * (publications echouees plusieurs fois de suite).
+ */
+static void rtcAppend(const Reading& r) {
+  if (rtcCount >= DEEP_SLEEP_RTC_LEN) {
+    memmove(&rtcBatch[0], &rtcBatch[1], (DEEP_SLEEP_RTC_LEN - 1) * sizeof(PackedReading));
+    rtcCount--;
+    rtcDropped++;
+  }
+  rtcBatch[rtcCount++] = packReading(r);
+}
+
+/**
+ * Publie le tampon RTC. Les releves publies sont retires, les autres
+ * restent pour le prochain reveil radio.
+ */
+static void publishBatch() {
+  PowerBoost boost;  // Session radio complete : WiFi, TLS, publication
+  bool syncTime = !timeSynced || publishesSinceSync >= DEEP_SLEEP_NTP_EVERY;
+  if (networkConnectOnce(syncTime)) {
+    if (syncTime) {
+      timeSynced = time(nullptr) >= (time_t)EPOCH_VALID_MIN;
+      publishesSinceSync = 0;
+    }
+    // Releves pris avant la premiere heure connue : horodates maintenant
+    bool stamped = backfillEpochs(rtcBatch, rtcCount);
+#if STATION_ROLE == ROLE_LEAF
+    (void)stamped;  // La passerelle complete les horodatages relatifs
+#else
+    if (!stamped && rtcCount + DEEP_SLEEP_BATCH < DEEP_SLEEP_RTC_LEN) {
+      LOG_I("Heure inconnue, publication reportee (%u releves)", rtcCount);
+      networkShutdown();
+      return;
+    }
+    clearRelativeEpochs(rtcBatch, rtcCount);
+#endif
+    uint16_t sent = networkPublishPacked(rtcBatch, rtcCount);
+    memmove(&rtcBatch[0], &rtcBatch[sent], (rtcCount - sent) * sizeof(PackedReading));
+    rtcCount -= sent;
+    publishesSinceSync++;
+    LOG_I("Lot publie : %u releves, %u en attente", sent, rtcCount);
+    if (sent > 0) {
+      networkPublishPower();  // Bilan depuis le lot precedent
+    }
+  } else {
+    LOG_I("Publication reportee, %u releves en attente", rtcCount);
+  }
+  networkShutdown();
+}
+
+void runDeepSleepCycle() {
+  // Le fuseau horaire (variable TZ) n'est pas conserve en deep sleep
+  setenv("TZ", TZ_FRANCE, 1);
+  tzset();
+#if WATCHDOG
+  // Hors etape (arret radio, attente entre deux etapes) : battement de boucle
+  stageWatchLoop(WATCHDOG_LOOP_STALL_MS);
+#endif
+
+  acquisitionBegin();
+  Reading r;
+  acquireReading(r);
+  if (acquisitionReport(r)) {
+    rtcAppend(r);
+  }
+
+  if (rtcCount >= DEEP_SLEEP_BATCH || !timeSynced) {
+    publishBatch();
+  }
+
+  // Periode de reveil (fixe ou adaptative) : on retire le temps passe eveille
+  uint64_t awakeUs = esp_timer_get_time();
+  uint64_t periodUs = (uint64_t)acquisitionInterval() * 1000ULL;
+  uint64_t sleepUs = awakeUs < periodUs ? periodUs - awakeUs : 1000ULL;
+  LOG_I("Deep sleep %llu ms (eveille %llu ms)", (unsigned long long)(sleepUs / 1000), (unsigned long long)(awakeUs / 1000));
+  logFlush();
+  bootTimeSleep(sleepUs);
+  powerDeepSleep(sleepUs);
+  esp_sleep_enable_timer_wakeup(sleepUs);
+  esp_deep_sleep_start();
+}
+
+#else
+
+void runDeepSleepCycle() {}
+
+#endif
@@ -0,0 +1,146 @@
+#include <Arduino.h>
+#include "config.h"
+#include "dht_decoder.h"
+#include "dht_sensor.h"
+
+#if DHT_TYPE == DHT11
+#define DHT_MIN_INTERVAL 1000   // Cadence max du capteur (ms)
+#define DHT_START_MS     20     // Signal de depart : >= 18 ms
+#else
+#define DHT_MIN_INTERVAL 2000
+#define DHT_START_MS     2      // Signal de depart : >= 1 ms
+#endif
+
+static DhtStats stats = {};
+static float cachedTemp = 0.0f;
+static float cachedHum = 0.0f;
+static bool cacheValid = false;
+static uint32_t lastGoodMs = 0;
+static uint32_t lastTriggerMs = 0;
+static bool triggered = false;
+
+#if DHT_BACKEND == DHT_BACKEND_RMT
+#include <driver/gpio.h>
+#include <driver/rmt.h>
+#include <freertos/ringbuf.h>
+
+// Une trame = 43 niveaux hauts et autant de bas, soit ~43 items : un bloc RMT (64)
+#define DHT_MAX_PULSES 128
+
+static RingbufHandle_t rmtRing = nullptr;
+
+void dhtSensorBegin() {
+  rmt_config_t cfg = RMT_DEFAULT_CONFIG_RX((gpio_num_t)DHT_PIN, (rmt_channel_t)DHT_RMT_CHANNEL);
+  cfg.clk_div = 80;                    // 1 tick = 1 us (APB 80 MHz)
+  cfg.mem_block_num = 1;
+  cfg.rx_config.idle_threshold = 200;  // Ligne au repos 200 us : fin de trame
+  cfg.rx_config.filter_en = true;
+  cfg.rx_config.filter_ticks_thresh = 100;  // Ignore les parasites < 1,25 us
+  ESP_ERROR_CHECK(rmt_config(&cfg));
+  ESP_ERROR_CHECK(rmt_driver_install((rmt_channel_t)DHT_RMT_CHANNEL, 512, 0));
+  rmt_get_ringbuf_handle((rmt_channel_t)DHT_RMT_CHANNEL, &rmtRing);
+  gpio_set_pull_mode((gpio_num_t)DHT_PIN, GPIO_PULLUP_ONLY);
+  gpio_set_direction((gpio_num_t)DHT_PIN, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_set_level((gpio_num_t)DHT_PIN, 1);
+}
+
+/**
+ * Emet le signal de depart, capture la trame par RMT et la decode.
+ */
+static DhtStatus readSensor(float& temp, float& hum) {
+  gpio_set_level((gpio_num_t)DHT_PIN, 0);
+  vTaskDelay(pdMS_TO_TICKS(DHT_START_MS));
+  // Liberation de la ligne au plus pres du debut de capture
+  rmt_rx_start((rmt_channel_t)DHT_RMT_CHANNEL, true);
+  gpio_set_level((gpio_num_t)DHT_PIN, 1);
+
+  size_t size = 0;
+  rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(rmtRing, &size,
+                                                          pdMS_TO_TICKS(DHT_FRAME_TIMEOUT));
+  rmt_rx_stop((rmt_channel_t)DHT_RMT_CHANNEL);
+  if (items == nullptr) {
+    return DHT_ERR_TIMEOUT;
+  }
+
+  static DhtPulse pulses[DHT_MAX_PULSES];
+  size_t n = 0;
+  size_t count = size / sizeof(rmt_item32_t);
+  for (size_t i = 0; i < count && n + 2 <= DHT_MAX_PULSES; i++) {
+    pulses[n++] = {(uint8_t)items[i].level0, (uint16_t)items[i].duration0};
+    pulses[n++] = {(uint8_t)items[i].level1, (uint16_t)items[i].duration1};
+  }
+  vRingbufferReturnItem(rmtRing, items);
+
+  uint8_t data[5];
+  DhtStatus status = dhtDecodeFrame(pulses, n, data);
+  if (status == DHT_OK) {
+    dhtConvert(data, DHT_TYPE, temp, hum);
+  }
+  return status;
+}
+
+#else  // DHT_BACKEND_LIB
+
+#include <DHT.h>
+
+static DHT dht(DHT_PIN, DHT_TYPE);
+
+void dhtSensorBegin() {
+  dht.begin();
+}
+
+/**
+ * Lecture par la bibliotheque Adafruit (bloquante), ramenee au meme
+ * contrat que le backend RMT. La cause d'un echec n'est pas exposee :
+ * il est compte comme trame invalide.
+ */
+static DhtStatus readSensor(float& temp, float& hum) {
+  hum = dht.readHumidity();
+  temp = dht.readTemperature();
+  return (isnan(hum) || isnan(temp)) ? DHT_ERR_FRAME : DHT_OK;
+}
+
+#endif
+
+bool dhtSensorRead(float& temp, float& hum) {
+  uint32_t now = millis();
+  if (triggered && now - lastTriggerMs < DHT_MIN_INTERVAL) {
+    // Plus rapide que le capteur : la valeur serait identique (ou l'acces refuse)
+    if (cacheValid) {
+      stats.cached++;
+      temp = cachedTemp;
+      hum = cachedHum;
+    }
+    return cacheValid;
+  }
+  triggered = true;
+  lastTriggerMs = now;
+
+  float t, h;
+  DhtStatus status = readSensor(t, h);
+  if (status == DHT_OK) {
+    cachedTemp = t;
+    cachedHum = h;
+    cacheValid = true;
+    lastGoodMs = now;
+    stats.reads++;
+  } else {
+    switch (status) {
+      case DHT_ERR_CHECKSUM: stats.checksumErrors++; break;
+      case DHT_ERR_TIMEOUT: stats.timeouts++; break;
+      default: stats.frameErrors++; break;
+    }
+    if (!cacheValid || now - lastGoodMs > DHT_STALE_MAX) {
+      cacheValid = false;
+      return false;
+    }
+    stats.cached++;
+  }
+  temp = cachedTemp;
+  hum = cachedHum;
+  return true;
+}
+
+const DhtStats& dhtSensorStats() {
+  return stats;
+}
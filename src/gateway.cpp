@@ -0,0 +1,173 @@
+/**
+ * Passerelle ESP-NOW : reception, acquittement et file de relais des
+ * trames des feuilles (voir include/gateway.h). Compile uniquement avec
+ * STATION_ROLE == ROLE_GATEWAY.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if STATION_ROLE == ROLE_GATEWAY
+
+#include <WiFi.h>
+#include <esp_now.h>
+#include <string.h>
+#include <time.h>
+#include "gateway.h"
+#include "log.h"
+#include "ring_buffer.h"
+#include "timebase.h"
+
+/** Trame brute copiee par le callback de reception. */
+struct RxFrame {
+  uint8_t mac[6];
+  uint8_t len;
+  uint8_t data[ESPNOW_FRAME_MAX];
+};
+
+/** Feuille connue : le nom fait l'identite, l'adresse MAC sert a l'acquittement. */
+struct Leaf {
+  char name[ESPNOW_DEVICE_MAX + 1];
+  uint8_t mac[6];
+  uint16_t lastSeq;
+  bool hasSeq;
+};
+
+static QueueHandle_t rxQueue = nullptr;
+static RingBuffer<RelayFrame, ESPNOW_RELAY_LEN> relay;
+static Leaf leaves[ESPNOW_MAX_LEAVES];
+static GatewayStats stats = {};
+static volatile uint32_t rxDropped = 0;
+
+static void onReceive(const uint8_t* mac, const uint8_t* data, int len) {
+  if (len <= 0 || len > ESPNOW_FRAME_MAX || espnowFrameType(data, len) != ESPNOW_READINGS) {
+    return;
+  }
+  RxFrame f;
+  memcpy(f.mac, mac, sizeof(f.mac));
+  f.len = len;
+  memcpy(f.data, data, len);
+  if (xQueueSend(rxQueue, &f, 0) != pdTRUE) {
+    rxDropped++;
+  }
+}
+
+void gatewayBegin() {
+  rxQueue = xQueueCreate(ESPNOW_RX_QUEUE_LEN, sizeof(RxFrame));
+  if (esp_now_init() != ESP_OK) {
+    LOG_E("Echec initialisation ESP-NOW, passerelle inactive");
+    return;
+  }
+  esp_now_register_recv_cb(onReceive);
+  // En modem sleep, la radio dort entre deux balises et perd des trames
+  WiFi.setSleep(false);
+  LOG_I("Passerelle ESP-NOW : MAC %s", WiFi.macAddress().c_str());
+}
+
+/** Index de la feuille `name`, enregistree au besoin ; -1 si la table est pleine. */
+static int findLeaf(const char* name, const uint8_t* mac) {
+  for (uint8_t i = 0; i < stats.leaves; i++) {
+    if (strcmp(leaves[i].name, name) == 0) {
+      memcpy(leaves[i].mac, mac, 6);
+      return i;
+    }
+  }
+  if (stats.leaves >= ESPNOW_MAX_LEAVES) {
+    return -1;
+  }
+  Leaf& l = leaves[stats.leaves];
+  strcpy(l.name, name);
+  memcpy(l.mac, mac, 6);
+  l.hasSeq = false;
+  LOG_I("Nouvelle feuille ESP-NOW : %s", name);
+  return stats.leaves++;
+}
+
+static void sendAck(const uint8_t* mac, uint16_t seq, bool accepted) {
+  if (!esp_now_is_peer_exist(mac)) {
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, 6);
+    peer.channel = 0;  // Canal courant (celui du point d'acces)
+    peer.ifidx = WIFI_IF_STA;
+    if (esp_now_add_peer(&peer) != ESP_OK) {
+      return;
+    }
+  }
+  time_t now = time(nullptr);
+  uint8_t buf[ESPNOW_ACK_SIZE];
+  size_t n = espnowEncodeAck(buf, sizeof(buf), seq,
+                             now >= (time_t)EPOCH_VALID_MIN ? (uint32_t)now : 0, accepted);
+  esp_now_send(mac, buf, n);
+}
+
+void gatewayPoll() {
+  if (rxQueue == nullptr) {
+    return;
+  }
+  stats.rxDropped = rxDropped;
+  RxFrame rx;
+  while (xQueueReceive(rxQueue, &rx, 0) == pdTRUE) {
+    RelayFrame f;
+    char name[ESPNOW_DEVICE_MAX + 1];
+    uint16_t seq, count;
+    uint32_t clock;
+    if (!espnowDecodeReadings(rx.data, rx.len, seq, clock, name, f.readings,
+                              ESPNOW_FRAME_READINGS, count)) {
+      stats.invalid++;
+      continue;
+    }
+    int leaf = findLeaf(name, rx.mac);
+    if (leaf < 0) {
+      LOG_W("Table des feuilles pleine, %s ignoree", name);
+      stats.rejected++;
+      sendAck(rx.mac, seq, false);
+      continue;
+    }
+    Leaf& l = leaves[leaf];
+    if (l.hasSeq && l.lastSeq == seq) {
+      // Acquittement perdu : la trame est deja dans la file ou publiee
+      stats.duplicates++;
+      sendAck(rx.mac, seq, true);
+      continue;
+    }
+    // Releves d'une feuille encore sans heure : dates par rapport a son horloge
+    uint32_t now = (uint32_t)time(nullptr);
+    for (uint16_t i = 0; i < count; i++) {
+      f.readings[i].epoch = epochFromPeer(f.readings[i].epoch, clock, now);
+    }
+    f.leaf = leaf;
+    f.count = count;
+    if (!relay.push(f)) {
+      stats.rejected++;
+      sendAck(rx.mac, seq, false);
+      continue;
+    }
+    l.lastSeq = seq;
+    l.hasSeq = true;
+    stats.frames++;
+    sendAck(rx.mac, seq, true);
+    LOG_D("ESP-NOW : %u releves de %s", count, name);
+  }
+}
+
+uint16_t gatewayPending() {
+  return relay.size();
+}
+
+bool gatewayPeek(uint16_t i, RelayFrame& out) {
+  return relay.peek(out, i);
+}
+
+void gatewayConsume(uint32_t n) {
+  relay.drop(n);
+}
+
+const char* gatewayLeafName(uint8_t leaf) {
+  return leaf < stats.leaves ? leaves[leaf].name : "";
+}
+
+const GatewayStats& gatewayStats() {
+  return stats;
+}
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Historique sur flash : acces a la partition HISTORY_PARTITION pour le
+ * journal de lib/MeteoCore/src/history_log.h (voir include/history.h).
+ * Compile uniquement avec HISTORY_LOG.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if HISTORY_LOG
+
+#include <esp_partition.h>
+#include <stdio.h>
+#include "boot_time.h"
+#include "history.h"
+#include "log.h"
+#include "ring_buffer.h"
+#include "timebase.h"
+
+/** Partition projetee en memoire ; les ecritures invalident le cache de la plage. */
+class EspPartitionFlash : public HistoryFlash {
+ public:
+  bool begin() {
+    part_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                     HISTORY_PARTITION);
+    if (part_ == nullptr) {
+      return false;
+    }
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(part_, 0, part_->size, ESP_PARTITION_MMAP_DATA, &ptr, &map_) !=
+        ESP_OK) {
+      part_ = nullptr;
+      return false;
+    }
+    data_ = (const uint8_t*)ptr;
+    return true;
+  }
+
+  const uint8_t* data() const override { return data_; }
+  uint32_t size() const override { return part_ ? part_->size : 0; }
+  bool erase(uint32_t offset) override {
+    return esp_partition_erase_range(part_, offset, HISTORY_SECTOR_SIZE) == ESP_OK;
+  }
+  bool write(uint32_t offset, const void* src, uint32_t len) override {
+    return esp_partition_write(part_, offset, src, len) == ESP_OK;
+  }
+
+ private:
+  const esp_partition_t* part_ = nullptr;
+  esp_partition_mmap_handle_t map_ = 0;
+  const uint8_t* data_ = nullptr;
+};
+
+static EspPartitionFlash flash;
+static HistoryLog journal(flash);
+static bool ready = false;
+static uint32_t unstamped = 0;
+// Releves pris avant l'heure connue, dans l'ordre : ecrits une fois horodates
+static RingBuffer<PackedReading, HISTORY_PENDING_LEN> pending;
+
+bool historyBegin() {
+  if (!flash.begin()) {
+    LOG_W("Partition \"%s\" absente, historique desactive", HISTORY_PARTITION);
+    return false;
+  }
+  ready = journal.begin();
+  if (!ready) {
+    LOG_W("Partition \"%s\" trop petite, historique desactive", HISTORY_PARTITION);
+    return false;
+  }
+  LOG_I("Historique : %u/%u releves, %u secteurs", journal.records(), journal.capacity(),
+        journal.sectors());
+  if (journal.corrupt() > 0) {
+    LOG_W("Historique : %u enregistrement(s) interrompu(s) ignore(s)", journal.corrupt());
+  }
+  return true;
+}
+
+static void writeRecord(const PackedReading& p) {
+  if (p.epoch < EPOCH_VALID_MIN) {
+    unstamped++;  // Sans heure UNIX, introuvable par plage
+    return;
+  }
+  if (!journal.append(p)) {
+    LOG_W("Historique : echec d'ecriture flash");
+  }
+}
+
+void historyAppend(const Reading& r) {
+  if (!ready) {
+    return;
+  }
+  // Heure connue depuis : les releves en attente passent d'abord, dans l'ordre
+  PackedReading q;
+  while (pending.peek(q) && backfillEpochs(&q, 1)) {
+    writeRecord(q);
+    pending.drop(1);
+  }
+  PackedReading p = packReading(r);
+  if (!pending.empty() || !backfillEpochs(&p, 1)) {
+    if (pending.pushOverwrite(p)) {
+      unstamped++;  // Attente trop longue : le plus ancien est perdu
+    }
+    return;
+  }
+  writeRecord(p);
+}
+
+HistoryCursor historySeek(uint32_t from) {
+  if (!ready) {
+    return HistoryCursor{0, 0, 0, true};
+  }
+  return journal.seek(from);
+}
+
+uint16_t historyRead(HistoryCursor& c, uint32_t from, uint32_t to, PackedReading* out,
+                     uint16_t max) {
+  if (!ready) {
+    c.done = true;
+    return 0;
+  }
+  return journal.read(c, from, to, out, max);
+}
+
+size_t historyJson(char* buf, size_t len) {
+  int n = snprintf(buf, len,
+                   "\"history\":{\"records\":%u,\"capacity\":%u,\"oldest\":%u,\"newest\":%u,"
+                   "\"erases\":%u,\"corrupt\":%u,\"flash_errors\":%u,\"unstamped\":%u}",
+                   journal.records(), journal.capacity(), journal.oldestEpoch(),
+                   journal.newestEpoch(), journal.erases(), journal.corrupt(),
+                   journal.flashErrors(), unstamped);
+  if (n < 0 || (size_t)n >= len) {
+    return 0;
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,270 @@
+/**
+ * Station feuille ESP-NOW (STATION_ROLE == ROLE_LEAF) : implementation de
+ * network.h sans WiFi, TLS ni MQTT.
+ *
+ * Les releves sont envoyes par trames (espnow_frame.h) a la passerelle,
+ * qui les publie pour le compte de la feuille. Chaque trame attend son
+ * acquittement (ESPNOW_ACK_TIMEOUT) ; sans reponse ou si la passerelle la
+ * refuse, elle est renvoyee sous le meme numero avec une attente exponentielle.
+ * Les releves restent dans le tampon de coupure jusqu'a l'acquittement.
+ *
+ * L'acquittement porte l'heure de la passerelle, qui remplace NTP, et son
+ * adresse MAC : une feuille configuree en diffusion passe ensuite en unicast.
+ * Les releves pris avant le premier acquittement sont dates par la
+ * passerelle, d'apres l'horloge monotone jointe a chaque trame.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if STATION_ROLE == ROLE_LEAF
+
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "backoff.h"
+#include "boot_time.h"
+#include "espnow_frame.h"
+#include "log.h"
+#include "network.h"
+#include "outage_buffer.h"
+#include "reading.h"
+#include "timebase.h"
+
+/** Acquittement recu, copie par le callback de reception. */
+struct AckMsg {
+  uint8_t mac[6];
+  uint16_t seq;
+  uint32_t epoch;
+  bool accepted;
+};
+
+/** Trame en cours d'envoi : renvoyee sous le meme numero jusqu'a l'acquittement. */
+struct PendingFrame {
+  uint8_t data[ESPNOW_FRAME_MAX];
+  size_t len;
+  uint16_t seq;
+  uint16_t count;
+};
+
+// Conserves en deep sleep : passerelle apprise et numerotation des trames
+static RTC_DATA_ATTR uint8_t gatewayMac[6] = {ESPNOW_GATEWAY_MAC};
+static RTC_DATA_ATTR uint16_t frameSeq = 0;
+static RTC_DATA_ATTR bool seqSeeded = false;
+
+static QueueHandle_t ackQueue = nullptr;
+static QueueHandle_t readingQueue = nullptr;
+static bool radioUp = false;
+
+static void onReceive(const uint8_t* mac, const uint8_t* data, int len) {
+  AckMsg a;
+  if (len <= 0 || !espnowDecodeAck(data, len, a.seq, a.epoch, a.accepted)) {
+    return;
+  }
+  memcpy(a.mac, mac, sizeof(a.mac));
+  xQueueSend(ackQueue, &a, 0);
+}
+
+static bool addPeer(const uint8_t* mac) {
+  if (esp_now_is_peer_exist(mac)) {
+    return true;
+  }
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = ESPNOW_CHANNEL;
+  peer.ifidx = WIFI_IF_STA;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+/** Radio en STA sans association, fixee sur le canal de la passerelle. */
+static bool radioBegin() {
+  if (radioUp) {
+    return true;
+  }
+  if (ackQueue == nullptr) {
+    ackQueue = xQueueCreate(4, sizeof(AckMsg));
+  }
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_promiscuous(true);
+  esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  esp_wifi_set_promiscuous(false);
+  if (esp_now_init() != ESP_OK) {
+    LOG_E("Echec initialisation ESP-NOW");
+    return false;
+  }
+  esp_now_register_recv_cb(onReceive);
+  if (!addPeer(gatewayMac)) {
+    LOG_E("Echec ajout de la passerelle ESP-NOW");
+    esp_now_deinit();
+    return false;
+  }
+  if (!seqSeeded) {
+    // Une feuille redemarree ne reprend pas le dernier numero vu par la passerelle
+    frameSeq = esp_random();
+    seqSeeded = true;
+  }
+  radioUp = true;
+  return true;
+}
+
+/** Passe en unicast vers la passerelle qui a repondu. */
+static void learnGateway(const uint8_t* mac) {
+  if (memcmp(mac, gatewayMac, 6) == 0 || !addPeer(mac)) {
+    return;
+  }
+  esp_now_del_peer(gatewayMac);
+  memcpy(gatewayMac, mac, 6);
+  LOG_I("Passerelle ESP-NOW : %02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3],
+        mac[4], mac[5]);
+}
+
+/** Regle l'horloge sur celle de la passerelle si l'ecart depasse 2 s. */
+static void syncClock(uint32_t epoch) {
+  if (epoch < EPOCH_VALID_MIN) {
+    return;
+  }
+  time_t now = time(nullptr);
+  if (now >= (time_t)EPOCH_VALID_MIN && labs((long)(now - (time_t)epoch)) <= 2) {
+    return;
+  }
+  timeval tv = {(time_t)epoch, 0};
+  settimeofday(&tv, nullptr);
+  LOG_I("Heure reglee par la passerelle");
+}
+
+/** Encode au plus une trame des releves de `batch` sous un nouveau numero. */
+static bool buildFrame(const PackedReading* batch, uint16_t n, PendingFrame& f) {
+  f.seq = ++frameSeq;
+  f.len = espnowEncodeReadings(f.data, sizeof(f.data), f.seq, 0 /* sendFrame */, MQTT_DEVICE,
+                               batch, n, f.count);
+  return f.len > 0;
+}
+
+/** Envoie la trame et attend son acquittement. Retourne true si acceptee. */
+static bool sendFrame(PendingFrame& f) {
+  // Horloge a jour a chaque envoi : les releves relatifs sont dates a la reception
+  espnowSetClock(f.data, f.len, epochStamp(0, monotonicUs()));
+  xQueueReset(ackQueue);
+  if (esp_now_send(gatewayMac, f.data, f.len) != ESP_OK) {
+    return false;
+  }
+  uint32_t start = millis();
+  uint32_t elapsed;
+  AckMsg a;
+  while ((elapsed = millis() - start) < ESPNOW_ACK_TIMEOUT) {
+    if (xQueueReceive(ackQueue, &a, pdMS_TO_TICKS(ESPNOW_ACK_TIMEOUT - elapsed)) != pdTRUE) {
+      break;
+    }
+    if (a.seq != f.seq) {
+      continue;  // Acquittement tardif d'une trame precedente
+    }
+    learnGateway(a.mac);
+    syncClock(a.epoch);
+    if (!a.accepted) {
+      LOG_W("Trame %u refusee par la passerelle", f.seq);
+    }
+    return a.accepted;
+  }
+  return false;
+}
+
+/**
+ * Tache reseau de la feuille : transfere la file des releves dans le tampon
+ * de coupure et envoie les plus anciens, une trame a la fois. Une trame
+ * acquittee est aussitot suivie de la suivante ; un echec reporte l'envoi
+ * (1 s a ESPNOW_RETRY_MAX).
+ */
+static void leafTask(void*) {
+  static OutageBuffer outage;
+  static PendingFrame frame = {};
+  static PackedReading batch[ESPNOW_FRAME_READINGS];
+  Backoff backoff(1000, ESPNOW_RETRY_MAX);
+  uint32_t retryAt = millis();
+  uint32_t seenEvicted = 0;
+  outage.begin();
+
+  for (;;) {
+    TickType_t wait = portMAX_DELAY;
+    if (outage.depth() > 0) {
+      int32_t left = (int32_t)(retryAt - millis());
+      wait = left > 0 ? pdMS_TO_TICKS(left) : 0;
+    }
+    Reading r;
+    if (xQueueReceive(readingQueue, &r, wait) == pdTRUE) {
+      do {
+        outage.push(r);
+      } while (xQueueReceive(readingQueue, &r, 0) == pdTRUE);
+    }
+    if (outage.evicted() != seenEvicted) {
+      // Releves de la trame en cours ecartes en tete : nouvelle trame
+      frame.len = 0;
+      seenEvicted = outage.evicted();
+    }
+    if (outage.depth() == 0 || (int32_t)(millis() - retryAt) < 0) {
+      continue;
+    }
+    if (frame.len == 0) {
+      uint16_t n = outage.peekBatch(batch, ESPNOW_FRAME_READINGS);
+      backfillEpochs(batch, n);  // Heure recue d'un acquittement precedent
+      if (n == 0 || outage.evicted() != seenEvicted || !buildFrame(batch, n, frame)) {
+        continue;
+      }
+    }
+    if (radioBegin() && sendFrame(frame)) {
+      outage.consume(frame.count);
+      LOG_D("Trame %u acquittee (%u releves, %u en attente)", frame.seq, frame.count,
+            (unsigned)outage.depth());
+      frame.len = 0;
+      backoff.reset();
+      retryAt = millis();
+    } else {
+      uint32_t delayMs = backoff.next(esp_random());
+      retryAt = millis() + delayMs;
+      LOG_D("Passerelle muette, nouvel essai dans %u ms", delayMs);
+    }
+  }
+}
+
+void startNetwork(QueueHandle_t queue) {
+  readingQueue = queue;
+  xTaskCreatePinnedToCore(leafTask, "network", NET_TASK_STACK, nullptr, NET_TASK_PRIO,
+                          nullptr, NET_TASK_CORE);
+}
+
+bool networkConnectOnce(bool) {
+  // Pas de NTP : l'heure arrive avec le premier acquittement
+  return radioBegin();
+}
+
+uint16_t networkPublishPacked(const PackedReading* batch, uint16_t n) {
+  static PendingFrame frame;
+  uint16_t acked = 0;
+  while (acked < n && buildFrame(batch + acked, n - acked, frame)) {
+    bool ok = false;
+    for (uint8_t attempt = 0; attempt < 3 && !ok; attempt++) {
+      ok = sendFrame(frame);
+    }
+    if (!ok) {
+      break;
+    }
+    acked += frame.count;
+  }
+  return acked;
+}
+
+void networkPublishPower() {
+  // Pas de MQTT : le bilan de la feuille n'est visible que sur le journal serie
+}
+
+void networkShutdown() {
+  if (radioUp) {
+    esp_now_deinit();
+    radioUp = false;
+  }
+  WiFi.mode(WIFI_OFF);
+}
+
+#endif
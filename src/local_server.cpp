@@ -0,0 +1,254 @@
+/**
+ * Serveur local HTTP/WebSocket (voir include/local_server.h). Compile
+ * uniquement avec LOCAL_SERVER.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if LOCAL_SERVER
+
+#include <WiFi.h>
+#include <esp_http_server.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <stdio.h>
+#include <string.h>
+#include "boot_time.h"
+#include "local_server.h"
+#include "log.h"
+#include "payload.h"
+#include "ring_buffer.h"
+#include "timebase.h"
+
+#if !CONFIG_HTTPD_WS_SUPPORT
+#error "LOCAL_SERVER requiert CONFIG_HTTPD_WS_SUPPORT (esp_http_server avec WebSocket)"
+#endif
+
+/** Releve rendu pour /ws, copie dans la file d'envoi. */
+struct LiveFrame {
+  uint16_t len;
+  char data[LOCAL_FRAME_MAX];
+};
+
+/** Rendu partage entre la tache reseau (ecriture) et la tache du serveur (lecture). */
+struct Snapshot {
+  char data[MQTT_BUFFER_SIZE];
+  size_t len;
+};
+
+static httpd_handle_t server = nullptr;
+static QueueHandle_t frameQueue = nullptr;
+static SemaphoreHandle_t snapshotLock = nullptr;
+static Snapshot recentSnap = {};
+static Snapshot diagSnap = {};
+static RingBuffer<PackedReading, LOCAL_RECENT_LEN> recent;  // Tache reseau uniquement
+
+static volatile uint16_t wsClients = 0;
+static volatile uint32_t framesSent = 0;
+static volatile uint32_t sendErrors = 0;
+static volatile uint32_t requests = 0;
+static uint32_t framesDropped = 0;
+
+// Le lecteur ne garde le verrou que le temps d'une copie
+#define SNAPSHOT_LOCK_WAIT pdMS_TO_TICKS(5)
+
+static const char PAGE[] =
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>" MQTT_DEVICE "</title></head>"
+    "<body><h1>" MQTT_DEVICE "</h1><p><a href=\"/recent\">recent</a> - <a href=\"/diag\">diag</a>"
+    "</p><pre id=\"r\">En attente du prochain releve...</pre><script>"
+    "var w=new WebSocket('ws://'+location.host+'/ws');"
+    "w.onmessage=function(e){document.getElementById('r').textContent="
+    "JSON.stringify(JSON.parse(e.data),null,2)};"
+    "w.onclose=function(){document.getElementById('r').textContent+='\\n(deconnecte)'};"
+    "</script></body></html>";
+
+static void setSnapshot(Snapshot& s, const char* data, size_t len) {
+  if (len > sizeof(s.data) || xSemaphoreTake(snapshotLock, SNAPSHOT_LOCK_WAIT) != pdTRUE) {
+    return;  // Rendu precedent conserve
+  }
+  memcpy(s.data, data, len);
+  s.len = len;
+  xSemaphoreGive(snapshotLock);
+}
+
+/** Copie le rendu hors verrou puis l'envoie : un client lent ne bloque pas l'ecrivain. */
+static esp_err_t sendSnapshot(httpd_req_t* req, const Snapshot& s) {
+  static char copy[sizeof(Snapshot::data)];  // Gestionnaires executes par la seule tache du serveur
+  size_t len = 0;
+  requests++;
+  if (xSemaphoreTake(snapshotLock, pdMS_TO_TICKS(100)) == pdTRUE) {
+    len = s.len;
+    memcpy(copy, s.data, len);
+    xSemaphoreGive(snapshotLock);
+  }
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  if (len == 0) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "{}", 2);
+  }
+  return httpd_resp_send(req, copy, len);
+}
+
+static esp_err_t onPage(httpd_req_t* req) {
+  requests++;
+  httpd_resp_set_type(req, "text/html");
+  return httpd_resp_send(req, PAGE, sizeof(PAGE) - 1);
+}
+
+static esp_err_t onRecent(httpd_req_t* req) {
+  return sendSnapshot(req, recentSnap);
+}
+
+static esp_err_t onDiag(httpd_req_t* req) {
+  return sendSnapshot(req, diagSnap);
+}
+
+/** Poignee de main (GET), puis messages du client : lus et ignores. */
+static esp_err_t onWs(httpd_req_t* req) {
+  if (req->method == HTTP_GET) {
+    LOG_I("Client WebSocket connecte");
+    return ESP_OK;
+  }
+  uint8_t buf[64];
+  httpd_ws_frame_t f = {};
+  f.payload = buf;
+  esp_err_t err = httpd_ws_recv_frame(req, &f, 0);  // Longueur seule
+  if (err != ESP_OK || f.len == 0) {
+    return err;
+  }
+  if (f.len > sizeof(buf)) {
+    return ESP_FAIL;  // Ferme la connexion
+  }
+  return httpd_ws_recv_frame(req, &f, f.len);
+}
+
+/**
+ * Envoie les releves en attente a chaque client WebSocket (tache du
+ * serveur, via httpd_queue_work). Un client en echec est deconnecte.
+ */
+static void broadcastFrames(void*) {
+  LiveFrame frame;
+  while (xQueueReceive(frameQueue, &frame, 0) == pdTRUE) {
+    int fds[LOCAL_MAX_SOCKETS];
+    size_t n = LOCAL_MAX_SOCKETS;
+    if (httpd_get_client_list(server, &n, fds) != ESP_OK) {
+      return;
+    }
+    httpd_ws_frame_t f = {};
+    f.final = true;
+    f.type = HTTPD_WS_TYPE_TEXT;
+    f.payload = (uint8_t*)frame.data;
+    f.len = frame.len;
+    uint16_t clients = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (httpd_ws_get_fd_info(server, fds[i]) != HTTPD_WS_CLIENT_WEBSOCKET) {
+        continue;
+      }
+      clients++;
+      if (httpd_ws_send_frame_async(server, fds[i], &f) == ESP_OK) {
+        framesSent++;
+      } else {
+        sendErrors++;
+        httpd_sess_trigger_close(server, fds[i]);
+      }
+    }
+    wsClients = clients;
+  }
+}
+
+void localServerBegin() {
+  if (server != nullptr) {
+    return;
+  }
+  frameQueue = xQueueCreate(LOCAL_FRAME_QUEUE, sizeof(LiveFrame));
+  snapshotLock = xSemaphoreCreateMutex();
+  httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
+  cfg.server_port = LOCAL_SERVER_PORT;
+  cfg.max_open_sockets = LOCAL_MAX_SOCKETS;
+  cfg.lru_purge_enable = true;  // Un nouveau client remplace le plus ancien inactif
+  cfg.send_wait_timeout = LOCAL_SEND_TIMEOUT_S;
+  cfg.recv_wait_timeout = LOCAL_SEND_TIMEOUT_S;
+  cfg.stack_size = LOCAL_TASK_STACK;
+  cfg.task_priority = LOCAL_TASK_PRIO;
+  cfg.core_id = NET_TASK_CORE;
+  if (frameQueue == nullptr || snapshotLock == nullptr || httpd_start(&server, &cfg) != ESP_OK) {
+    server = nullptr;
+    LOG_E("Serveur local indisponible");
+    return;
+  }
+  httpd_uri_t page = {};
+  page.uri = "/";
+  page.method = HTTP_GET;
+  page.handler = onPage;
+  httpd_register_uri_handler(server, &page);
+  page.uri = "/recent";
+  page.handler = onRecent;
+  httpd_register_uri_handler(server, &page);
+  page.uri = "/diag";
+  page.handler = onDiag;
+  httpd_register_uri_handler(server, &page);
+  page.uri = "/ws";
+  page.handler = onWs;
+  page.is_websocket = true;
+  httpd_register_uri_handler(server, &page);
+  LOG_I("Serveur local : http://%s:%u/", WiFi.localIP().toString().c_str(), LOCAL_SERVER_PORT);
+}
+
+void localServerPush(const Reading& r) {
+  if (server == nullptr) {
+    return;
+  }
+  PackedReading p = packReading(r);
+  if (!backfillEpochs(&p, 1)) {
+    clearRelativeEpochs(&p, 1);  // Heure encore inconnue : releve sans horodatage
+  }
+  recent.pushOverwrite(p);
+
+  // Un seul rendu, envoye tel quel a tous les clients WebSocket
+  LiveFrame frame;
+  frame.len = formatReadingJson(frame.data, sizeof(frame.data), p);
+  if (frame.len > 0) {
+    if (xQueueSend(frameQueue, &frame, 0) == pdTRUE) {
+      httpd_queue_work(server, broadcastFrames, nullptr);
+    } else {
+      framesDropped++;
+    }
+  }
+
+  static PackedReading batch[LOCAL_RECENT_LEN];
+  static char json[sizeof(Snapshot::data)];
+  uint16_t n = recent.size();
+  for (uint16_t i = 0; i < n; i++) {
+    recent.peek(batch[i], i);
+  }
+  uint16_t count;
+  size_t len = formatBatchJson(json, sizeof(json), batch, n, count);
+  if (len > 0 && count < n) {
+    // Tampon trop petit : on garde les plus recents
+    len = formatBatchJson(json, sizeof(json), batch + (n - count), count, count);
+  }
+  if (len > 0) {
+    setSnapshot(recentSnap, json, len);
+  }
+}
+
+void localServerSetDiag(const char* json, size_t len) {
+  if (server != nullptr) {
+    setSnapshot(diagSnap, json, len);
+  }
+}
+
+size_t localServerJson(char* buf, size_t len) {
+  int n = snprintf(buf, len,
+                   "\"local\":{\"ws_clients\":%u,\"frames_sent\":%u,\"frames_dropped\":%u,"
+                   "\"send_errors\":%u,\"requests\":%u}",
+                   wsClients, framesSent, framesDropped, sendErrors, requests);
+  if (n < 0 || (size_t)n >= len) {
+    return 0;
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include "log.h"
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define LOG_CHUNK 64   // Octets copies hors verrou puis ecrits sur l'UART
+
+static char ring[LOG_BUFFER_SIZE];
+static size_t head = 0;    // Prochaine ecriture
+static size_t used = 0;
+static uint32_t dropped = 0;
+static volatile bool writing = false;  // Bloc retire mais pas encore ecrit
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t drainTask = nullptr;
+
+void logWrite(const char* fmt, ...) {
+  char line[LOG_LINE_MAX];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(line, sizeof(line) - 1, fmt, args);
+  va_end(args);
+  if (n < 0) {
+    return;
+  }
+  if ((size_t)n > sizeof(line) - 2) {
+    n = sizeof(line) - 2;  // Message tronque
+  }
+  line[n++] = '\n';
+
+  bool stored = false;
+  portENTER_CRITICAL(&logMux);
+  if (LOG_BUFFER_SIZE - used >= (size_t)n) {
+    size_t first = LOG_BUFFER_SIZE - head < (size_t)n ? LOG_BUFFER_SIZE - head : n;
+    memcpy(ring + head, line, first);
+    memcpy(ring, line + first, n - first);
+    head = (head + n) % LOG_BUFFER_SIZE;
+    used += n;
+    stored = true;
+  } else {
+    dropped++;
+  }
+  portEXIT_CRITICAL(&logMux);
+  if (stored && drainTask != nullptr) {
+    xTaskNotifyGive(drainTask);
+  }
+}
+
+/**
+ * Retire jusqu'a LOG_CHUNK octets contigus du tampon. Retourne leur nombre.
+ */
+static size_t takeChunk(char* out) {
+  portENTER_CRITICAL(&logMux);
+  size_t tail = (head + LOG_BUFFER_SIZE - used) % LOG_BUFFER_SIZE;
+  size_t n = used < LOG_CHUNK ? used : LOG_CHUNK;
+  if (n > LOG_BUFFER_SIZE - tail) {
+    n = LOG_BUFFER_SIZE - tail;
+  }
+  memcpy(out, ring + tail, n);
+  used -= n;
+  writing = n > 0;
+  portEXIT_CRITICAL(&logMux);
+  return n;
+}
+
+/**
+ * Tache de vidage : seule a ecrire sur l'UART, elle peut y attendre
+ * sans retarder l'acquisition ni le reseau.
+ */
+static void logTask(void*) {
+  uint32_t reported = 0;
+  char chunk[LOG_CHUNK];
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    size_t n;
+    while ((n = takeChunk(chunk)) > 0) {
+      Serial.write((const uint8_t*)chunk, n);
+      writing = false;
+    }
+    uint32_t lost = dropped;
+    if (lost != reported) {
+      Serial.printf("[journal] %u messages perdus\n", lost - reported);
+      reported = lost;
+    }
+  }
+}
+
+void logBegin() {
+  if (drainTask == nullptr) {
+    xTaskCreatePinnedToCore(logTask, "journal", LOG_TASK_STACK, nullptr, LOG_TASK_PRIO,
+                            &drainTask, LOG_TASK_CORE);
+  }
+}
+
+void logFlush(uint32_t timeoutMs) {
+  if (drainTask == nullptr) {
+    // Tache non demarree : vidage direct
+    char chunk[LOG_CHUNK];
+    size_t n;
+    while ((n = takeChunk(chunk)) > 0) {
+      Serial.write((const uint8_t*)chunk, n);
+    }
+    writing = false;
+  } else {
+    uint32_t start = millis();
+    while ((used > 0 || writing) && millis() - start < timeoutMs) {
+      xTaskNotifyGive(drainTask);
+      vTaskDelay(1);
+    }
+  }
+  Serial.flush();
+}
+
+uint32_t logDropped() {
+  return dropped;
+}
+
+#endif
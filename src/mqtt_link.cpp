@@ -0,0 +1,48 @@
+#include "mqtt_link.h"
+#include "log.h"
+
+int MqttLink::connect(IPAddress ip, uint16_t port) {
+  parser_.reset();
+  acks_.clear();
+  return inner_.connect(ip, port);
+}
+
+int MqttLink::connect(const char* host, uint16_t port) {
+  parser_.reset();
+  acks_.clear();
+  return inner_.connect(host, port);
+}
+
+int MqttLink::read() {
+  int b = inner_.read();
+  if (b >= 0) {
+    feed((uint8_t)b);
+  }
+  return b;
+}
+
+int MqttLink::read(uint8_t* buf, size_t size) {
+  int n = inner_.read(buf, size);
+  for (int i = 0; i < n; i++) {
+    feed(buf[i]);
+  }
+  return n;
+}
+
+void MqttLink::feed(uint8_t b) {
+  uint16_t id;
+  if (parser_.feed(b, id) && !acks_.push(id)) {
+    acksDropped_++;
+  }
+}
+
+bool MqttLink::publishQos1(const char* topic, const uint8_t* payload, size_t len,
+                           uint16_t packetId, bool dup) {
+  uint8_t header[MQTT_HEADER_RESERVE];
+  size_t h = mqttPublishHeader(header, sizeof(header), topic, len, packetId, dup);
+  if (h == 0) {
+    LOG_E("En-tete PUBLISH trop long (%s)", topic);
+    return false;
+  }
+  return inner_.write(header, h) == h && inner_.write(payload, len) == len;
+}
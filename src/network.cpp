@@ -0,0 +1,862 @@
+/**
+ * Tache reseau : WiFi, NTP et publication MQTT sur le coeur PRO.
+ *
+ * Les blocages (timeout WiFi, handshake TLS) n'affectent que cette tache :
+ * les releves s'accumulent dans le tampon de coupure et sont rejoues par
+ * lots, avec leur horodatage d'origine, des que le broker est joignable.
+ *
+ * En passerelle (ROLE_GATEWAY), la meme tache publie aussi les trames des
+ * feuilles ESP-NOW (gateway.h). Une feuille (ROLE_LEAF) n'a ni WiFi ni MQTT :
+ * l'interface network.h est alors fournie par src/leaf_network.cpp.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <time.h>
+#include <esp_heap_caps.h>
+#include <esp_sntp.h>
+#include "config.h"
+#include "network.h"
+#include "acquisition.h"
+#include "boot_time.h"
+#include "command.h"
+#include "compress.h"
+#include "connection.h"
+#include "dht_sensor.h"
+#include "inflight_window.h"
+#include "log.h"
+#include "mqtt_link.h"
+#include "outage_buffer.h"
+#include "encoder.h"
+#include "gateway.h"
+#include "history.h"
+#include "local_server.h"
+#include "payload.h"
+#include "power.h"
+#include "reading.h"
+#include "scheduler.h"
+#include "stage_stats.h"
+#include "timebase.h"
+#include "tls_client.h"
+#include "watchdog.h"
+
+#if STATION_ROLE != ROLE_LEAF
+
+static TlsClient tlsClient;
+static MqttLink link(tlsClient);
+static PubSubClient mqtt(link);
+static Scheduler netScheduler;
+static QueueHandle_t readingQueue = nullptr;
+static OutageBuffer outage;
+static ConnectionManager conn(mqtt);
+
+/**
+ * Tache de maintien des connexions : un pas des machines a etats WiFi/MQTT.
+ * Ne bloque jamais au-dela d'une tentative MQTT unique.
+ */
+static void taskConnections() {
+  STAGE_TIME(STAGE_CONNECT);
+  conn.step(millis());
+#if HISTORY_LOG
+  // Session propre : abonnement renouvele a chaque connexion MQTT
+  static bool subscribed = false;
+  if (conn.mqttUp() != subscribed) {
+    subscribed = conn.mqttUp() && mqtt.subscribe(MQTT_CMD_TOPIC, 1);
+  }
+#endif
+#if LOCAL_SERVER
+  if (conn.wifiUp()) {
+    localServerBegin();  // Sans effet une fois demarre
+  }
+#endif
+}
+
+#if REPLAY_COMPRESS
+static uint32_t compressBatches = 0;
+static uint32_t compressReadings = 0;
+static uint32_t compressBytes = 0;
+#endif
+
+/** Message MQTT encode a partir des releves les plus anciens d'un lot. */
+struct Message {
+  const char* topic;
+  const uint8_t* payload;
+  size_t len;
+  uint16_t count;  // Releves couverts
+};
+
+/**
+ * Encode les premiers releves de `batch` au format choisi par
+ * PAYLOAD_ENCODING : un releve par message, ou jusqu'a PAYLOAD_BATCH_SIZE
+ * releves groupes. Deterministe : encoder a nouveau les `m.count` memes
+ * releves redonne le meme message (retransmission QoS 1).
+ * Retourne false si aucun releve ne tient dans le tampon.
+ */
+static bool encodeMessage(const PackedReading* batch, uint16_t n, Message& m) {
+  static uint8_t payload[MQTT_BUFFER_SIZE];
+  m.payload = payload;
+  m.count = 0;
+#if REPLAY_COMPRESS
+  // Rejeu d'une longue coupure ; le choix ne depend que de `n`, une
+  // retransmission QoS 1 (n = m.count) reprend donc le meme encodage
+  if (n >= REPLAY_COMPRESS_MIN) {
+    static uint8_t columns[REPLAY_COMPRESS_BATCH * 16];  // ~9 octets par releve en pratique
+    STAGE_TIME(STAGE_COMPRESS);
+    m.topic = MQTT_COMPRESSED_TOPIC;
+    m.len = encodeCompressed(payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch,
+                             n < REPLAY_COMPRESS_BATCH ? n : REPLAY_COMPRESS_BATCH, m.count,
+                             columns, sizeof(columns));
+    if (m.len > 0 && m.count >= REPLAY_COMPRESS_MIN) {
+      compressBatches++;
+      compressReadings += m.count;
+      compressBytes += m.len;
+      return true;
+    }
+    m.count = 0;  // Lot trop gros meme reduit : encodage habituel
+  }
+#endif
+  // Jamais plus de PAYLOAD_BATCH_SIZE releves, meme si le rejeu en propose davantage
+  uint16_t want = n < PAYLOAD_BATCH_SIZE ? n : PAYLOAD_BATCH_SIZE;
+#if PAYLOAD_ENCODING != ENCODING_JSON
+  m.topic = MQTT_ENCODED_TOPIC;
+#if PAYLOAD_ENCODING == ENCODING_CBOR
+  m.len = encodeCbor(payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, want, m.count);
+#else
+  m.len = encodeBinary(payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, want, m.count);
+#endif
+#elif PAYLOAD_BATCH_SIZE > 1
+  m.topic = MQTT_BATCH_TOPIC;
+  m.len = formatBatchJson((char*)payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, want,
+                          m.count);
+#else
+  (void)want;  // Un seul releve par message
+  m.topic = MQTT_TOPIC;
+  m.len = formatReadingJson((char*)payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch[0]);
+  m.count = m.len > 0 ? 1 : 0;
+#endif
+  return m.len > 0 && m.count > 0;
+}
+
+/**
+ * Complete les horodatages relatifs d'un lot (releves pris avant NTP).
+ * Tant que l'heure est inconnue, la publication attend au plus
+ * TIME_BACKFILL_WAIT, MQTT connecte ; au-dela, ces releves partent sans
+ * heure. Retourne false si la publication doit attendre.
+ */
+static bool stampBatch(PackedReading* batch, uint16_t n) {
+  static bool waiting = false;
+  static bool gaveUp = false;
+  static uint32_t waitStartMs = 0;
+  if (backfillEpochs(batch, n)) {
+    if (waiting) {
+      LOG_I("Heure connue, releves en attente horodates");
+      waiting = false;
+    }
+    return true;
+  }
+  if (!gaveUp) {
+    if (!waiting) {
+      waiting = true;
+      waitStartMs = millis();
+    }
+    if (millis() - waitStartMs < TIME_BACKFILL_WAIT) {
+      return false;
+    }
+    gaveUp = true;
+    LOG_W("Heure inconnue, releves publies sans horodatage");
+  }
+  clearRelativeEpochs(batch, n);
+  return true;
+}
+
+#if MQTT_QOS == 1
+#if STATION_ROLE == ROLE_GATEWAY
+// Identifiants disjoints : releves de la station, trames relayees des feuilles
+static InflightWindow<MQTT_INFLIGHT_MAX> inflight(1, 32767);
+static InflightWindow<MQTT_INFLIGHT_MAX> relayInflight(32768, UINT16_MAX);
+#else
+static InflightWindow<MQTT_INFLIGHT_MAX> inflight;
+#endif
+static uint32_t qosAcked = 0;
+static uint32_t qosRetransmits = 0;
+
+/** Marque acquittes les messages dont le PUBACK a ete lu par mqtt.loop(). */
+static void collectAcks() {
+  uint16_t id;
+  while (link.takeAck(id)) {
+#if STATION_ROLE == ROLE_GATEWAY
+    if (inflight.ack(id) || relayInflight.ack(id)) {
+#else
+    if (inflight.ack(id)) {
+#endif
+      qosAcked++;
+    }
+  }
+}
+
+/**
+ * Retransmet le message en vol `i` (drapeau DUP, meme identifiant) a partir
+ * de ses releves, `batch` pointant sur le premier. Retourne false si le
+ * message n'a pas pu etre reconstruit ou envoye.
+ */
+static bool retransmit(uint8_t i, const PackedReading* batch) {
+  PowerBoost boost;
+  const InflightSlot& s = inflight.slot(i);
+  Message m;
+  if (!encodeMessage(batch, s.count, m) || m.count != s.count ||
+      !link.publishQos1(m.topic, m.payload, m.len, s.id, true)) {
+    return false;
+  }
+  inflight.resent(i, millis());
+  qosRetransmits++;
+  LOG_W("PUBACK absent, message %u retransmis", s.id);
+  return true;
+}
+#endif
+
+/**
+ * Publie des releves compacts, les plus anciens d'abord, `batch` commencant
+ * au premier releve jamais envoye. En QoS 1, s'arrete quand la fenetre est
+ * pleine : les releves envoyes restent dans leur file jusqu'au PUBACK.
+ * Avec PAYLOAD_BATCH_SIZE > 1, seul le premier lot peut etre incomplet.
+ * Retourne le nombre de releves envoyes (s'arrete au premier echec).
+ */
+static uint16_t publishPacked(const PackedReading* batch, uint16_t n) {
+  PowerBoost boost;  // Encodage et ecriture TLS
+  uint16_t sent = 0;
+  while (sent < n) {
+#if PAYLOAD_BATCH_SIZE > 1
+    if (sent > 0 && n - sent < PAYLOAD_BATCH_SIZE) {
+      break;
+    }
+#endif
+#if MQTT_QOS == 1
+    if (inflight.full()) {
+      break;
+    }
+#endif
+    Message m;
+    if (!encodeMessage(batch + sent, n - sent, m)) {
+      break;
+    }
+#if MQTT_QOS == 1
+    if (!link.publishQos1(m.topic, m.payload, m.len, inflight.peekId(), false)) {
+      LOG_W("Echec publication MQTT (%s)", m.topic);
+      break;
+    }
+    inflight.add(m.count, millis());
+#else
+    if (!mqtt.publish(m.topic, m.payload, m.len)) {
+      LOG_W("Echec publication MQTT (%s)", m.topic);
+      break;
+    }
+#endif
+    LOG_D("MQTT publie sur %s (%u releves, %u octets)", m.topic, m.count, (unsigned)m.len);
+    sent += m.count;
+    mqtt.loop();
+  }
+  return sent;
+}
+
+#if STATION_ROLE == ROLE_GATEWAY
+/**
+ * Encode une trame relayee en un message groupe au nom de sa feuille, sur
+ * sensors/{MQTT_USER}/{feuille}/batch (JSON) ou /cbor, /bin.
+ */
+static bool encodeRelay(const RelayFrame& f, Message& m) {
+  static uint8_t payload[MQTT_BUFFER_SIZE];
+  static char topic[MQTT_HEADER_RESERVE - 8];
+  const char* leaf = gatewayLeafName(f.leaf);
+  m.payload = payload;
+  m.topic = topic;
+  m.count = 0;
+#if PAYLOAD_ENCODING == ENCODING_JSON
+  snprintf(topic, sizeof(topic), "sensors/" MQTT_USER "/%s/batch", leaf);
+  m.len = formatBatchJson((char*)payload, sizeof(payload) - MQTT_HEADER_RESERVE, f.readings,
+                          f.count, m.count, leaf);
+#else
+  snprintf(topic, sizeof(topic), "sensors/" MQTT_USER "/%s" MQTT_ENCODED_SUFFIX, leaf);
+#if PAYLOAD_ENCODING == ENCODING_CBOR
+  m.len = encodeCbor(payload, sizeof(payload) - MQTT_HEADER_RESERVE, f.readings, f.count,
+                     m.count);
+#else
+  m.len = encodeBinary(payload, sizeof(payload) - MQTT_HEADER_RESERVE, f.readings, f.count,
+                       m.count);
+#endif
+#endif
+  return m.len > 0 && m.count == f.count;
+}
+
+/** Publie la trame relayee d'indice `i` (QoS 1 : identifiant `packetId`). */
+static bool sendRelay(uint16_t i, uint16_t packetId, bool dup) {
+  PowerBoost boost;
+  RelayFrame f;
+  Message m;
+  if (!gatewayPeek(i, f) || !encodeRelay(f, m)) {
+    return false;
+  }
+#if MQTT_QOS == 1
+  bool ok = link.publishQos1(m.topic, m.payload, m.len, packetId, dup);
+#else
+  (void)packetId;
+  (void)dup;
+  bool ok = mqtt.publish(m.topic, m.payload, m.len);
+#endif
+  if (!ok) {
+    LOG_W("Echec publication MQTT (%s)", m.topic);
+    return false;
+  }
+  LOG_D("MQTT publie sur %s (%u releves relayes)", m.topic, m.count);
+  return true;
+}
+
+/**
+ * Publie les trames des feuilles dans l'ordre d'arrivee, au plus
+ * REPLAY_BATCH par echeance. En QoS 1, une fenetre dediee suit les
+ * messages en vol ; une trame ne quitte la file qu'une fois acquittee.
+ */
+static void publishRelay() {
+#if MQTT_QOS == 1
+  gatewayConsume(relayInflight.popAcked());
+  if (!mqtt.connected()) {
+    relayInflight.clear();
+    return;
+  }
+  int expired;
+  while ((expired = relayInflight.expired(millis(), MQTT_RETRY_TIMEOUT)) >= 0) {
+    if (!sendRelay(relayInflight.offset(expired), relayInflight.slot(expired).id, true)) {
+      relayInflight.clear();
+      return;
+    }
+    relayInflight.resent(expired, millis());
+    qosRetransmits++;
+  }
+  for (uint16_t k = 0; k < REPLAY_BATCH && !relayInflight.full(); k++) {
+    uint32_t next = relayInflight.readings();
+    if (next >= gatewayPending() || !sendRelay(next, relayInflight.peekId(), false)) {
+      break;
+    }
+    relayInflight.add(1, millis());
+    mqtt.loop();
+  }
+#else
+  if (!mqtt.connected()) {
+    return;
+  }
+  uint16_t sent = 0;
+  while (sent < REPLAY_BATCH && sent < gatewayPending() && sendRelay(sent, 0, false)) {
+    sent++;
+    mqtt.loop();
+  }
+  gatewayConsume(sent);
+#endif
+}
+#endif
+
+/**
+ * Tache de publication : transfere la file des releves dans le tampon de
+ * coupure, puis publie les plus anciens si MQTT est connecte : au plus
+ * REPLAY_BATCH releves unitaires, ou un message groupe de
+ * PAYLOAD_BATCH_SIZE releves par echeance. Un releve n'est retire du tampon
+ * qu'une fois publie (QoS 0) ou acquitte (QoS 1).
+ *
+ * En QoS 1, les messages en vol designent des releves du tampon par leur
+ * position ; si des releves sont ecartes en tete (debordement DROP_OLDEST,
+ * fichier illisible) ou si la connexion tombe, la fenetre est videe et ces
+ * releves sont renvoyes comme nouveaux messages.
+ */
+static void taskPublish() {
+  Reading r;
+  while (xQueueReceive(readingQueue, &r, 0) == pdTRUE) {
+    outage.push(r);
+#if HISTORY_LOG
+    historyAppend(r);
+#endif
+#if LOCAL_SERVER
+    localServerPush(r);
+#endif
+  }
+#if STATION_ROLE == ROLE_GATEWAY
+  gatewayPoll();
+  publishRelay();
+#endif
+
+  static PackedReading batch[PUBLISH_BATCH_MAX];
+#if MQTT_QOS == 1
+  static uint32_t seenEvicted = 0;
+  collectAcks();
+  outage.consume(inflight.popAcked());
+  if (!mqtt.connected() || outage.evicted() != seenEvicted) {
+    inflight.clear();
+    seenEvicted = outage.evicted();
+  }
+  if (!mqtt.connected()) {
+    return;
+  }
+  int expired;
+  while ((expired = inflight.expired(millis(), MQTT_RETRY_TIMEOUT)) >= 0) {
+    uint16_t count = inflight.slot(expired).count;
+    uint16_t k = outage.peekBatch(batch, count, inflight.offset(expired));
+    if (outage.evicted() != seenEvicted || k != count || !stampBatch(batch, k) ||
+        !retransmit(expired, batch)) {
+      inflight.clear();
+      seenEvicted = outage.evicted();
+      return;
+    }
+  }
+  uint32_t skip = inflight.readings();
+#else
+  if (!mqtt.connected()) {
+    return;
+  }
+  uint32_t skip = 0;
+#endif
+#if REPLAY_COMPRESS
+  uint16_t n = outage.peekBatch(batch, PUBLISH_BATCH_MAX, skip);
+  if (n < REPLAY_COMPRESS_MIN && n > PUBLISH_BATCH_BASE) {
+    n = PUBLISH_BATCH_BASE;  // Pas de compression : cadence de rejeu habituelle
+  }
+#else
+  uint16_t n = outage.peekBatch(batch, PUBLISH_BATCH_MAX, skip);
+#endif
+#if MQTT_QOS == 1
+  if (outage.evicted() != seenEvicted) {
+    return;  // Fenetre videe a la prochaine echeance
+  }
+#endif
+  if (n > 0 && !stampBatch(batch, n)) {
+    return;  // En attente de NTP
+  }
+#if PAYLOAD_BATCH_SIZE > 1
+  // Lot incomplet : on attend qu'il soit plein ou assez ancien
+  static uint32_t lastBatchMs = millis();
+  if (n == 0 || (n < PAYLOAD_BATCH_SIZE && millis() - lastBatchMs < PAYLOAD_BATCH_MAX_AGE)) {
+    return;
+  }
+#endif
+  uint16_t sent;
+  {
+    STAGE_TIME(STAGE_PUBLISH);
+    sent = publishPacked(batch, n);
+  }
+#if PAYLOAD_BATCH_SIZE > 1
+  if (sent > 0) {
+    lastBatchMs = millis();
+  }
+#endif
+  uint32_t waiting = outage.depth() - skip - sent;
+#if MQTT_QOS == 0
+  outage.consume(sent);
+#endif
+  if (sent > 0 && waiting > 0) {
+    LOG_I("Rejeu : %u envoyes, %u en attente", sent, waiting);
+  }
+}
+
+#if HISTORY_LOG
+/** Requete d'historique : une seule a la fois, lue par lots de HISTORY_REPLY_BATCH. */
+static Command incoming;           // Recue par onCommand, prise en charge par taskHistory
+static bool hasIncoming = false;
+static Command query;
+static HistoryCursor cursor;
+static bool queryActive = false;
+static uint32_t querySent = 0;
+
+/**
+ * Callback PubSubClient (depuis mqtt.loop()) : `payload` pointe dans le
+ * tampon de PubSubClient, la commande est donc copiee puis traitee a la
+ * prochaine echeance, hors callback.
+ */
+static void onCommand(char* topic, uint8_t* payload, unsigned int len) {
+  Command cmd;
+  if (strcmp(topic, MQTT_CMD_TOPIC) != 0 || !parseCommand((const char*)payload, len, cmd)) {
+    LOG_W("Commande MQTT invalide ignoree");
+    return;
+  }
+  if (hasIncoming) {
+    LOG_W("Commande MQTT ignoree, precedente en attente");
+    return;
+  }
+  incoming = cmd;
+  hasIncoming = true;
+}
+
+/** Fin de requete sur MQTT_HISTORY_DONE_TOPIC : "done", "busy" ou "aborted". */
+static void publishHistoryDone(const Command& cmd, uint32_t count, const char* status) {
+  char payload[160];
+  int n = snprintf(payload, sizeof(payload),
+                   "{\"device\":\"%s\",\"id\":\"%s\",\"from\":%u,\"to\":%u,\"count\":%u,"
+                   "\"status\":\"%s\"}",
+                   MQTT_DEVICE, cmd.id, cmd.from, cmd.to, count, status);
+  if (n > 0 && (size_t)n < sizeof(payload)) {
+    mqtt.publish(MQTT_HISTORY_DONE_TOPIC, (const uint8_t*)payload, n);
+  }
+}
+
+/**
+ * Encode les premiers releves d'une reponse d'historique en un message
+ * groupe sur MQTT_HISTORY_TOPIC (JSON) ou MQTT_HISTORY_TOPIC/cbor, /bin.
+ */
+static bool encodeHistory(const PackedReading* batch, uint16_t n, Message& m) {
+  static uint8_t payload[MQTT_BUFFER_SIZE];
+  m.payload = payload;
+  m.count = 0;
+#if PAYLOAD_ENCODING == ENCODING_JSON
+  m.topic = MQTT_HISTORY_TOPIC;
+  m.len = formatBatchJson((char*)payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, n,
+                          m.count);
+#else
+  m.topic = MQTT_HISTORY_TOPIC MQTT_ENCODED_SUFFIX;
+#if PAYLOAD_ENCODING == ENCODING_CBOR
+  m.len = encodeCbor(payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, n, m.count);
+#else
+  m.len = encodeBinary(payload, sizeof(payload) - MQTT_HEADER_RESERVE, batch, n, m.count);
+#endif
+#endif
+  return m.len > 0 && m.count > 0;
+}
+
+/**
+ * Tache de reponse aux requetes d'historique : au plus HISTORY_REPLY_BATCH
+ * releves lus dans la partition et publies par echeance, en QoS 0 (une
+ * reponse interrompue se redemande). Une requete recue pendant une autre
+ * est refusee ("busy").
+ */
+static void taskHistory() {
+  if (hasIncoming) {
+    hasIncoming = false;
+    if (queryActive) {
+      publishHistoryDone(incoming, 0, "busy");
+    } else {
+      query = incoming;
+      cursor = historySeek(query.from);
+      querySent = 0;
+      queryActive = true;
+      LOG_I("Requete d'historique %s : %u a %u", query.id, query.from, query.to);
+    }
+  }
+  if (!queryActive) {
+    return;
+  }
+  if (!mqtt.connected()) {
+    queryActive = false;
+    LOG_W("Requete d'historique %s interrompue (MQTT deconnecte)", query.id);
+    return;
+  }
+  static PackedReading batch[HISTORY_REPLY_BATCH];
+  uint16_t n = historyRead(cursor, query.from, query.to, batch, HISTORY_REPLY_BATCH);
+  PowerBoost boost;
+  for (uint16_t sent = 0; sent < n;) {
+    Message m;
+    if (!encodeHistory(batch + sent, n - sent, m) || !mqtt.publish(m.topic, m.payload, m.len)) {
+      LOG_W("Echec publication MQTT (%s)", MQTT_HISTORY_TOPIC);
+      publishHistoryDone(query, querySent, "aborted");
+      queryActive = false;
+      return;
+    }
+    sent += m.count;
+    querySent += m.count;
+    mqtt.loop();
+  }
+  if (cursor.done) {
+    publishHistoryDone(query, querySent, "done");
+    queryActive = false;
+    LOG_I("Requete d'historique %s : %u releves", query.id, querySent);
+  }
+}
+#endif
+
+/**
+ * Tache de diagnostic : etat du tampon de coupure, du TLS, des connexions,
+ * du tas, du DHT, du journal, de l'historique, du serveur local, du chien
+ * de garde, bilan d'energie et (DIAG_STAGE_TIMING) duree des etapes sur
+ * MQTT_DIAG_TOPIC.
+ * Avec LOCAL_SERVER, le diagnostic est aussi rendu pour /diag, MQTT
+ * connecte ou non.
+ */
+static void taskDiag() {
+#if !LOCAL_SERVER
+  if (!mqtt.connected()) {
+    return;
+  }
+#endif
+  static char payload[2048];
+  const DhtStats& dht = dhtSensorStats();
+  int n = snprintf(payload, sizeof(payload),
+    "{\"device\":\"%s\","
+    "\"uptime_s\":%lu,"
+    "\"buffer\":{\"depth\":%u,\"capacity\":%u,\"spilled\":%u,"
+    "\"high_water\":%u,\"dropped\":%u,\"queue_dropped\":%u,\"policy\":\"%s\"},"
+    "\"tls\":{\"handshake_ms\":%u,\"resumed\":%s,\"handshakes\":%u,\"resumptions\":%u},"
+    "\"wifi\":{\"connect_ms\":%u,\"fast\":%s,\"rssi\":%d,\"attempts\":%u},"
+    "\"mqtt\":{\"attempts\":%u,\"retry_in_ms\":%u},"
+    "\"heap\":{\"free\":%u,\"min_free\":%u,\"largest_block\":%u},"
+    "\"dht\":{\"reads\":%u,\"checksum_errors\":%u,\"frame_errors\":%u,\"timeouts\":%u,\"cached\":%u},"
+    "\"log_dropped\":%u",
+    MQTT_DEVICE, millis() / 1000,
+    outage.depth(), OutageBuffer::capacity(), outage.spilled(),
+    outage.highWater(), outage.dropped(), acquisitionDropped(), OutageBuffer::policyName(),
+    tlsClient.lastHandshakeMs(), tlsClient.lastResumed() ? "true" : "false",
+    tlsClient.handshakes(), tlsClient.resumptions(),
+    conn.wifiConnectMs(), conn.wifiFastUsed() ? "true" : "false", WiFi.RSSI(),
+    conn.wifiAttempts(), conn.mqttAttempts(), conn.mqttRetryInMs(millis()),
+    ESP.getFreeHeap(), ESP.getMinFreeHeap(),
+    (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+    dht.reads, dht.checksumErrors, dht.frameErrors, dht.timeouts, dht.cached,
+    (unsigned)logDropped());
+  if (n < 0 || (size_t)n >= sizeof(payload) - 2) {
+    return;
+  }
+  size_t pos = n;
+#if MQTT_QOS == 1
+  int q = snprintf(payload + pos, sizeof(payload) - pos,
+                   ",\"qos\":{\"inflight\":%u,\"acked\":%u,\"retransmits\":%u,\"acks_dropped\":%u}",
+                   inflight.size(), qosAcked, qosRetransmits, link.acksDropped());
+  if (q < 0 || (size_t)q >= sizeof(payload) - pos - 2) {
+    return;
+  }
+  pos += q;
+#endif
+#if REPLAY_COMPRESS
+  // Taille compressee rapportee aux releves compacts (PackedReading)
+  uint32_t rawBytes = compressReadings * sizeof(PackedReading);
+  int z = snprintf(payload + pos, sizeof(payload) - pos,
+                   ",\"compress\":{\"batches\":%u,\"readings\":%u,\"bytes\":%u,\"ratio_pct\":%u}",
+                   compressBatches, compressReadings, compressBytes,
+                   rawBytes ? (unsigned)((uint64_t)compressBytes * 100 / rawBytes) : 0);
+  if (z < 0 || (size_t)z >= sizeof(payload) - pos - 2) {
+    return;
+  }
+  pos += z;
+#endif
+#if STATION_ROLE == ROLE_GATEWAY
+  const GatewayStats& gw = gatewayStats();
+  int g = snprintf(payload + pos, sizeof(payload) - pos,
+                   ",\"espnow\":{\"leaves\":%u,\"frames\":%u,\"pending\":%u,\"duplicates\":%u,"
+                   "\"rejected\":%u,\"invalid\":%u,\"rx_dropped\":%u}",
+                   gw.leaves, gw.frames, gatewayPending(), gw.duplicates, gw.rejected, gw.invalid,
+                   gw.rxDropped);
+  if (g < 0 || (size_t)g >= sizeof(payload) - pos - 2) {
+    return;
+  }
+  pos += g;
+#endif
+#if HISTORY_LOG
+  payload[pos++] = ',';
+  size_t h = historyJson(payload + pos, sizeof(payload) - pos - 2);
+  if (h == 0) {
+    pos--;
+  }
+  pos += h;
+#endif
+#if LOCAL_SERVER
+  payload[pos++] = ',';
+  size_t l = localServerJson(payload + pos, sizeof(payload) - pos - 2);
+  if (l == 0) {
+    pos--;
+  }
+  pos += l;
+#endif
+#if WATCHDOG
+  payload[pos++] = ',';
+  size_t w = watchdogJson(payload + pos, sizeof(payload) - pos - 2);
+  if (w == 0) {
+    pos--;
+  }
+  pos += w;
+#endif
+  payload[pos++] = ',';
+  size_t e = powerJson(payload + pos, sizeof(payload) - pos - 2);
+  if (e == 0) {
+    pos--;
+  }
+  pos += e;
+#if DIAG_STAGE_TIMING
+  payload[pos++] = ',';
+  size_t k = stageStatsJson(payload + pos, sizeof(payload) - pos - 1);
+  if (k == 0) {
+    pos--;
+  }
+  pos += k;
+#endif
+  payload[pos++] = '}';
+  payload[pos] = '\0';
+#if LOCAL_SERVER
+  localServerSetDiag(payload, pos);  // Servi sur /diag, broker joignable ou non
+  if (!mqtt.connected()) {
+    return;
+  }
+#endif
+  // Fenetres de mesure fermees seulement une fois publiees : rien n'est perdu hors ligne
+  if (mqtt.publish(MQTT_DIAG_TOPIC, (const uint8_t*)payload, pos)) {
+#if WATCHDOG
+    watchdogReported();
+#endif
+    powerReported();
+#if DIAG_STAGE_TIMING
+    stageStatsReported();
+#endif
+  }
+}
+
+/**
+ * Configuration MQTT (TLS sans verification de certificat, reprise de session).
+ */
+static void setupMQTT() {
+  mqtt.setServer(MQTT_SERVER, MQTT_PORT);
+  mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+  mqtt.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+#if HISTORY_LOG
+  mqtt.setCallback(onCommand);
+#endif
+}
+
+static void networkTask(void*) {
+  outage.begin();
+#if HISTORY_LOG
+  historyBegin();
+#endif
+  setupMQTT();
+#if STATION_ROLE == ROLE_GATEWAY
+  WiFi.mode(WIFI_STA);
+  gatewayBegin();
+#endif
+
+  uint32_t now = millis();
+  netScheduler.add("connexions", taskConnections, CONNECT_INTERVAL, now, CONNECT_INTERVAL);
+  netScheduler.add("publication", taskPublish, PUBLISH_INTERVAL, now);
+  netScheduler.add("diag", taskDiag, DIAG_INTERVAL, now, DIAG_INTERVAL);
+#if HISTORY_LOG
+  netScheduler.add("historique", taskHistory, HISTORY_REPLY_INTERVAL, now);
+#endif
+
+#if WATCHDOG
+  stageWatchLoop(WATCHDOG_LOOP_STALL_MS);
+#endif
+  for (;;) {
+#if WATCHDOG
+    stageBeat();
+#endif
+    uint32_t wait = netScheduler.run(millis());
+    // Traitement MQTT entre les echeances (keepalive, messages entrants)
+    {
+      STAGE_TIME(STAGE_MQTT_LOOP);
+      mqtt.loop();
+    }
+    vTaskDelay(pdMS_TO_TICKS(wait < IDLE_MAX_DELAY ? (wait > 0 ? wait : 1) : IDLE_MAX_DELAY));
+  }
+}
+
+void startNetwork(QueueHandle_t queue) {
+  readingQueue = queue;
+  xTaskCreatePinnedToCore(networkTask, "network", NET_TASK_STACK, nullptr,
+                          NET_TASK_PRIO, nullptr, NET_TASK_CORE);
+}
+
+bool networkConnectOnce(bool syncTime) {
+  setupMQTT();
+  conn.setNtpEnabled(syncTime);
+  // Session complete dans une seule etape : un handshake TLS bloque est attribue a "connect"
+  STAGE_TIME(STAGE_CONNECT);
+  uint32_t start = millis();
+  while (!conn.mqttUp() && millis() - start < ONESHOT_CONNECT_TIMEOUT) {
+    conn.step(millis());
+    delay(CONNECT_INTERVAL);
+  }
+  if (syncTime && conn.wifiUp()) {
+    while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED &&
+           millis() - start < ONESHOT_CONNECT_TIMEOUT + NTP_SYNC_TIMEOUT) {
+      delay(50);
+    }
+    if (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED) {
+      LOG_W("Echec synchronisation NTP");
+    }
+  }
+  return conn.mqttUp();
+}
+
+uint16_t networkPublishPacked(const PackedReading* batch, uint16_t n) {
+#if MQTT_QOS == 1
+  // Fenetre sur le lot RTC : envoi continu, arret quand tout est acquitte
+  // ou sans nouveau PUBACK pendant MQTT_ACK_WAIT
+  inflight.clear();
+  uint16_t acked = 0;
+  uint32_t progressMs = millis();
+  while (mqtt.connected() && millis() - progressMs < MQTT_ACK_WAIT) {
+    STAGE_TIME(STAGE_PUBLISH);
+    mqtt.loop();
+    collectAcks();
+    uint32_t released = inflight.popAcked();
+    if (released > 0) {
+      acked += released;
+      progressMs = millis();
+    }
+    int expired;
+    while ((expired = inflight.expired(millis(), MQTT_RETRY_TIMEOUT)) >= 0 &&
+           retransmit(expired, batch + acked + inflight.offset(expired))) {
+    }
+    uint16_t next = acked + inflight.readings();
+    if (next < n) {
+      publishPacked(batch + next, n - next);
+    } else if (inflight.empty()) {
+      break;
+    }
+    delay(5);
+  }
+  inflight.clear();
+  return acked;
+#else
+  uint16_t sent = 0;
+  while (sent < n && mqtt.connected()) {
+    STAGE_TIME(STAGE_PUBLISH);
+    uint16_t k = publishPacked(batch + sent, n - sent);
+    if (k == 0) {
+      break;
+    }
+    sent += k;
+    mqtt.loop();
+  }
+  return sent;
+#endif
+}
+
+void networkPublishPower() {
+  char payload[512];
+  int n = snprintf(payload, sizeof(payload), "{\"device\":\"%s\",", MQTT_DEVICE);
+  if (n < 0 || (size_t)n >= sizeof(payload)) {
+    return;
+  }
+  size_t k = powerJson(payload + n, sizeof(payload) - n - 1);
+  if (k == 0) {
+    return;
+  }
+  size_t pos = n + k;
+#if WATCHDOG
+  // Un blocage pendant un reveil precedent est rapporte avec le bilan
+  payload[pos++] = ',';
+  size_t w = watchdogJson(payload + pos, sizeof(payload) - pos - 1);
+  if (w == 0) {
+    pos--;
+  }
+  pos += w;
+#endif
+  payload[pos++] = '}';
+  STAGE_TIME(STAGE_PUBLISH);
+  if (mqtt.publish(MQTT_DIAG_TOPIC, (const uint8_t*)payload, pos)) {
+#if WATCHDOG
+    watchdogReported();
+#endif
+    powerReported();
+  }
+}
+
+void networkShutdown() {
+  mqtt.loop();
+  mqtt.disconnect();
+  tlsClient.stop();
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+}
+
+#endif
@@ -0,0 +1,219 @@
+#include <Arduino.h>
+#include "outage_buffer.h"
+#include "log.h"
+#include "timebase.h"
+
+#if OUTAGE_SPILL_FS
+#include <LittleFS.h>
+#endif
+
+const char* OutageBuffer::policyName() {
+  return (OUTAGE_POLICY == OUTAGE_DROP_NEWEST) ? "drop_newest" : "drop_oldest";
+}
+
+void OutageBuffer::begin() {
+#if OUTAGE_SPILL_FS
+  fsReady_ = LittleFS.begin(true);
+  if (!fsReady_) {
+    LOG_W("LittleFS indisponible, tampon de coupure en RAM uniquement");
+    return;
+  }
+  // Releves restes sur flash avant un redemarrage : rejoues en premier
+  File f = LittleFS.open(OUTAGE_SPILL_FILE, "r");
+  if (!f) {
+    LittleFS.remove(OUTAGE_SPILL_POS);
+    return;
+  }
+  size_t size = f.size();
+  f.close();
+  spillCount_ = size / sizeof(PackedReading);
+  priorBoot_ = spillCount_;
+  File pos = LittleFS.open(OUTAGE_SPILL_POS, "r");
+  if (pos) {
+    uint32_t readPos = 0;
+    if (pos.read((uint8_t*)&readPos, sizeof(readPos)) == sizeof(readPos) &&
+        readPos <= spillCount_) {
+      spillReadPos_ = readPos;
+    }
+    pos.close();
+  }
+  // Releves deja rejoues ou fin de fichier tronquee : recopie du reste
+  if ((spillReadPos_ > 0 || size % sizeof(PackedReading) != 0) && !compactSpill()) {
+    discardSpill();
+  }
+  if (spilled() > 0) {
+    LOG_I("Tampon flash : %u releves a rejouer", spilled());
+  }
+#endif
+}
+
+void OutageBuffer::push(const Reading& r) {
+  PackedReading p = packReading(r);
+  if (ram_.push(p)) {
+    updateHighWater();
+    return;
+  }
+  if (spillOldest() && ram_.push(p)) {
+    updateHighWater();
+    return;
+  }
+  dropped_++;
+  if (OUTAGE_POLICY == OUTAGE_DROP_OLDEST) {
+    ram_.pushOverwrite(p);
+    evicted_++;
+  }
+}
+
+uint16_t OutageBuffer::peekBatch(PackedReading* out, uint16_t max, uint32_t skip) {
+  uint16_t n = 0;
+#if OUTAGE_SPILL_FS
+  if (spilled() > skip) {
+    // Le fichier contient les releves les plus anciens
+    File f = LittleFS.open(OUTAGE_SPILL_FILE, "r");
+    if (f && f.seek((spillReadPos_ + skip) * sizeof(PackedReading))) {
+      uint32_t avail = spilled() - skip;
+      uint16_t want = avail < max ? avail : max;
+      n = f.read((uint8_t*)out, want * sizeof(PackedReading)) / sizeof(PackedReading);
+    }
+    uint32_t first = spillReadPos_ + skip;
+    if (first < priorBoot_) {
+      // Horodatages relatifs d'un demarrage precedent : origine perdue
+      uint32_t stale = priorBoot_ - first;
+      clearRelativeEpochs(out, stale < n ? stale : n);
+    }
+    if (f) {
+      f.close();
+    }
+    if (n > 0) {
+      return n;
+    }
+    // Fichier illisible : ses releves sont perdus, on passe a la RAM
+    LOG_E("Tampon flash illisible, releves ecartes");
+    discardSpill();
+    skip = 0;
+  }
+  skip -= spilled();  // Index dans la RAM
+#endif
+  while (n < max && ram_.peek(out[n], skip + n)) {
+    n++;
+  }
+  return n;
+}
+
+void OutageBuffer::consume(uint32_t n) {
+#if OUTAGE_SPILL_FS
+  if (spilled() > 0) {
+    uint32_t fromFile = n < spilled() ? n : spilled();
+    spillReadPos_ += fromFile;
+    n -= fromFile;
+    if (spilled() == 0) {
+      // Fichier entierement rejoue
+      LittleFS.remove(OUTAGE_SPILL_FILE);
+      LittleFS.remove(OUTAGE_SPILL_POS);
+      spillCount_ = 0;
+      spillReadPos_ = 0;
+      priorBoot_ = 0;
+    } else if (fromFile > 0) {
+      // Une petite ecriture par lot rejoue : pas de renvoi apres un redemarrage
+      File f = LittleFS.open(OUTAGE_SPILL_POS, "w");
+      if (f) {
+        f.write((const uint8_t*)&spillReadPos_, sizeof(spillReadPos_));
+        f.close();
+      }
+    }
+  }
+#endif
+  ram_.drop(n);
+}
+
+#if OUTAGE_SPILL_FS
+static PackedReading chunk[OUTAGE_SPILL_CHUNK];  // Tache reseau uniquement
+
+/**
+ * Recopie les releves non rejoues dans un nouveau fichier : retire le
+ * prefixe deja rejoue et une fin de fichier incomplete. Les index de
+ * peekBatch ne changent pas.
+ */
+bool OutageBuffer::compactSpill() {
+  File in = LittleFS.open(OUTAGE_SPILL_FILE, "r");
+  File out = LittleFS.open(OUTAGE_SPILL_TMP, "w");
+  bool ok = in && out && in.seek(spillReadPos_ * sizeof(PackedReading));
+  for (uint32_t left = spilled(); ok && left > 0;) {
+    uint16_t n = left < OUTAGE_SPILL_CHUNK ? left : OUTAGE_SPILL_CHUNK;
+    size_t bytes = n * sizeof(PackedReading);
+    ok = in.read((uint8_t*)chunk, bytes) == bytes && out.write((const uint8_t*)chunk, bytes) == bytes;
+    left -= n;
+  }
+  if (in) {
+    in.close();
+  }
+  if (out) {
+    out.close();
+  }
+  if (!ok || !LittleFS.remove(OUTAGE_SPILL_FILE) ||
+      !LittleFS.rename(OUTAGE_SPILL_TMP, OUTAGE_SPILL_FILE)) {
+    LittleFS.remove(OUTAGE_SPILL_TMP);
+    return false;
+  }
+  LittleFS.remove(OUTAGE_SPILL_POS);
+  priorBoot_ = priorBoot_ > spillReadPos_ ? priorBoot_ - spillReadPos_ : 0;
+  spillCount_ = spilled();
+  spillReadPos_ = 0;
+  return true;
+}
+
+/** Abandonne le fichier : ses releves sont comptes perdus. */
+void OutageBuffer::discardSpill() {
+  dropped_ += spilled();
+  evicted_ += spilled();
+  LittleFS.remove(OUTAGE_SPILL_FILE);
+  LittleFS.remove(OUTAGE_SPILL_POS);
+  spillCount_ = 0;
+  spillReadPos_ = 0;
+  priorBoot_ = 0;
+}
+#endif
+
+/**
+ * Deplace les OUTAGE_SPILL_CHUNK plus anciens releves de la RAM vers la flash.
+ * Une seule ecriture par bloc pour limiter l'usure.
+ */
+bool OutageBuffer::spillOldest() {
+#if OUTAGE_SPILL_FS
+  if (!fsReady_ || spilled() + OUTAGE_SPILL_CHUNK > OUTAGE_SPILL_MAX) {
+    return false;
+  }
+  if (spillCount_ + OUTAGE_SPILL_CHUNK > OUTAGE_SPILL_MAX && !compactSpill()) {
+    return false;  // Place occupee par des releves deja rejoues
+  }
+  uint16_t n = 0;
+  while (n < OUTAGE_SPILL_CHUNK && ram_.peek(chunk[n], n)) {
+    n++;
+  }
+  File f = LittleFS.open(OUTAGE_SPILL_FILE, "a");
+  if (!f) {
+    return false;
+  }
+  size_t written = f.write((const uint8_t*)chunk, n * sizeof(PackedReading));
+  f.close();
+  if (written != n * sizeof(PackedReading)) {
+    // Octets partiels en fin de fichier : les blocs suivants seraient desalignes
+    LOG_W("Ecriture du tampon flash incomplete");
+    if (!compactSpill()) {
+      discardSpill();
+    }
+    return false;
+  }
+  ram_.drop(n);
+  spillCount_ += n;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void OutageBuffer::updateHighWater() {
+  if (depth() > highWater_) {
+    highWater_ = depth();
+  }
+}
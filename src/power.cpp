@@ -0,0 +1,105 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "log.h"
+#include "power.h"
+#include "power_meter.h"
+
+// Conserve en deep sleep : la fenetre couvre plusieurs reveils
+static RTC_DATA_ATTR PowerMeter meter = {};
+static uint64_t reported[PSTATE_COUNT] = {};  // Fenetre rendue par le dernier powerJson
+static uint8_t boostDepth = 0;
+static esp_pm_lock_handle_t boostLock = nullptr;  // esp_pm actif (POWER_SAVE_LIGHT)
+
+static const uint32_t STATE_UA[PSTATE_COUNT] = {POWER_UA_BOOST, POWER_UA_IDLE, POWER_UA_SLEEP};
+
+static const char* saveName() {
+#if POWER_SAVE == POWER_SAVE_OFF
+  return "off";
+#else
+  return boostLock ? "light" : "modem";
+#endif
+}
+
+void powerBegin() {
+  // Temps depuis le demarrage (ou le reveil) compte au repos
+  meter.state = PSTATE_IDLE;
+  meter.sinceUs = 0;
+#if POWER_SAVE == POWER_SAVE_LIGHT
+  esp_pm_config_esp32_t pm = {CPU_FREQ_BOOST_MHZ, CPU_FREQ_IDLE_MHZ, true};
+  if (esp_pm_configure(&pm) != ESP_OK ||
+      esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "boost", &boostLock) != ESP_OK) {
+    boostLock = nullptr;
+    LOG_W("Light sleep indisponible (CONFIG_PM_ENABLE, tickless idle), modem sleep seul");
+  }
+#endif
+#if POWER_SAVE != POWER_SAVE_OFF
+  if (boostLock == nullptr) {
+    setCpuFrequencyMhz(CPU_FREQ_IDLE_MHZ);
+  }
+#if STATION_ROLE == ROLE_STANDALONE
+  // Applique au demarrage du WiFi ; reveil a chaque DTIM ou tous les listen interval
+  WiFi.setSleep(POWER_SAVE == POWER_SAVE_LIGHT ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+#endif
+#endif
+  LOG_I("Energie : %s, CPU %u MHz", saveName(), (unsigned)getCpuFrequencyMhz());
+}
+
+void powerBoost() {
+  if (boostDepth++ > 0) {
+    return;
+  }
+  powerMeterEnter(meter, PSTATE_BOOST, esp_timer_get_time());
+#if POWER_SAVE != POWER_SAVE_OFF
+  if (boostLock) {
+    esp_pm_lock_acquire(boostLock);
+  } else {
+    setCpuFrequencyMhz(CPU_FREQ_BOOST_MHZ);
+  }
+#endif
+}
+
+void powerRelax() {
+  if (boostDepth == 0 || --boostDepth > 0) {
+    return;
+  }
+#if POWER_SAVE != POWER_SAVE_OFF
+  if (boostLock) {
+    esp_pm_lock_release(boostLock);
+  } else {
+    setCpuFrequencyMhz(CPU_FREQ_IDLE_MHZ);
+  }
+#endif
+  powerMeterEnter(meter, PSTATE_IDLE, esp_timer_get_time());
+}
+
+void powerDeepSleep(uint64_t sleepUs) {
+  powerMeterEnter(meter, PSTATE_IDLE, esp_timer_get_time());
+  powerMeterAdd(meter, PSTATE_SLEEP, sleepUs);
+}
+
+size_t powerJson(char* buf, size_t len) {
+  uint64_t now = esp_timer_get_time();
+  powerMeterEnter(meter, (PowerState)meter.state, now);
+  int n = snprintf(buf, len,
+                   "\"power\":{\"save\":\"%s\",\"cpu_mhz\":%u,\"boost_ms\":%u,\"idle_ms\":%u,"
+                   "\"sleep_ms\":%u,\"boost_pct\":%u,\"est_ua\":%u}",
+                   saveName(), (unsigned)getCpuFrequencyMhz(),
+                   (unsigned)(meter.us[PSTATE_BOOST] / 1000), (unsigned)(meter.us[PSTATE_IDLE] / 1000),
+                   (unsigned)(meter.us[PSTATE_SLEEP] / 1000), powerMeterDutyPct(meter),
+                   (unsigned)powerMeterMeanUa(meter, STATE_UA));
+  if (n < 0 || (size_t)n >= len) {
+    return 0;
+  }
+  memcpy(reported, meter.us, sizeof(reported));
+  return n;
+}
+
+void powerReported() {
+  powerMeterConsume(meter, reported);
+  memset(reported, 0, sizeof(reported));
+}
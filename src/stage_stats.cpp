@@ -0,0 +1,169 @@
+#include "stage_stats.h"
+
+#if DIAG_STAGE_TIMING
+
+#include <freertos/FreeRTOS.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+  "sample", "dht", "adc", "log", "connect", "publish", "mqtt_loop", "compress",
+};
+
+static const uint32_t BUDGET_MS[STAGE_COUNT] = {
+  STAGE_BUDGET_SAMPLE_MS, STAGE_BUDGET_DHT_MS, STAGE_BUDGET_ADC_MS, STAGE_BUDGET_LOG_MS,
+  STAGE_BUDGET_CONNECT_MS, STAGE_BUDGET_PUBLISH_MS, STAGE_BUDGET_MQTT_LOOP_MS,
+  STAGE_BUDGET_COMPRESS_MS,
+};
+
+static StageStats stats[STAGE_COUNT];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+#if WATCHDOG
+static WatchSlot watch[portNUM_PROCESSORS];  // Une tache chronometree par coeur
+#endif
+
+const char* stageName(uint8_t stage) {
+  return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "none";
+}
+
+void stageBegin(Stage stage, int64_t startUs) {
+#if WATCHDOG
+  portENTER_CRITICAL(&statsMux);
+  watchEnter(watch[xPortGetCoreID()], stage, (uint32_t)(startUs / 1000));
+  portEXIT_CRITICAL(&statsMux);
+#else
+  (void)stage;
+  (void)startUs;
+#endif
+}
+
+void stageRecord(Stage stage, uint32_t us) {
+  uint8_t bin = stageBin(us);
+  portENTER_CRITICAL(&statsMux);
+#if WATCHDOG
+  watchExit(watch[xPortGetCoreID()], (uint32_t)(esp_timer_get_time() / 1000));
+#endif
+  StageStats& s = stats[stage];
+  if (us > BUDGET_MS[stage] * 1000) {
+    s.over++;
+  }
+  if (s.count == 0 || us < s.minUs) {
+    s.minUs = us;
+  }
+  if (us > s.maxUs) {
+    s.maxUs = us;
+  }
+  s.count++;
+  s.totalUs += us;
+  s.hist[bin]++;
+  portEXIT_CRITICAL(&statsMux);
+}
+
+#if WATCHDOG
+void stageBeat() {
+  portENTER_CRITICAL(&statsMux);
+  watchBeat(watch[xPortGetCoreID()], (uint32_t)(esp_timer_get_time() / 1000));
+  portEXIT_CRITICAL(&statsMux);
+}
+
+void stageWatchLoop(uint32_t loopStallMs) {
+  portENTER_CRITICAL(&statsMux);
+  WatchSlot& w = watch[xPortGetCoreID()];
+  w.loopStallMs = loopStallMs;
+  w.beatMs = (uint32_t)(esp_timer_get_time() / 1000);
+  portEXIT_CRITICAL(&statsMux);
+}
+
+bool stageFindStall(uint32_t nowMs, uint8_t& core, Stall& out) {
+  uint32_t limits[STAGE_COUNT];
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    limits[i] = BUDGET_MS[i] * WATCHDOG_STALL_FACTOR;
+  }
+  WatchSlot snap[portNUM_PROCESSORS];
+  portENTER_CRITICAL(&statsMux);
+  memcpy(snap, watch, sizeof(watch));
+  portEXIT_CRITICAL(&statsMux);
+  for (uint8_t c = 0; c < portNUM_PROCESSORS; c++) {
+    if (watchCheck(snap[c], nowMs, limits, out)) {
+      core = c;
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+/**
+ * Ajoute du texte formate a `buf` a partir de `pos`.
+ * Retourne false si le tampon est trop petit.
+ */
+static bool appendf(char* buf, size_t len, size_t& pos, const char* fmt, ...) {
+  if (pos >= len) {
+    return false;
+  }
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf + pos, len - pos, fmt, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= len - pos) {
+    return false;
+  }
+  pos += n;
+  return true;
+}
+
+static StageStats snap[STAGE_COUNT];  // Fenetre rendue par le dernier stageStatsJson
+
+size_t stageStatsJson(char* buf, size_t len) {
+  // Copie coherente de la fenetre, formatee hors section critique
+  portENTER_CRITICAL(&statsMux);
+  memcpy(snap, stats, sizeof(stats));
+  portEXIT_CRITICAL(&statsMux);
+
+  size_t pos = 0;
+  bool ok = appendf(buf, len, pos, "\"stages\":{");
+  for (int i = 0; i < STAGE_COUNT && ok; i++) {
+    const StageStats& s = snap[i];
+    ok = appendf(buf, len, pos,
+                 "%s\"%s\":{\"n\":%u,\"over\":%u,\"min_us\":%u,\"max_us\":%u,\"mean_us\":%u,"
+                 "\"hist\":[",
+                 i > 0 ? "," : "", STAGE_NAMES[i], (unsigned)s.count, (unsigned)s.over,
+                 (unsigned)s.minUs, (unsigned)s.maxUs,
+                 (unsigned)(s.count ? s.totalUs / s.count : 0));
+    // Histogramme tronque apres la derniere classe non vide
+    int last = STAGE_HIST_BINS - 1;
+    while (last >= 0 && s.hist[last] == 0) {
+      last--;
+    }
+    for (int b = 0; b <= last && ok; b++) {
+      ok = appendf(buf, len, pos, "%s%u", b > 0 ? "," : "", (unsigned)s.hist[b]);
+    }
+    ok = ok && appendf(buf, len, pos, "]}");
+  }
+  ok = ok && appendf(buf, len, pos, "}");
+  return ok ? pos : 0;
+}
+
+void stageStatsReported() {
+  portENTER_CRITICAL(&statsMux);
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    StageStats& s = stats[i];
+    const StageStats& r = snap[i];
+    s.count -= r.count;
+    s.over -= r.over;
+    s.totalUs -= r.totalUs;
+    for (int b = 0; b < STAGE_HIST_BINS; b++) {
+      s.hist[b] -= r.hist[b];
+    }
+    if (s.count == 0) {
+      s.minUs = 0;
+      s.maxUs = 0;
+    }
+  }
+  portEXIT_CRITICAL(&statsMux);
+  memset(snap, 0, sizeof(snap));
+}
+
+#endif
@@ -0,0 +1,269 @@
+#include "config.h"
+#include "tls_client.h"
+#include "log.h"
+
+// Session serialisee (mbedtls_ssl_session_save), conservee en deep sleep
+static RTC_DATA_ATTR uint8_t sessionCache[TLS_SESSION_CACHE_SIZE];
+static RTC_DATA_ATTR size_t sessionCacheLen = 0;
+
+static const char TLS_PERS[] = "meteostation";
+
+TlsClient::TlsClient() {
+  mbedtls_ssl_init(&ssl_);
+  mbedtls_ssl_config_init(&conf_);
+  mbedtls_entropy_init(&entropy_);
+  mbedtls_ctr_drbg_init(&drbg_);
+}
+
+TlsClient::~TlsClient() {
+  stop();
+  mbedtls_ssl_free(&ssl_);
+  mbedtls_ssl_config_free(&conf_);
+  mbedtls_ctr_drbg_free(&drbg_);
+  mbedtls_entropy_free(&entropy_);
+}
+
+/**
+ * Initialisation unique des contextes mbedtls (reutilises a chaque connexion
+ * via mbedtls_ssl_session_reset pour eviter de fragmenter le tas).
+ */
+bool TlsClient::setup() {
+  if (ready_) {
+    return true;
+  }
+  int ret = mbedtls_ctr_drbg_seed(&drbg_, mbedtls_entropy_func, &entropy_,
+                                  (const unsigned char*)TLS_PERS, sizeof(TLS_PERS) - 1);
+  if (ret == 0) {
+    ret = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret != 0) {
+    LOG_E("TLS : echec initialisation (-0x%04x)", -ret);
+    return false;
+  }
+  mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_NONE);
+  mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &drbg_);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  ret = mbedtls_ssl_setup(&ssl_, &conf_);
+  if (ret != 0) {
+    LOG_E("TLS : echec mbedtls_ssl_setup (-0x%04x)", -ret);
+    return false;
+  }
+  ready_ = true;
+  return true;
+}
+
+int TlsClient::sendCb(void* ctx, const unsigned char* buf, size_t len) {
+  WiFiClient* tcp = (WiFiClient*)ctx;
+  if (!tcp->connected()) {
+    return MBEDTLS_ERR_NET_CONN_RESET;
+  }
+  size_t n = tcp->write(buf, len);
+  return n > 0 ? (int)n : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int TlsClient::recvCb(void* ctx, unsigned char* buf, size_t len) {
+  WiFiClient* tcp = (WiFiClient*)ctx;
+  if (tcp->available() <= 0) {
+    return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+  }
+  int n = tcp->read(buf, len);
+  return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+/**
+ * Handshake TLS, en proposant la session en cache si elle existe.
+ * La reprise est detectee quand le serveur renvoie le meme identifiant
+ * de session que celui propose.
+ */
+bool TlsClient::handshake(const char* host) {
+  mbedtls_ssl_session_reset(&ssl_);
+  mbedtls_ssl_set_hostname(&ssl_, host);
+  mbedtls_ssl_set_bio(&ssl_, &tcp_, sendCb, recvCb, nullptr);
+
+  unsigned char offeredId[32];
+  size_t offeredIdLen = 0;
+#if TLS_SESSION_RESUME
+  if (sessionCacheLen > 0) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_session_load(&session, sessionCache, sessionCacheLen) == 0 &&
+        mbedtls_ssl_set_session(&ssl_, &session) == 0) {
+      offeredIdLen = session.id_len;
+      memcpy(offeredId, session.id, offeredIdLen);
+    } else {
+      sessionCacheLen = 0;  // Cache invalide
+    }
+    mbedtls_ssl_session_free(&session);
+  }
+#endif
+
+  uint32_t start = millis();
+  int ret;
+  while ((ret = mbedtls_ssl_handshake(&ssl_)) != 0) {
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      LOG_E("TLS : echec handshake (-0x%04x)", -ret);
+      // Session refusee ou corrompue : handshake complet la prochaine fois
+      sessionCacheLen = 0;
+      return false;
+    }
+    if (millis() - start > TLS_HANDSHAKE_TIMEOUT) {
+      LOG_W("TLS : timeout handshake");
+      return false;
+    }
+    delay(1);
+  }
+
+  lastHandshakeMs_ = millis() - start;
+  handshakes_++;
+  const mbedtls_ssl_session* negotiated = ssl_.session;
+  lastResumed_ = offeredIdLen > 0 && negotiated && negotiated->id_len == offeredIdLen &&
+                 memcmp(negotiated->id, offeredId, offeredIdLen) == 0;
+  if (lastResumed_) {
+    resumptions_++;
+  }
+  LOG_I("TLS : handshake %s en %u ms", lastResumed_ ? "abrege" : "complet",
+        lastHandshakeMs_);
+  cacheSession();
+  return true;
+}
+
+/**
+ * Serialise la session courante dans le cache RTC.
+ */
+void TlsClient::cacheSession() {
+#if TLS_SESSION_RESUME
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  size_t len = 0;
+  if (mbedtls_ssl_get_session(&ssl_, &session) == 0 &&
+      mbedtls_ssl_session_save(&session, sessionCache, sizeof(sessionCache), &len) == 0) {
+    sessionCacheLen = len;
+  } else {
+    sessionCacheLen = 0;
+    LOG_W("TLS : session non mise en cache");
+  }
+  mbedtls_ssl_session_free(&session);
+#endif
+}
+
+void TlsClient::forgetSession() {
+  sessionCacheLen = 0;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+  char host[16];
+  snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return connect(host, port);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+  stop();
+  if (!setup() || !tcp_.connect(host, port)) {
+    return 0;
+  }
+  tcp_.setNoDelay(true);
+  if (!handshake(host)) {
+    tcp_.stop();
+    return 0;
+  }
+  connected_ = true;
+  return 1;
+}
+
+size_t TlsClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+  if (!connected_) {
+    return 0;
+  }
+  size_t done = 0;
+  uint32_t start = millis();
+  while (done < size) {
+    int ret = mbedtls_ssl_write(&ssl_, buf + done, size - done);
+    if (ret > 0) {
+      done += ret;
+    } else if (ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) {
+      stop();
+      break;
+    } else if (millis() - start > TLS_WRITE_TIMEOUT) {
+      // Enregistrement partiellement emis : l'ecriture suivante videra le reste
+      // et desynchroniserait le flux MQTT, la session est donc fermee
+      stop();
+      break;
+    } else {
+      delay(1);
+    }
+  }
+  return done;
+}
+
+int TlsClient::available() {
+  if (!connected_) {
+    return 0;
+  }
+  // Lecture de taille nulle : traite les enregistrements TLS en attente
+  int ret = mbedtls_ssl_read(&ssl_, nullptr, 0);
+  if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    stop();
+    return 0;
+  }
+  return mbedtls_ssl_get_bytes_avail(&ssl_) + (peeked_ >= 0 ? 1 : 0);
+}
+
+int TlsClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+  if (!connected_ || size == 0) {
+    return -1;
+  }
+  size_t n = 0;
+  if (peeked_ >= 0) {
+    buf[n++] = (uint8_t)peeked_;
+    peeked_ = -1;
+    if (n == size) {
+      return n;
+    }
+  }
+  int ret = mbedtls_ssl_read(&ssl_, buf + n, size - n);
+  if (ret > 0) {
+    return n + ret;
+  }
+  if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    stop();
+  }
+  return n > 0 ? (int)n : -1;
+}
+
+int TlsClient::peek() {
+  if (peeked_ < 0) {
+    uint8_t b;
+    if (read(&b, 1) == 1) {
+      peeked_ = b;
+    }
+  }
+  return peeked_;
+}
+
+void TlsClient::stop() {
+  if (connected_) {
+    mbedtls_ssl_close_notify(&ssl_);
+  }
+  connected_ = false;
+  peeked_ = -1;
+  tcp_.stop();
+}
+
+uint8_t TlsClient::connected() {
+  if (connected_ && !tcp_.connected() && mbedtls_ssl_get_bytes_avail(&ssl_) == 0) {
+    connected_ = false;
+  }
+  return connected_;
+}
@@ -0,0 +1,117 @@
+/**
+ * Chien de garde logiciel (voir include/watchdog.h). Compile uniquement
+ * avec WATCHDOG.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+
+#if WATCHDOG
+
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <time.h>
+#include "log.h"
+#include "reading.h"
+#include "stage_stats.h"
+#include "stall_watch.h"
+#include "watchdog.h"
+
+// Conserve a travers esp_restart() ; contenu aleatoire a la mise sous tension
+static RTC_NOINIT_ATTR StallRecord rtcStall;
+static StallRecord lastStall = {};  // Releve du blocage qui a cause ce demarrage
+static bool hasLastStall = false;
+static esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+static esp_timer_handle_t checkTimer = nullptr;
+
+static const char* resetName(esp_reset_reason_t r) {
+  switch (r) {
+    case ESP_RST_POWERON:   return "poweron";
+    case ESP_RST_EXT:       return "ext";
+    case ESP_RST_SW:        return "sw";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    default:                return "unknown";
+  }
+}
+
+/** Surveillant (tache esp_timer, priorite haute) : releve RTC puis redemarrage au premier blocage. */
+static void checkStalls(void*) {
+  uint8_t core;
+  Stall s;
+  if (!stageFindStall((uint32_t)(esp_timer_get_time() / 1000), core, s)) {
+    return;
+  }
+  StallRecord r = {};
+  r.core = core;
+  r.stage = s.stage;
+  r.fresh = 1;
+  r.stalls = rtcStall.stalls + 1;
+  r.elapsedMs = s.elapsedMs;
+  r.limitMs = s.limitMs;
+  r.uptimeS = (uint32_t)(esp_timer_get_time() / 1000000);
+  uint32_t now = (uint32_t)time(nullptr);
+  r.epoch = now >= EPOCH_VALID_MIN ? now : 0;
+  stallRecordSeal(r);
+  rtcStall = r;
+  // Directement sur l'UART : le journal ne serait pas vide avant le redemarrage
+  ets_printf("[WDT] Blocage coeur %u, etape %s : %u ms (limite %u ms), redemarrage\n", core,
+             stageName(s.stage), s.elapsedMs, s.limitMs);
+  esp_restart();
+}
+
+void watchdogBegin() {
+  resetReason = esp_reset_reason();
+  if (!stallRecordValid(rtcStall)) {
+    rtcStall = {};  // Mise sous tension : compteur de blocages a zero
+    stallRecordSeal(rtcStall);
+  } else if (rtcStall.fresh) {
+    lastStall = rtcStall;
+    hasLastStall = true;
+    LOG_W("Redemarrage sur blocage : coeur %u, etape %s, %u ms", lastStall.core,
+          stageName(lastStall.stage), lastStall.elapsedMs);
+  }
+  esp_timer_create_args_t args = {};
+  args.callback = checkStalls;
+  args.name = "watchdog";
+  if (esp_timer_create(&args, &checkTimer) != ESP_OK ||
+      esp_timer_start_periodic(checkTimer, WATCHDOG_CHECK_MS * 1000ULL) != ESP_OK) {
+    LOG_E("Chien de garde logiciel indisponible");
+  }
+}
+
+void watchdogReported() {
+  if (rtcStall.fresh) {
+    rtcStall.fresh = 0;
+    stallRecordSeal(rtcStall);
+  }
+}
+
+size_t watchdogJson(char* buf, size_t len) {
+  int n = snprintf(buf, len, "\"watchdog\":{\"reset\":\"%s\",\"stalls\":%u,\"last\":",
+                   resetName(resetReason), rtcStall.stalls);
+  if (n < 0 || (size_t)n >= len) {
+    return 0;
+  }
+  size_t pos = n;
+  if (hasLastStall) {
+    n = snprintf(buf + pos, len - pos,
+                 "{\"core\":%u,\"stage\":\"%s\",\"elapsed_ms\":%u,\"limit_ms\":%u,"
+                 "\"uptime_s\":%u,\"epoch\":%u}}",
+                 lastStall.core, stageName(lastStall.stage), lastStall.elapsedMs,
+                 lastStall.limitMs, lastStall.uptimeS, lastStall.epoch);
+  } else {
+    n = snprintf(buf + pos, len - pos, "null}");
+  }
+  if (n < 0 || (size_t)n >= len - pos) {
+    return 0;
+  }
+  return pos + n;
+}
+
+#endif
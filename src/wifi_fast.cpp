@@ -0,0 +1,160 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_netif.h>
+#include <lwip/dhcp.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "wifi_fast.h"
+#include "log.h"
+#include "reading.h"
+
+#define WIFI_CACHE_MAGIC 0x57464332UL  // "WFC2" (bail date)
+#define WIFI_CACHE_NVS_NS "wificache"
+
+struct WifiCache {
+  uint32_t magic;
+  uint8_t bssid[6];
+  int32_t channel;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+  uint32_t leaseS;     // Duree du bail DHCP, 0 : adresse statique (sans echeance)
+  uint32_t acquired;   // Heure UNIX d'obtention du bail, 0 si inconnue
+};
+
+static RTC_DATA_ATTR WifiCache rtcCache;
+static bool fastApplied = false;  // Bail en cache applique en statique : pas de client DHCP
+
+/** Heure UNIX, 0 tant qu'elle n'est pas connue. */
+static uint32_t epochNow() {
+  uint32_t now = (uint32_t)time(nullptr);
+  return now >= EPOCH_VALID_MIN ? now : 0;
+}
+
+/** Duree du bail obtenu par le client DHCP lwIP (WIFI_LEASE_DEFAULT_S si illisible). */
+static uint32_t dhcpLeaseS() {
+  esp_netif_t* nif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif* n = nif ? (struct netif*)esp_netif_get_netif_impl(nif) : nullptr;
+  struct dhcp* d = n ? netif_dhcp_data(n) : nullptr;
+  return d && d->offered_t0_lease > 0 ? d->offered_t0_lease : WIFI_LEASE_DEFAULT_S;
+}
+
+/**
+ * Charge le cache : memoire RTC en priorite, sinon NVS (demarrage a froid).
+ */
+static bool loadCache(WifiCache& c) {
+  if (rtcCache.magic == WIFI_CACHE_MAGIC) {
+    c = rtcCache;
+    return true;
+  }
+  Preferences prefs;
+  if (!prefs.begin(WIFI_CACHE_NVS_NS, true)) {
+    return false;
+  }
+  size_t len = prefs.getBytes("cache", &c, sizeof(c));
+  prefs.end();
+  if (len != sizeof(c) || c.magic != WIFI_CACHE_MAGIC) {
+    return false;
+  }
+  rtcCache = c;
+  return true;
+}
+
+/**
+ * Applique l'adresse IP : statique si configuree, sinon le bail memorise
+ * (ip = 0 pour repasser en DHCP).
+ */
+static void applyIpConfig(uint32_t ip, uint32_t gateway, uint32_t mask, uint32_t dns) {
+#ifdef WIFI_STATIC_IP
+  (void)ip; (void)gateway; (void)mask; (void)dns;
+  WiFi.config(IPAddress(WIFI_STATIC_IP), IPAddress(WIFI_STATIC_GATEWAY),
+              IPAddress(WIFI_STATIC_MASK), IPAddress(WIFI_STATIC_DNS));
+#else
+  WiFi.config(IPAddress(ip), IPAddress(gateway), IPAddress(mask), IPAddress(dns));
+#endif
+}
+
+bool wifiBeginFast() {
+  WifiCache c;
+  fastApplied = false;
+  if (!loadCache(c)) {
+    return false;
+  }
+  // Bail a mi-vie : le serveur peut avoir reattribue l'adresse, retour au DHCP
+  uint32_t now = epochNow();
+  if (c.leaseS > 0 && c.acquired > 0 && now > 0 && now - c.acquired >= c.leaseS / 2) {
+    LOG_I("Bail DHCP en cache a mi-vie, connexion complete");
+    return false;
+  }
+  fastApplied = true;
+  WiFi.persistent(false);  // Pas d'ecriture flash par le SDK a chaque connexion
+  WiFi.mode(WIFI_STA);
+  applyIpConfig(c.ip, c.gateway, c.mask, c.dns);
+  LOG_I("Connexion WiFi rapide a %s (canal %d)...", WIFI_SSID, c.channel);
+  WiFi.begin(WIFI_SSID, WIFI_PASS, c.channel, c.bssid);
+  return true;
+}
+
+void wifiBeginFull() {
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  WiFi.disconnect();
+  fastApplied = false;
+  applyIpConfig(0, 0, 0, 0);
+  LOG_I("Connexion WiFi a %s...", WIFI_SSID);
+  WiFi.begin(WIFI_SSID, WIFI_PASS);
+}
+
+void wifiCacheStore() {
+  WifiCache c = {};
+  c.magic = WIFI_CACHE_MAGIC;
+  memcpy(c.bssid, WiFi.BSSID(), sizeof(c.bssid));
+  c.channel = WiFi.channel();
+  c.ip = WiFi.localIP();
+  c.gateway = WiFi.gatewayIP();
+  c.mask = WiFi.subnetMask();
+  c.dns = WiFi.dnsIP();
+#ifdef WIFI_STATIC_IP
+  c.leaseS = 0;
+#else
+  if (fastApplied) {
+    // Adresse reprise du cache : le bail n'a pas ete renouvele
+    c.leaseS = rtcCache.leaseS;
+    c.acquired = rtcCache.acquired;
+  } else {
+    c.leaseS = dhcpLeaseS();
+  }
+  if (c.acquired == 0) {
+    // Heure inconnue a l'obtention : datee a la premiere connexion rapide qui la connait
+    c.acquired = epochNow();
+  }
+#endif
+
+  bool changed = memcmp(&c, &rtcCache, sizeof(c)) != 0;
+  rtcCache = c;
+  if (!changed) {
+    return;
+  }
+  // NVS : ecrit uniquement si le point d'acces ou le bail a change
+  Preferences prefs;
+  if (prefs.begin(WIFI_CACHE_NVS_NS, false)) {
+    WifiCache stored;
+    if (prefs.getBytes("cache", &stored, sizeof(stored)) != sizeof(stored) ||
+        memcmp(&stored, &c, sizeof(c)) != 0) {
+      prefs.putBytes("cache", &c, sizeof(c));
+    }
+    prefs.end();
+  }
+}
+
+void wifiCacheInvalidate() {
+  rtcCache.magic = 0;
+  Preferences prefs;
+  if (prefs.begin(WIFI_CACHE_NVS_NS, false)) {
+    prefs.remove("cache");
+    prefs.end();
+  }
+}
@@ -0,0 +1,232 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unity.h>
+#include "adc_cal.h"
+#include "adc_filter.h"
+#include "compress.h"
+#include "dht_decoder.h"
+#include "encoder.h"
+#include "ntc_lut.h"
+#include "payload.h"
+#include "timefmt.h"
+#include "welford.h"
+
+/**
+ * Micro-benchmarks de la chaine de traitement (conversion, filtrage,
+ * encodage, horodatage) sur l'hote : `pio test -e native -f test_bench`.
+ *
+ * Chaque mesure est le meilleur de BENCH_REPEAT series d'appels, en ns par
+ * appel, et s'affiche sous la forme "[bench] nom : X ns/appel". Le plafond
+ * de chaque mesure est large (un ordre de grandeur au-dessus d'un PC de
+ * bureau) : il signale une regression grossiere (allocation, printf,
+ * recalcul du fuseau) et non une variation de quelques pourcents. Il est
+ * multiplie par BENCH_BUDGET_SCALE pour une machine d'integration lente.
+ */
+
+#ifndef BENCH_REPEAT
+#define BENCH_REPEAT 7
+#endif
+#ifndef BENCH_MIN_NS
+#define BENCH_MIN_NS 20000000ULL   // Duree minimale d'une serie (20 ms)
+#endif
+#ifndef BENCH_BUDGET_SCALE
+#define BENCH_BUDGET_SCALE 1.0
+#endif
+
+static volatile uint32_t sink;
+
+/** Empeche le compilateur d'eliminer un resultat inutilise. */
+template<typename T>
+static inline void keep(const T& v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+template<typename F>
+static double nsPerCall(F&& fn) {
+  using clock = std::chrono::steady_clock;
+  // Calibrage : nombre d'appels pour une serie d'au moins BENCH_MIN_NS
+  uint64_t iters = 1;
+  for (;;) {
+    auto t0 = clock::now();
+    for (uint64_t i = 0; i < iters; i++) {
+      fn(i);
+    }
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+    if (ns >= BENCH_MIN_NS || iters >= (1ULL << 30)) {
+      break;
+    }
+    iters *= 2;
+  }
+  double best = 1e30;
+  for (int r = 0; r < BENCH_REPEAT; r++) {
+    auto t0 = clock::now();
+    for (uint64_t i = 0; i < iters; i++) {
+      fn(i);
+    }
+    double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / iters;
+    if (ns < best) {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+static void report(const char* name, double ns, double budgetNs) {
+  char msg[96];
+  snprintf(msg, sizeof(msg), "[bench] %-22s : %10.1f ns/appel (plafond %.0f)", name, ns,
+           budgetNs * BENCH_BUDGET_SCALE);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE_MESSAGE(ns <= budgetNs * BENCH_BUDGET_SCALE, name);
+}
+
+static PackedReading sampleReading(uint32_t i) {
+  PackedReading p = {};
+  p.seq = i;
+  p.epoch = 1770561000 + i * 10;
+  p.centi[CH_DHT_TEMP] = 2070 + (i & 7);
+  p.centi[CH_DHT_HUM] = 5200;
+  p.centi[CH_NTC_TEMP] = -525 + (i & 15);
+  p.centi[CH_LUMINOSITY] = 7700;
+  p.valid = 0x0F;
+  return p;
+}
+
+static PackedReading batch[10];
+static PackedReading backlog[120];
+static uint16_t burst[64];
+
+void setUp() {
+  setenv("TZ", TZ_FRANCE, 1);
+  tzset();
+  srand(1);
+  for (int i = 0; i < 64; i++) {
+    burst[i] = 2000 + rand() % 9 - 4;
+  }
+  burst[13] = 4095;  // Pic
+  for (int i = 0; i < 10; i++) {
+    batch[i] = sampleReading(i);
+  }
+  for (int i = 0; i < 120; i++) {
+    backlog[i] = sampleReading(i);
+  }
+}
+
+void tearDown() {}
+
+void bench_conversion() {
+  report("ntc_lut", nsPerCall([](uint64_t i) {
+    float t = ntcTempFromRaw(i & 0x0FFF);
+    keep(t);
+  }), 20);
+  report("ntc_lut_interp", nsPerCall([](uint64_t i) {
+    float t = ntcTempFromRawInterp((i & 0x0FFF) + 0.37f);
+    keep(t);
+  }), 50);
+  report("ldr_pct", nsPerCall([](uint64_t i) {
+    float l = ldrPctFromRaw((i & 0x0FFF) + 0.5f);
+    keep(l);
+  }), 20);
+  static uint16_t table[4096];
+  report("adc_cal_build (4096)", nsPerCall([](uint64_t i) {
+    for (int raw = 0; raw < 4096; raw++) {
+      table[raw] = (uint16_t)(142 + raw * 3 / 4 + (i & 1));
+    }
+    adcCalBuild(table, table, ADC_SUPPLY_MV);
+    keep(table);
+  }), 250000);
+}
+
+template<uint8_t W>
+static double benchFilter(AdcFilterKind kind) {
+  static SampleFilter<W> f(kind, ADC_FILTER_TRIM_PCT, ADC_FILTER_IIR_ALPHA);
+  f = SampleFilter<W>(kind, ADC_FILTER_TRIM_PCT, ADC_FILTER_IIR_ALPHA);
+  return nsPerCall([](uint64_t) {
+    f.begin();
+    for (int i = 0; i < 64; i++) {
+      f.add(burst[i]);
+    }
+    float v = f.result();
+    keep(v);
+  });
+}
+
+void bench_filtering() {
+  report("filtre_mean (64)", benchFilter<ADC_FILTER_WINDOW>(ADC_FILTER_MEAN), 1500);
+  report("filtre_median (64)", benchFilter<ADC_FILTER_WINDOW>(ADC_FILTER_MEDIAN), 5000);
+  report("filtre_trimmed (64)", benchFilter<ADC_FILTER_WINDOW>(ADC_FILTER_TRIMMED), 5000);
+  report("filtre_iir (64)", benchFilter<ADC_FILTER_WINDOW>(ADC_FILTER_IIR), 2500);
+  static Welford w;
+  w.reset();
+  report("welford_add", nsPerCall([](uint64_t i) {
+    w.add((float)(i & 1023));
+    keep(w);
+  }), 150);
+}
+
+void bench_encoding() {
+  static char json[1536];
+  static uint8_t bin[256];
+  report("json_reading", nsPerCall([](uint64_t i) {
+    sink += formatReadingJson(json, sizeof(json), batch[i % 10]);
+  }), 1500);
+  report("json_batch (10)", nsPerCall([](uint64_t) {
+    uint16_t count;
+    sink += formatBatchJson(json, sizeof(json), batch, 10, count);
+  }), 12000);
+  report("binary (10)", nsPerCall([](uint64_t) {
+    uint16_t count;
+    sink += encodeBinary(bin, sizeof(bin), batch, 10, count);
+  }), 500);
+  report("cbor (10)", nsPerCall([](uint64_t) {
+    uint16_t count;
+    sink += encodeCbor(bin, sizeof(bin), batch, 10, count);
+  }), 3000);
+  static uint8_t packed[2048];
+  static uint8_t columns[2048];
+  report("compress (120)", nsPerCall([](uint64_t) {
+    uint16_t count;
+    sink += encodeCompressed(packed, sizeof(packed), backlog, 120, count, columns,
+                             sizeof(columns));
+  }), 300000);
+
+  static DhtPulse pulses[96];
+  static const uint8_t frame[5] = {52, 0, 21, 3, 76};
+  size_t n = 0;
+  pulses[n++] = {1, 30};
+  pulses[n++] = {0, 80};
+  pulses[n++] = {1, 80};
+  for (int i = 0; i < DHT_FRAME_BITS; i++) {
+    pulses[n++] = {0, 50};
+    pulses[n++] = {1, (uint16_t)(((frame[i / 8] >> (7 - i % 8)) & 1) ? 70 : 27)};
+  }
+  pulses[n++] = {0, 50};
+  pulses[n++] = {1, 0};
+  static size_t pulseCount;
+  pulseCount = n;
+  report("dht_decode", nsPerCall([](uint64_t) {
+    uint8_t data[5];
+    sink += dhtDecodeFrame(pulses, pulseCount, data);
+    keep(data);
+  }), 2000);
+}
+
+void bench_timestamp() {
+  static char ts[TIMESTAMP_LEN];
+  report("iso8601", nsPerCall([](uint64_t i) {
+    sink += formatIso8601(ts, sizeof(ts), 1770561000 + (uint32_t)i * 10, 3600);
+  }), 400);
+  report("timestamp (cache tz)", nsPerCall([](uint64_t i) {
+    sink += formatTimestamp(ts, sizeof(ts), 1770561000 + (uint32_t)(i & 0xFFFF) * 10);
+  }), 400);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(bench_conversion);
+  RUN_TEST(bench_filtering);
+  RUN_TEST(bench_encoding);
+  RUN_TEST(bench_timestamp);
+  return UNITY_END();
+}
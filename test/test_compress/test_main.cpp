@@ -0,0 +1,128 @@
+#include <string.h>
+#include <unity.h>
+#include "compress.h"
+
+/**
+ * Lots compresses du rejeu : LZSS, colonnes delta et message complet.
+ */
+
+// Serie realiste : un releve toutes les 10 s, variations lentes
+static void series(PackedReading* b, uint16_t n) {
+  for (uint16_t i = 0; i < n; i++) {
+    b[i] = {};
+    b[i].seq = 1000 + i;
+    b[i].epoch = 1770561000u + 10 * i;
+    b[i].valid = 0x0F;
+    b[i].centi[0] = 2070 + (i / 7) % 3;
+    b[i].centi[1] = 5200 - (i / 11);
+    b[i].centi[2] = -150 + (i % 2);
+    b[i].centi[3] = 7700;
+  }
+}
+
+static uint8_t scratch[4096];
+
+void setUp() {}
+void tearDown() {}
+
+void test_lzss_round_trip() {
+  const char* text = "abcabcabcabcabcabc-xyz-xyz-xyz aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+  size_t n = strlen(text);
+  uint8_t z[128], back[128];
+  size_t zl = lzssCompress(z, sizeof(z), (const uint8_t*)text, n);
+  TEST_ASSERT_TRUE(zl > 0 && zl < n);
+  TEST_ASSERT_EQUAL_UINT32(n, lzssDecompress(back, n, z, zl));
+  TEST_ASSERT_EQUAL_MEMORY(text, back, n);
+  // Flux tronque ou trop petit
+  TEST_ASSERT_EQUAL_UINT32(0, lzssDecompress(back, n, z, zl / 2));
+  TEST_ASSERT_EQUAL_UINT32(0, lzssCompress(z, 4, (const uint8_t*)text, n));
+}
+
+void test_lzss_incompressible() {
+  uint8_t in[200], z[256], back[200];
+  uint32_t x = 12345;
+  for (size_t i = 0; i < sizeof(in); i++) {
+    x = x * 1103515245u + 12345u;
+    in[i] = x >> 24;
+  }
+  size_t zl = lzssCompress(z, sizeof(z), in, sizeof(in));
+  TEST_ASSERT_TRUE(zl > 0 && zl <= sizeof(in) * 9 / 8 + 1);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(in), lzssDecompress(back, sizeof(in), z, zl));
+  TEST_ASSERT_EQUAL_MEMORY(in, back, sizeof(in));
+}
+
+void test_columnar_round_trip_and_deltas() {
+  PackedReading in[40], out[40];
+  series(in, 40);
+  in[5].valid = 0x0B;  // Canal en erreur
+  in[5].centi[2] = 0;
+  size_t cols = columnarEncode(scratch, sizeof(scratch), in, 40);
+  // Ecarts d'un octet, sauf la premiere valeur de chaque colonne (5 au plus)
+  const size_t fields = 5 + CH_COUNT + (AGGREGATE_WINDOW > 0 ? 4 * CH_COUNT : 0);
+  TEST_ASSERT_TRUE(cols <= 40 * fields + 4 * fields);
+  TEST_ASSERT_TRUE(columnarDecode(out, 40, scratch, cols));
+  TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+  TEST_ASSERT_FALSE(columnarDecode(out, 40, scratch, cols - 1));
+  TEST_ASSERT_EQUAL_UINT32(0, columnarEncode(scratch, 10, in, 40));
+}
+
+void test_message_round_trip_and_ratio() {
+  static PackedReading in[120], out[255];
+  series(in, 120);
+  uint8_t buf[2048];
+  uint16_t count;
+  size_t n = encodeCompressed(buf, sizeof(buf), in, 120, count, scratch, sizeof(scratch));
+  TEST_ASSERT_EQUAL_UINT16(120, count);
+  TEST_ASSERT_EQUAL_UINT8(COMPRESS_LZSS, buf[3]);
+  // Au moins 8 fois plus petit que les releves compacts
+  TEST_ASSERT_TRUE(n * 8 < 120 * sizeof(PackedReading));
+
+  uint16_t got;
+  TEST_ASSERT_TRUE(decodeCompressed(buf, n, out, 255, got, scratch, sizeof(scratch)));
+  TEST_ASSERT_EQUAL_UINT16(120, got);
+  TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+
+  // Deterministe : meme lot, memes octets (retransmission QoS 1)
+  uint8_t again[2048];
+  TEST_ASSERT_EQUAL_UINT32(n, encodeCompressed(again, sizeof(again), in, 120, count, scratch,
+                                               sizeof(scratch)));
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, n);
+
+  buf[1]++;  // Autre format de releve
+  TEST_ASSERT_FALSE(decodeCompressed(buf, n, out, 255, got, scratch, sizeof(scratch)));
+  buf[1]--;
+  TEST_ASSERT_FALSE(decodeCompressed(buf, n, out, 100, got, scratch, sizeof(scratch)));
+}
+
+void test_message_halves_when_too_large() {
+  static PackedReading in[200];
+  uint32_t x = 7;
+  for (uint16_t i = 0; i < 200; i++) {
+    x = x * 1103515245u + 12345u;
+    in[i] = {};
+    in[i].seq = x;
+    in[i].epoch = x ^ 0x5A5A5A5A;
+  }
+  uint8_t buf[512];
+  uint16_t count;
+  size_t n = encodeCompressed(buf, sizeof(buf), in, 200, count, scratch, sizeof(scratch));
+  TEST_ASSERT_TRUE(n > 0 && n <= sizeof(buf));
+  TEST_ASSERT_TRUE(count > 0 && count < 200);
+  // Le meme nombre de releves redonne le meme message
+  uint8_t again[512];
+  uint16_t count2;
+  TEST_ASSERT_EQUAL_UINT32(n, encodeCompressed(again, sizeof(again), in, count, count2, scratch,
+                                               sizeof(scratch)));
+  TEST_ASSERT_EQUAL_UINT16(count, count2);
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, n);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lzss_round_trip);
+  RUN_TEST(test_lzss_incompressible);
+  RUN_TEST(test_columnar_round_trip_and_deltas);
+  RUN_TEST(test_message_round_trip_and_ratio);
+  RUN_TEST(test_message_halves_when_too_large);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <math.h>
+#include <stdlib.h>
+#include <unity.h>
+#include "adc_cal.h"
+#include "ntc_lut.h"
+
+/**
+ * Conversions ADC -> grandeurs physiques (table NTC, LDR, calibration),
+ * sur le code C++ du firmware compile pour l'hote.
+ */
+
+static double betaTemp(double raw) {
+  double r = R_SERIES * raw / (ADC_MAX - raw);
+  return 1.0 / (1.0 / (T_NOMINAL + 273.15) + log(r / R_NOMINAL) / B_COEFF) - 273.15;
+}
+
+/** Courbe typique ADC1 a 11 dB : decalage bas et compression haute (mV). */
+static uint16_t esp32AdcMv(int raw) {
+  return (uint16_t)lround(142 + 0.78 * raw + 4.5e-5 * raw * raw - 1.4e-8 * raw * raw * raw);
+}
+
+static uint16_t table[4096];
+
+void setUp() {}
+void tearDown() {}
+
+void test_lut_matches_beta_equation() {
+  for (int raw = 1; raw < ADC_MAX; raw += 7) {
+    TEST_ASSERT_FLOAT_WITHIN(0.006, betaTemp(raw), ntcTempFromRaw(raw));
+  }
+}
+
+void test_lut_reference_point() {
+  // R = R_NOMINAL a T_NOMINAL : raw = 4095 * 1760 / 11760
+  TEST_ASSERT_FLOAT_WITHIN(0.05, T_NOMINAL, ntcTempFromRaw(613));
+}
+
+void test_lut_monotonic_and_clamped() {
+  for (int raw = 1; raw < NTC_LUT_SIZE; raw++) {
+    TEST_ASSERT_LESS_OR_EQUAL(NTC_LUT.centi[raw - 1], NTC_LUT.centi[raw]);
+  }
+  TEST_ASSERT_EQUAL_INT16(NTC_LUT.centi[1], NTC_LUT.centi[0]);
+  TEST_ASSERT_EQUAL_INT16(NTC_LUT.centi[ADC_MAX - 1], NTC_LUT.centi[ADC_MAX]);
+  TEST_ASSERT_EQUAL_FLOAT(ntcTempFromRaw(ADC_MAX), ntcTempFromRaw(60000));
+}
+
+void test_interp_fractional_raw() {
+  for (float raw = 100.25f; raw < 4000.0f; raw += 97.5f) {
+    TEST_ASSERT_FLOAT_WITHIN(0.01, betaTemp(raw), ntcTempFromRawInterp(raw));
+  }
+  TEST_ASSERT_EQUAL_FLOAT(ntcTempFromRaw(0), ntcTempFromRawInterp(-3.0f));
+  TEST_ASSERT_EQUAL_FLOAT(ntcTempFromRaw(ADC_MAX), ntcTempFromRawInterp(5000.0f));
+}
+
+void test_ldr_percentage() {
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, ldrPctFromRaw(0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 100.0, ldrPctFromRaw(ADC_MAX));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 50.0, ldrPctFromRaw(2047.5f));
+}
+
+void test_cal_linear_adc_is_identity() {
+  for (int raw = 0; raw < 4096; raw++) {
+    table[raw] = (uint16_t)lround(raw * 3300.0 / 4095);
+  }
+  adcCalBuild(table, table, 3300);
+  for (int raw = 8; raw < 4088; raw++) {
+    TEST_ASSERT_LESS_OR_EQUAL(ADC_CAL_FRAC / 4, abs(table[raw] - raw * ADC_CAL_FRAC));
+  }
+}
+
+void test_cal_monotonic_and_clamped() {
+  for (int raw = 0; raw < 4096; raw++) {
+    table[raw] = esp32AdcMv(raw);
+  }
+  adcCalBuild(table, table, 3300);
+  for (int raw = 1; raw < 4096; raw++) {
+    TEST_ASSERT_LESS_OR_EQUAL(table[raw], table[raw - 1]);
+  }
+  for (int raw = 0; raw < 4096; raw++) {
+    table[raw] = 3400;
+  }
+  adcCalBuild(table, table, 3300);
+  TEST_ASSERT_EQUAL_UINT16(4095 * ADC_CAL_FRAC, table[0]);
+  TEST_ASSERT_EQUAL_UINT16(4095 * ADC_CAL_FRAC, table[4095]);
+}
+
+void test_cal_improves_ntc_accuracy() {
+  uint16_t mv[4096];
+  for (int raw = 0; raw < 4096; raw++) {
+    mv[raw] = table[raw] = esp32AdcMv(raw);
+  }
+  adcCalBuild(table, table, 3300);
+  double worstRaw = 0.0;
+  double worstCal = 0.0;
+  for (int code = 600; code < 3600; code += 50) {
+    double expected = betaTemp(code);
+    double target = code * 3300.0 / 4095;
+    int raw = 0;
+    for (int r = 1; r < 4096; r++) {
+      if (fabs(mv[r] - target) < fabs(mv[raw] - target)) {
+        raw = r;
+      }
+    }
+    worstRaw = fmax(worstRaw, fabs(ntcTempFromRaw(raw) - expected));
+    worstCal = fmax(worstCal, fabs(ntcTempFromRawInterp(table[raw] / (float)ADC_CAL_FRAC) - expected));
+  }
+  TEST_ASSERT_TRUE(worstRaw > 1.0);
+  TEST_ASSERT_TRUE(worstCal < 0.2);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lut_matches_beta_equation);
+  RUN_TEST(test_lut_reference_point);
+  RUN_TEST(test_lut_monotonic_and_clamped);
+  RUN_TEST(test_interp_fractional_raw);
+  RUN_TEST(test_ldr_percentage);
+  RUN_TEST(test_cal_linear_adc_is_identity);
+  RUN_TEST(test_cal_monotonic_and_clamped);
+  RUN_TEST(test_cal_improves_ntc_accuracy);
+  return UNITY_END();
+}
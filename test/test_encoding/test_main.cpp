@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+#include "dht_decoder.h"
+#include "encoder.h"
+#include "payload.h"
+#include "sensor_registry.h"
+
+/**
+ * Payloads JSON, encodages binaires, registre des capteurs et decodage des
+ * trames DHT.
+ * Configuration par defaut : BINARY v1, CBOR v1, sans agregation.
+ */
+
+static PackedReading reading() {
+  Reading r = {};
+  r.seq = 1;
+  r.epoch = 1770561000;  // 2026-02-08T14:30:00Z
+  r.value[CH_DHT_TEMP] = 20.7f;
+  r.value[CH_DHT_HUM] = 52.0f;
+  r.value[CH_NTC_TEMP] = 21.1f;
+  r.value[CH_LUMINOSITY] = 77.0f;
+  r.valid = 0x0F;
+  return packReading(r);
+}
+
+static PackedReading readingDhtKo() {
+  PackedReading p = reading();
+  p.epoch = 1770561010;
+  p.valid = 0x0C;
+  p.centi[CH_DHT_TEMP] = p.centi[CH_DHT_HUM] = 0;
+  p.centi[CH_NTC_TEMP] = -525;
+  p.centi[CH_LUMINOSITY] = 0;
+  return p;
+}
+
+/** Capture RMT synthetique : liberation, reponse, 40 bits, repos final. */
+static size_t dhtFrame(DhtPulse* out, const uint8_t data[5], uint16_t oneUs = 70, uint16_t zeroUs = 27) {
+  size_t n = 0;
+  out[n++] = {1, 30};
+  out[n++] = {0, 80};
+  out[n++] = {1, 80};
+  for (int i = 0; i < DHT_FRAME_BITS; i++) {
+    bool bit = (data[i / 8] >> (7 - i % 8)) & 1;
+    out[n++] = {0, 50};
+    out[n++] = {1, bit ? oneUs : zeroUs};
+  }
+  out[n++] = {0, 50};
+  out[n++] = {1, 0};
+  return n;
+}
+
+// Capteurs fictifs du registre : journal des appels dans l'ordre
+static char probeCalls[8];
+static int probeCount = 0;
+
+struct FakeClimate {
+  static constexpr uint8_t MASK = (1 << CH_DHT_TEMP) | (1 << CH_DHT_HUM);
+  static void begin() { probeCalls[probeCount++] = 'C'; }
+  static void sample(Reading& r) {
+    probeCalls[probeCount++] = 'c';
+    r.value[CH_DHT_TEMP] = 20.7f;
+    r.value[CH_DHT_HUM] = 52.0f;
+    r.valid |= MASK;
+  }
+  static void log(const Reading&) {}
+};
+
+struct FakeAnalog {
+  static constexpr uint8_t MASK = (1 << CH_NTC_TEMP) | (1 << CH_LUMINOSITY);
+  static void begin() { probeCalls[probeCount++] = 'A'; }
+  static void sample(Reading& r) {
+    probeCalls[probeCount++] = 'a';
+    r.value[CH_NTC_TEMP] = 21.1f;
+    r.value[CH_LUMINOSITY] = 77.0f;
+    r.valid |= MASK;
+  }
+  static void log(const Reading&) {}
+};
+
+void setUp() {
+  setenv("TZ", TZ_FRANCE, 1);
+  tzset();
+}
+
+void tearDown() {}
+
+void test_reading_json() {
+  char buf[512];
+  size_t n = formatReadingJson(buf, sizeof(buf), reading());
+  TEST_ASSERT_EQUAL_STRING(
+    "{\"timestamp\":\"2026-02-08T15:30:00+01:00\",\"user\":\"" MQTT_USER "\","
+    "\"device\":\"" MQTT_DEVICE "\",\"dht_temperature\":20.7,\"dht_humidity\":52.0,"
+    "\"ntc_temperature\":21.1,\"luminosity\":77.0}", buf);
+  TEST_ASSERT_EQUAL(strlen(buf), n);
+}
+
+void test_reading_json_too_small() {
+  char buf[64];
+  TEST_ASSERT_EQUAL(0, formatReadingJson(buf, sizeof(buf), reading()));
+}
+
+void test_batch_json_null_and_truncation() {
+  PackedReading batch[3] = {reading(), readingDhtKo(), reading()};
+  char buf[512];
+  uint16_t count = 0;
+  size_t n = formatBatchJson(buf, sizeof(buf), batch, 2, count);
+  TEST_ASSERT_EQUAL_UINT16(2, count);
+  TEST_ASSERT_EQUAL(strlen(buf), n);
+  TEST_ASSERT_NOT_NULL(strstr(buf, "\"dht_temperature\":null,\"dht_humidity\":null,"
+                                   "\"ntc_temperature\":-5.3,\"luminosity\":0.0}]}"));
+  // Tampon trop court pour trois releves : les releves complets sont gardes
+  n = formatBatchJson(buf, 300, batch, 3, count);
+  TEST_ASSERT_EQUAL_UINT16(1, count);
+  TEST_ASSERT_EQUAL_STRING("]}", buf + n - 2);
+}
+
+void test_binary_v1_bytes() {
+  static const uint8_t expected[] = {0x01, 0x01, 0xe8, 0x9d, 0x88, 0x69, 0x0f, 0x16, 0x08,
+                                     0x50, 0x14, 0x3e, 0x08, 0x14, 0x1e};
+  PackedReading r = reading();
+  uint8_t buf[64];
+  uint16_t count = 0;
+  size_t n = encodeBinary(buf, sizeof(buf), &r, 1, count);
+  TEST_ASSERT_EQUAL(sizeof(expected), n);
+  TEST_ASSERT_EQUAL_UINT16(1, count);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, n);
+}
+
+void test_binary_limited_by_buffer() {
+  PackedReading batch[10];
+  for (int i = 0; i < 10; i++) {
+    batch[i] = reading();
+  }
+  uint8_t buf[BINARY_HEADER_SIZE + 4 * BINARY_RECORD_SIZE + 5];
+  uint16_t count = 0;
+  TEST_ASSERT_EQUAL(BINARY_HEADER_SIZE + 4 * BINARY_RECORD_SIZE,
+                    encodeBinary(buf, sizeof(buf), batch, 10, count));
+  TEST_ASSERT_EQUAL_UINT16(4, count);
+  TEST_ASSERT_EQUAL_UINT8(4, buf[1]);
+}
+
+void test_cbor_bytes() {
+  static const uint8_t expected[] = {0x82, 0x01, 0x82,
+                                     0x85, 0x1a, 0x69, 0x88, 0x9d, 0xe8, 0x19, 0x08, 0x16,
+                                     0x19, 0x14, 0x50, 0x19, 0x08, 0x3e, 0x19, 0x1e, 0x14,
+                                     0x85, 0x1a, 0x69, 0x88, 0x9d, 0xf2, 0xf6, 0xf6,
+                                     0x39, 0x02, 0x0c, 0x00};
+  PackedReading batch[2] = {reading(), readingDhtKo()};
+  uint8_t buf[64];
+  uint16_t count = 0;
+  size_t n = encodeCbor(buf, sizeof(buf), batch, 2, count);
+  TEST_ASSERT_EQUAL(sizeof(expected), n);
+  TEST_ASSERT_EQUAL_UINT16(2, count);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, n);
+}
+
+void test_dht_valid_frame() {
+  const uint8_t frame[5] = {52, 0, 21, 3, 76};
+  DhtPulse pulses[96];
+  uint8_t data[5];
+  TEST_ASSERT_EQUAL(DHT_OK, dhtDecodeFrame(pulses, dhtFrame(pulses, frame), data));
+  TEST_ASSERT_EQUAL_MEMORY(frame, data, 5);
+  float t, h;
+  dhtConvert(data, DHT11, t, h);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 21.3, t);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 52.0, h);
+}
+
+void test_dht_errors() {
+  const uint8_t bad[5] = {52, 0, 21, 3, 77};
+  DhtPulse pulses[96];
+  uint8_t data[5];
+  size_t n = dhtFrame(pulses, bad);
+  TEST_ASSERT_EQUAL(DHT_ERR_CHECKSUM, dhtDecodeFrame(pulses, n, data));
+  TEST_ASSERT_EQUAL(DHT_ERR_FRAME, dhtDecodeFrame(pulses, 40, data));
+  TEST_ASSERT_EQUAL(DHT_ERR_TIMEOUT, dhtDecodeFrame(pulses, 0, data));
+}
+
+void test_dht_timing_tolerance() {
+  const uint8_t frame[5] = {52, 0, 21, 3, 76};
+  DhtPulse pulses[96];
+  uint8_t data[5];
+  TEST_ASSERT_EQUAL(DHT_OK, dhtDecodeFrame(pulses, dhtFrame(pulses, frame, 58, 40), data));
+  TEST_ASSERT_EQUAL(DHT_OK, dhtDecodeFrame(pulses, dhtFrame(pulses, frame, 85, 15), data));
+  TEST_ASSERT_EQUAL_MEMORY(frame, data, 5);
+}
+
+void test_registry_dispatch() {
+  using Fake = SensorRegistry<FakeClimate, FakeAnalog>;
+  static_assert(Fake::MASK == ALL_CHANNELS, "masque du registre");
+  TEST_ASSERT_EQUAL(2, Fake::count());
+  probeCount = 0;
+  Fake::begin();
+  Reading r = {};
+  r.seq = 1;
+  r.epoch = 1770561000;
+  Fake::sample(r);
+  probeCalls[probeCount] = '\0';
+  TEST_ASSERT_EQUAL_STRING("CAca", probeCalls);
+  // Meme payload que le releve construit a la main
+  char expected[512], actual[512];
+  formatReadingJson(expected, sizeof(expected), reading());
+  formatReadingJson(actual, sizeof(actual), packReading(r));
+  TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+void test_registry_channel_table() {
+  constexpr ChannelValues bands = channelValues(&ChannelInfo::deadband);
+  static_assert(bands.v[CH_NTC_TEMP] == DEADBAND_NTC_TEMP, "resolu a la compilation");
+  TEST_ASSERT_EQUAL_STRING("luminosity", CHANNELS[CH_LUMINOSITY].key);
+  TEST_ASSERT_EQUAL_INT16(ADAPT_STEP_DHT_HUM, channelValues(&ChannelInfo::adaptStep).v[CH_DHT_HUM]);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reading_json);
+  RUN_TEST(test_reading_json_too_small);
+  RUN_TEST(test_batch_json_null_and_truncation);
+  RUN_TEST(test_binary_v1_bytes);
+  RUN_TEST(test_binary_limited_by_buffer);
+  RUN_TEST(test_cbor_bytes);
+  RUN_TEST(test_registry_dispatch);
+  RUN_TEST(test_registry_channel_table);
+  RUN_TEST(test_dht_valid_frame);
+  RUN_TEST(test_dht_errors);
+  RUN_TEST(test_dht_timing_tolerance);
+  return UNITY_END();
+}
@@ -0,0 +1,127 @@
+#include <string.h>
+#include <unity.h>
+#include "espnow_frame.h"
+
+/**
+ * Trames ESP-NOW feuille -> passerelle : releves bruts et acquittement.
+ */
+
+static PackedReading sample(uint32_t seq) {
+  PackedReading p = {};
+  p.seq = seq;
+  p.epoch = 1700000000u + seq;
+  for (int ch = 0; ch < CH_COUNT; ch++) {
+    p.centi[ch] = (int16_t)(seq * 10 + ch);
+  }
+  return p;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_readings_round_trip() {
+  PackedReading in[3] = {sample(1), sample(2), sample(3)};
+  uint8_t buf[ESPNOW_FRAME_MAX];
+  uint16_t count;
+  size_t n = espnowEncodeReadings(buf, sizeof(buf), 0xBEEF, 4242, "jardin", in, 3, count);
+  TEST_ASSERT_EQUAL_UINT16(3, count);
+  TEST_ASSERT_EQUAL_UINT32(ESPNOW_READINGS_HEAD + 6 + 3 * sizeof(PackedReading), n);
+  TEST_ASSERT_EQUAL_UINT8(ESPNOW_READINGS, espnowFrameType(buf, n));
+
+  PackedReading out[ESPNOW_FRAME_READINGS];
+  char name[ESPNOW_DEVICE_MAX + 1];
+  uint16_t seq, got;
+  uint32_t clock;
+  TEST_ASSERT_TRUE(
+      espnowDecodeReadings(buf, n, seq, clock, name, out, ESPNOW_FRAME_READINGS, got));
+  TEST_ASSERT_EQUAL_HEX16(0xBEEF, seq);
+  TEST_ASSERT_EQUAL_UINT32(4242, clock);
+  TEST_ASSERT_EQUAL_STRING("jardin", name);
+  TEST_ASSERT_EQUAL_UINT16(3, got);
+  TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+
+  // Renvoi : seule l'horloge change
+  espnowSetClock(buf, n, 0x01020304);
+  TEST_ASSERT_TRUE(
+      espnowDecodeReadings(buf, n, seq, clock, name, out, ESPNOW_FRAME_READINGS, got));
+  TEST_ASSERT_EQUAL_HEX32(0x01020304, clock);
+  TEST_ASSERT_EQUAL_HEX16(0xBEEF, seq);
+  TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+}
+
+void test_readings_fill_one_frame() {
+  PackedReading in[ESPNOW_FRAME_READINGS + 5];
+  for (uint16_t i = 0; i < ESPNOW_FRAME_READINGS + 5; i++) {
+    in[i] = sample(i);
+  }
+  uint8_t buf[ESPNOW_FRAME_MAX];
+  uint16_t count;
+  size_t n = espnowEncodeReadings(buf, sizeof(buf), 1, 0, "a", in, ESPNOW_FRAME_READINGS + 5, count);
+  TEST_ASSERT_EQUAL_UINT16(ESPNOW_FRAME_READINGS, count);
+  TEST_ASSERT_TRUE(n <= ESPNOW_FRAME_MAX);
+  // Nom plus long : moins de releves, jamais plus de 250 octets
+  n = espnowEncodeReadings(buf, sizeof(buf), 1, 0, "station-du-fond-du-jardin-nord", in,
+                           ESPNOW_FRAME_READINGS + 5, count);
+  TEST_ASSERT_TRUE(count > 0 && count <= ESPNOW_FRAME_READINGS);
+  TEST_ASSERT_TRUE(n <= ESPNOW_FRAME_MAX);
+}
+
+void test_readings_rejects_bad_frames() {
+  PackedReading in[2] = {sample(1), sample(2)};
+  PackedReading out[ESPNOW_FRAME_READINGS];
+  char name[ESPNOW_DEVICE_MAX + 1];
+  uint8_t buf[ESPNOW_FRAME_MAX];
+  uint16_t seq, count;
+  uint32_t clock;
+  const uint16_t max = ESPNOW_FRAME_READINGS;
+  size_t n = espnowEncodeReadings(buf, sizeof(buf), 7, 0, "x", in, 2, count);
+
+  TEST_ASSERT_FALSE(espnowDecodeReadings(buf, n - 1, seq, clock, name, out, max, count));
+  TEST_ASSERT_FALSE(espnowDecodeReadings(buf, n, seq, clock, name, out, 1, count));
+  buf[9]++;  // Taille de releve differente (AGGREGATE_WINDOW)
+  TEST_ASSERT_FALSE(espnowDecodeReadings(buf, n, seq, clock, name, out, max, count));
+  buf[9]--;
+  buf[1] = ESPNOW_VERSION + 1;
+  TEST_ASSERT_EQUAL_UINT8(0, espnowFrameType(buf, n));
+  TEST_ASSERT_FALSE(espnowDecodeReadings(buf, n, seq, clock, name, out, max, count));
+}
+
+void test_readings_rejects_bad_names() {
+  PackedReading in[1] = {sample(1)};
+  uint8_t buf[ESPNOW_FRAME_MAX];
+  uint16_t count;
+  TEST_ASSERT_EQUAL_UINT32(0, espnowEncodeReadings(buf, sizeof(buf), 1, 0, "", in, 1, count));
+  TEST_ASSERT_EQUAL_UINT32(
+      0, espnowEncodeReadings(buf, sizeof(buf), 1, 0, "un-nom-de-station-bien-trop-long-x", in, 1,
+                              count));
+  TEST_ASSERT_EQUAL_UINT16(0, count);
+}
+
+void test_ack_round_trip() {
+  uint8_t buf[ESPNOW_ACK_SIZE];
+  TEST_ASSERT_EQUAL_UINT32(ESPNOW_ACK_SIZE, espnowEncodeAck(buf, sizeof(buf), 0x1234,
+                                                           1700000123u, true));
+  uint16_t seq;
+  uint32_t epoch;
+  bool accepted;
+  TEST_ASSERT_TRUE(espnowDecodeAck(buf, sizeof(buf), seq, epoch, accepted));
+  TEST_ASSERT_EQUAL_HEX16(0x1234, seq);
+  TEST_ASSERT_EQUAL_UINT32(1700000123u, epoch);
+  TEST_ASSERT_TRUE(accepted);
+
+  espnowEncodeAck(buf, sizeof(buf), 9, 0, false);
+  TEST_ASSERT_TRUE(espnowDecodeAck(buf, sizeof(buf), seq, epoch, accepted));
+  TEST_ASSERT_FALSE(accepted);
+  TEST_ASSERT_FALSE(espnowDecodeAck(buf, sizeof(buf) - 1, seq, epoch, accepted));
+  TEST_ASSERT_EQUAL_UINT32(0, espnowEncodeAck(buf, sizeof(buf) - 1, 9, 0, true));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_readings_round_trip);
+  RUN_TEST(test_readings_fill_one_frame);
+  RUN_TEST(test_readings_rejects_bad_frames);
+  RUN_TEST(test_readings_rejects_bad_names);
+  RUN_TEST(test_ack_round_trip);
+  return UNITY_END();
+}
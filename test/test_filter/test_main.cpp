@@ -0,0 +1,254 @@
+#include <unity.h>
+#include "adaptive_rate.h"
+#include "adc_filter.h"
+#include "deadband.h"
+#include "welford.h"
+
+/**
+ * Filtres des salves ADC, statistiques de fenetre, bandes mortes et
+ * cadence adaptative.
+ */
+
+// Salve avec deux pics (saturation et zero)
+static const uint16_t SPIKY_BURST[] = {2000, 2001, 1999, 4095, 2002, 2000, 1998, 0, 2001, 2003,
+                                       2000, 1999, 2002, 2001, 2000, 2000, 1999, 2001, 2002, 2000};
+static const int SPIKY_N = sizeof(SPIKY_BURST) / sizeof(SPIKY_BURST[0]);
+
+static const int16_t BAND[CH_COUNT] = {50, 200, 20, 300};
+static const int16_t STEP[CH_COUNT] = {20, 100, 10, 200};
+
+template<uint8_t W>
+static float filterBurst(SampleFilter<W>& f, const uint16_t* samples, int n) {
+  f.begin();
+  for (int i = 0; i < n; i++) {
+    f.add(samples[i]);
+  }
+  return f.result();
+}
+
+static Reading makeReading(float t, float h, float ntc, float lum, uint8_t valid = 0x0F) {
+  Reading r = {};
+  r.value[CH_DHT_TEMP] = t;
+  r.value[CH_DHT_HUM] = h;
+  r.value[CH_NTC_TEMP] = ntc;
+  r.value[CH_LUMINOSITY] = lum;
+  r.valid = valid;
+  return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_mean_shifted_by_spike() {
+  SampleFilter<8> f(ADC_FILTER_MEAN, 0, 0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 2005.15, filterBurst(f, SPIKY_BURST, SPIKY_N));
+}
+
+void test_mean_exact_on_long_burst() {
+  // Somme au-dela de 2^24 : un accumulateur float perdrait les bits de poids faible
+  SampleFilter<8> f(ADC_FILTER_MEAN, 0, 0.0f);
+  f.begin();
+  for (uint32_t i = 0; i < 40000; i++) {
+    f.add(i & 1 ? 65519 : 65520);
+  }
+  TEST_ASSERT_EQUAL_UINT32(40000, f.count());
+  TEST_ASSERT_EQUAL_FLOAT(65519.5f, f.result());
+}
+
+void test_median_rejects_spikes() {
+  SampleFilter<8> f(ADC_FILTER_MEDIAN, 0, 0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 2000.3, filterBurst(f, SPIKY_BURST, SPIKY_N));
+}
+
+void test_trimmed_rejects_spikes() {
+  SampleFilter<8> f(ADC_FILTER_TRIMMED, 20, 0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 2000.366577, filterBurst(f, SPIKY_BURST, SPIKY_N));
+}
+
+void test_single_block_is_plain_median() {
+  const uint16_t burst[] = {5, 1, 4000, 3, 2};
+  SampleFilter<32> f(ADC_FILTER_MEDIAN, 0, 0.0f);
+  TEST_ASSERT_EQUAL_FLOAT(3.0f, filterBurst(f, burst, 5));
+  TEST_ASSERT_EQUAL_UINT32(5, f.count());
+}
+
+void test_iir_state_kept_across_bursts() {
+  SampleFilter<8> f(ADC_FILTER_IIR, 0, 0.25f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 1989.95459, filterBurst(f, SPIKY_BURST, SPIKY_N));
+  const uint16_t next[] = {2100};
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, 1989.95459 + 0.25 * (2100 - 1989.95459), filterBurst(f, next, 1));
+}
+
+void test_empty_burst() {
+  SampleFilter<8> f(ADC_FILTER_TRIMMED, 20, 0.0f);
+  f.begin();
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, f.result());
+}
+
+void test_welford_matches_two_pass() {
+  Welford w;
+  w.reset();
+  double sum = 0.0;
+  for (int i = 0; i < SPIKY_N; i++) {
+    w.add(SPIKY_BURST[i]);
+    sum += SPIKY_BURST[i];
+  }
+  double mean = sum / SPIKY_N;
+  double m2 = 0.0;
+  for (int i = 0; i < SPIKY_N; i++) {
+    m2 += (SPIKY_BURST[i] - mean) * (SPIKY_BURST[i] - mean);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-3, mean, w.mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-2, sqrt(m2 / (SPIKY_N - 1)), w.stddev());
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, w.min);
+  TEST_ASSERT_EQUAL_FLOAT(4095.0f, w.max);
+}
+
+void test_welford_stable_with_large_offset() {
+  Welford w;
+  w.reset();
+  for (int i = 0; i < 600; i++) {
+    w.add(1000.0f + (i % 2 ? 0.1f : -0.1f));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.005, 0.1, w.stddev());
+}
+
+void test_deadband_first_full_then_dropped() {
+  DeadbandState st = {};
+  Reading r = makeReading(20.7f, 52.0f, 21.1f, 77.0f);
+  TEST_ASSERT_TRUE(deadbandApply(st, r, BAND, 300));
+  TEST_ASSERT_EQUAL_HEX8(0x0, r.omitted);
+  Reading same = makeReading(20.71f, 52.1f, 21.15f, 77.5f);
+  TEST_ASSERT_FALSE(deadbandApply(st, same, BAND, 300));
+  TEST_ASSERT_EQUAL_HEX8(0xF, same.omitted);
+}
+
+void test_deadband_slow_drift_and_validity() {
+  DeadbandState st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+  deadbandApply(st, r, BAND, 300);
+  // +0,2 C par releve : reference = derniere valeur publiee, pas le releve precedent
+  bool published = false;
+  for (int i = 1; i <= 3 && !published; i++) {
+    Reading d = makeReading(20.0f, 50.0f, 21.0f + 0.1f * i, 70.0f);
+    published = deadbandApply(st, d, BAND, 300);
+    if (published) {
+      TEST_ASSERT_EQUAL_HEX8(0xB, d.omitted);
+    }
+  }
+  TEST_ASSERT_TRUE(published);
+  Reading ko = makeReading(0.0f, 0.0f, 21.2f, 70.0f, 0x0C);
+  TEST_ASSERT_TRUE(deadbandApply(st, ko, BAND, 300));
+  TEST_ASSERT_EQUAL_HEX8(0xC, ko.omitted);
+}
+
+void test_deadband_heartbeat() {
+  DeadbandState st = {};
+  for (int i = 0; i < 5; i++) {
+    Reading r = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+    bool sent = deadbandApply(st, r, BAND, 4);
+    TEST_ASSERT_EQUAL(i % 4 == 0, sent);
+  }
+}
+
+void test_deadband_heartbeat_on_elapsed_time() {
+  // Cadence adaptative : 2 s puis 60 s entre releves, heartbeat a 300 s
+  DeadbandState st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+  TEST_ASSERT_TRUE(deadbandApply(st, r, BAND, 300000, 0));
+  for (int i = 0; i < 149; i++) {
+    Reading same = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+    TEST_ASSERT_FALSE(deadbandApply(st, same, BAND, 300000, 2000));
+  }
+  Reading due = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+  TEST_ASSERT_TRUE(deadbandApply(st, due, BAND, 300000, 2000));
+  for (int i = 0; i < 4; i++) {
+    Reading same = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+    TEST_ASSERT_FALSE(deadbandApply(st, same, BAND, 300000, 60000));
+  }
+  Reading slow = makeReading(20.0f, 50.0f, 21.0f, 70.0f);
+  TEST_ASSERT_TRUE(deadbandApply(st, slow, BAND, 300000, 60000));
+}
+
+void test_adaptive_starts_slow_and_stays_slow() {
+  AdaptiveRate st = {};
+  for (int i = 0; i < 10; i++) {
+    Reading r = makeReading(20.0f, 50.0f, 21.0f + 0.01f * (i & 1), 70.0f);
+    TEST_ASSERT_EQUAL_UINT32(60000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+  }
+}
+
+void test_adaptive_fast_attack() {
+  AdaptiveRate st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 10.0f);
+  adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  // Lever du soleil : +8 % de luminosite, 4 pas -> intervalle divise par 4
+  r = makeReading(20.0f, 50.0f, 21.0f, 18.0f);
+  TEST_ASSERT_EQUAL_UINT32(15000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+  // Variation 100 fois le pas : borne basse
+  r = makeReading(20.0f, 50.0f, 31.0f, 18.0f);
+  TEST_ASSERT_EQUAL_UINT32(2000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+}
+
+void test_adaptive_slow_release() {
+  AdaptiveRate st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 10.0f);
+  adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  r.value[CH_NTC_TEMP] = 31.0f;
+  adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  // Signal stable : +50 % tous les 3 releves, arrondi a la seconde
+  const uint32_t expected[] = {2000, 2000, 3000, 3000, 3000, 4000, 4000, 4000, 6000};
+  for (uint32_t e : expected) {
+    TEST_ASSERT_EQUAL_UINT32(e, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+  }
+  for (int i = 0; i < 40; i++) {
+    adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  }
+  TEST_ASSERT_EQUAL_UINT32(60000, st.intervalMs);
+}
+
+void test_adaptive_moderate_change_holds() {
+  AdaptiveRate st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 10.0f);
+  adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  r.value[CH_NTC_TEMP] = 21.2f;  // 2 pas -> 30 s
+  TEST_ASSERT_EQUAL_UINT32(30000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+  // Entre la moitie du pas et le pas : ni acceleration ni ralentissement
+  for (int i = 1; i <= 5; i++) {
+    r.value[CH_NTC_TEMP] = 21.2f + 0.07f * i;
+    TEST_ASSERT_EQUAL_UINT32(30000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+  }
+}
+
+void test_adaptive_ignores_validity_change() {
+  AdaptiveRate st = {};
+  Reading r = makeReading(20.0f, 50.0f, 21.0f, 10.0f);
+  adaptiveUpdate(st, r, STEP, 2000, 60000, 3);
+  // Echec DHT puis retour : pas d'acceleration sur un canal invalide
+  Reading ko = makeReading(0.0f, 0.0f, 21.0f, 10.0f, 0x0C);
+  TEST_ASSERT_EQUAL_UINT32(60000, adaptiveUpdate(st, ko, STEP, 2000, 60000, 3));
+  TEST_ASSERT_EQUAL_UINT32(60000, adaptiveUpdate(st, r, STEP, 2000, 60000, 3));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_mean_shifted_by_spike);
+  RUN_TEST(test_mean_exact_on_long_burst);
+  RUN_TEST(test_median_rejects_spikes);
+  RUN_TEST(test_trimmed_rejects_spikes);
+  RUN_TEST(test_single_block_is_plain_median);
+  RUN_TEST(test_iir_state_kept_across_bursts);
+  RUN_TEST(test_empty_burst);
+  RUN_TEST(test_welford_matches_two_pass);
+  RUN_TEST(test_welford_stable_with_large_offset);
+  RUN_TEST(test_deadband_first_full_then_dropped);
+  RUN_TEST(test_deadband_slow_drift_and_validity);
+  RUN_TEST(test_deadband_heartbeat);
+  RUN_TEST(test_deadband_heartbeat_on_elapsed_time);
+  RUN_TEST(test_adaptive_starts_slow_and_stays_slow);
+  RUN_TEST(test_adaptive_fast_attack);
+  RUN_TEST(test_adaptive_slow_release);
+  RUN_TEST(test_adaptive_moderate_change_holds);
+  RUN_TEST(test_adaptive_ignores_validity_change);
+  return UNITY_END();
+}
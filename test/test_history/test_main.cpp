@@ -0,0 +1,230 @@
+#include <string.h>
+#include <unity.h>
+#include "command.h"
+#include "history_log.h"
+
+/**
+ * Historique sur flash : journal circulaire, reprise apres redemarrage,
+ * requetes par plage de temps, commandes MQTT.
+ *
+ * La flash est simulee en RAM avec la semantique NOR : l'effacement remet
+ * un secteur a 0xFF, l'ecriture ne fait que passer des bits a 0.
+ */
+
+#define TEST_SECTORS 4
+
+class RamFlash : public HistoryFlash {
+ public:
+  uint8_t mem[TEST_SECTORS * HISTORY_SECTOR_SIZE];
+  uint32_t eraseCount = 0;
+  bool eraseFails = false;  // Effacement refuse, secteur laisse intact
+
+  RamFlash() { memset(mem, 0xFF, sizeof(mem)); }
+  const uint8_t* data() const override { return mem; }
+  uint32_t size() const override { return sizeof(mem); }
+  bool erase(uint32_t offset) override {
+    if (eraseFails) {
+      return false;
+    }
+    memset(mem + offset, 0xFF, HISTORY_SECTOR_SIZE);
+    eraseCount++;
+    return true;
+  }
+  bool write(uint32_t offset, const void* src, uint32_t len) override {
+    const uint8_t* p = (const uint8_t*)src;
+    for (uint32_t i = 0; i < len; i++) {
+      mem[offset + i] &= p[i];
+    }
+    return true;
+  }
+};
+
+static RamFlash flash;
+
+static PackedReading sample(uint32_t i) {
+  PackedReading p = {};
+  p.seq = i;
+  p.epoch = 1770561000 + i * 10;
+  p.centi[CH_NTC_TEMP] = (int16_t)(-500 + i);
+  p.valid = 0x0F;
+  return p;
+}
+
+static void fill(HistoryLog& log, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(log.append(sample(i)));
+  }
+}
+
+void setUp() {
+  flash = RamFlash();
+}
+
+void tearDown() {}
+
+void test_append_and_query_range() {
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  fill(log, 200);  // Plusieurs secteurs
+  TEST_ASSERT_EQUAL_UINT32(200, log.records());
+  TEST_ASSERT_EQUAL_UINT32(1770561000, log.oldestEpoch());
+  TEST_ASSERT_EQUAL_UINT32(1770561000 + 199 * 10, log.newestEpoch());
+
+  // Releves 100 a 179, lus par lots de 64
+  uint32_t from = 1770561000 + 100 * 10, to = 1770561000 + 179 * 10;
+  HistoryCursor c = log.seek(from);
+  PackedReading out[64];
+  uint32_t total = 0, expect = 100;
+  while (!c.done) {
+    uint16_t n = log.read(c, from, to, out, 64);
+    for (uint16_t i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_UINT32(expect++, out[i].seq);
+    }
+    total += n;
+  }
+  TEST_ASSERT_EQUAL_UINT32(80, total);
+  TEST_ASSERT_EQUAL_INT16(-500 + 179, out[(total - 1) % 64].centi[CH_NTC_TEMP]);
+}
+
+void test_wraps_over_oldest_sector() {
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  uint32_t n = (TEST_SECTORS + 1) * HISTORY_SLOTS + 7;
+  fill(log, n);
+  // Le premier secteur recycle deux fois : il reste trois secteurs pleins et le courant
+  TEST_ASSERT_EQUAL_UINT32((TEST_SECTORS - 1) * HISTORY_SLOTS + 7, log.records());
+  TEST_ASSERT_EQUAL_UINT32(sample(2 * HISTORY_SLOTS).epoch, log.oldestEpoch());
+  TEST_ASSERT_EQUAL_UINT32(TEST_SECTORS + 2, flash.eraseCount);
+
+  HistoryCursor c = log.seek(0);
+  PackedReading out[1];
+  TEST_ASSERT_EQUAL_UINT16(1, log.read(c, 0, UINT32_MAX, out, 1));
+  TEST_ASSERT_EQUAL_UINT32(2 * HISTORY_SLOTS, out[0].seq);
+}
+
+void test_failed_erase_keeps_oldest_sector() {
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  fill(log, TEST_SECTORS * HISTORY_SLOTS);  // Le releve suivant recycle le plus ancien
+  flash.eraseFails = true;
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_FALSE(log.append(sample(1000)));
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, log.flashErrors());
+  TEST_ASSERT_EQUAL_UINT32(TEST_SECTORS * HISTORY_SLOTS, log.records());
+  TEST_ASSERT_EQUAL_UINT32(sample(0).epoch, log.oldestEpoch());
+
+  flash.eraseFails = false;
+  TEST_ASSERT_TRUE(log.append(sample(TEST_SECTORS * HISTORY_SLOTS)));
+  TEST_ASSERT_EQUAL_UINT32((TEST_SECTORS - 1) * HISTORY_SLOTS + 1, log.records());
+  TEST_ASSERT_EQUAL_UINT32(sample(HISTORY_SLOTS).epoch, log.oldestEpoch());
+}
+
+void test_recovers_after_reboot() {
+  {
+    HistoryLog log(flash);
+    TEST_ASSERT_TRUE(log.begin());
+    fill(log, HISTORY_SLOTS + 20);
+  }
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_EQUAL_UINT32(HISTORY_SLOTS + 20, log.records());
+  TEST_ASSERT_EQUAL_UINT32(sample(HISTORY_SLOTS + 19).epoch, log.newestEpoch());
+  // La suite est ecrite a la position d'ajout, sans effacement
+  uint32_t erases = flash.eraseCount;
+  TEST_ASSERT_TRUE(log.append(sample(HISTORY_SLOTS + 20)));
+  TEST_ASSERT_EQUAL_UINT32(erases, flash.eraseCount);
+  HistoryCursor c = log.seek(sample(HISTORY_SLOTS + 20).epoch);
+  PackedReading out[4];
+  TEST_ASSERT_EQUAL_UINT16(1, log.read(c, sample(HISTORY_SLOTS + 20).epoch, UINT32_MAX, out, 4));
+  TEST_ASSERT_EQUAL_UINT32(HISTORY_SLOTS + 20, out[0].seq);
+  TEST_ASSERT_TRUE(c.done);
+}
+
+void test_torn_record_is_skipped() {
+  {
+    HistoryLog log(flash);
+    TEST_ASSERT_TRUE(log.begin());
+    fill(log, 10);
+  }
+  // Coupure pendant l'ecriture du 6e releve : quelques octets seulement
+  flash.mem[HISTORY_HEADER_SIZE + 5 * HISTORY_RECORD_SIZE + 3] = 0x12;
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_EQUAL_UINT32(1, log.corrupt());
+  HistoryCursor c = log.seek(0);
+  PackedReading out[16];
+  uint16_t n = log.read(c, 0, UINT32_MAX, out, 16);
+  TEST_ASSERT_EQUAL_UINT16(9, n);
+  TEST_ASSERT_EQUAL_UINT32(4, out[4].seq);
+  TEST_ASSERT_EQUAL_UINT32(6, out[5].seq);
+}
+
+void test_cursor_follows_recycled_sector() {
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  fill(log, TEST_SECTORS * HISTORY_SLOTS);
+  HistoryCursor c = log.seek(0);
+  PackedReading out[8];
+  TEST_ASSERT_EQUAL_UINT16(8, log.read(c, 0, UINT32_MAX, out, 8));
+  TEST_ASSERT_EQUAL_UINT32(0, out[0].seq);
+  // Le secteur lu est recycle pendant la requete : reprise au plus ancien restant
+  TEST_ASSERT_TRUE(log.append(sample(TEST_SECTORS * HISTORY_SLOTS)));
+  TEST_ASSERT_EQUAL_UINT16(1, log.read(c, 0, UINT32_MAX, out, 1));
+  TEST_ASSERT_EQUAL_UINT32(HISTORY_SLOTS, out[0].seq);
+}
+
+void test_seek_stops_after_range() {
+  HistoryLog log(flash);
+  TEST_ASSERT_TRUE(log.begin());
+  fill(log, 3 * HISTORY_SLOTS);
+  // Plage anterieure au journal : rien, sans parcourir les blocs suivants
+  HistoryCursor c = log.seek(1000);
+  PackedReading out[4];
+  TEST_ASSERT_EQUAL_UINT16(0, log.read(c, 1000, 2000, out, 4));
+  TEST_ASSERT_TRUE(c.done);
+  TEST_ASSERT_EQUAL_UINT16(0, c.slot);
+}
+
+void test_parse_history_command() {
+  Command cmd;
+  const char* json = "{\"id\": \"rattrapage-12\", \"cmd\":\"history\",\"from\":1770561000,\"to\":1770600000}";
+  TEST_ASSERT_TRUE(parseCommand(json, strlen(json), cmd));
+  TEST_ASSERT_EQUAL_UINT8(CMD_HISTORY, cmd.type);
+  TEST_ASSERT_EQUAL_UINT32(1770561000, cmd.from);
+  TEST_ASSERT_EQUAL_UINT32(1770600000, cmd.to);
+  TEST_ASSERT_EQUAL_STRING("rattrapage-12", cmd.id);
+
+  json = "{\"cmd\":\"history\",\"from\":1770561000}";
+  TEST_ASSERT_TRUE(parseCommand(json, strlen(json), cmd));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, cmd.to);
+  TEST_ASSERT_EQUAL_STRING("", cmd.id);
+}
+
+void test_reject_invalid_command() {
+  Command cmd;
+  const char* bad[] = {
+    "{\"cmd\":\"reboot\"}",
+    "{\"cmd\":\"history\"}",
+    "{\"cmd\":\"history\",\"from\":20,\"to\":10}",
+    "{\"cmd\":\"history\",\"from\":99999999999}",
+    "{\"cmd\":\"history\",\"from\":-5}",
+  };
+  for (const char* json : bad) {
+    TEST_ASSERT_FALSE_MESSAGE(parseCommand(json, strlen(json), cmd), json);
+  }
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_append_and_query_range);
+  RUN_TEST(test_wraps_over_oldest_sector);
+  RUN_TEST(test_failed_erase_keeps_oldest_sector);
+  RUN_TEST(test_recovers_after_reboot);
+  RUN_TEST(test_torn_record_is_skipped);
+  RUN_TEST(test_cursor_follows_recycled_sector);
+  RUN_TEST(test_seek_stops_after_range);
+  RUN_TEST(test_parse_history_command);
+  RUN_TEST(test_reject_invalid_command);
+  return UNITY_END();
+}
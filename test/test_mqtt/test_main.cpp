@@ -0,0 +1,148 @@
+#include <string.h>
+#include <unity.h>
+#include "inflight_window.h"
+#include "mqtt_packet.h"
+
+/**
+ * PUBLISH QoS 1 : en-tete, reperage des PUBACK dans le flux entrant et
+ * fenetre des messages en vol.
+ */
+
+static int feedAll(MqttAckParser& p, const uint8_t* bytes, size_t n, uint16_t* ids) {
+  int found = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint16_t id;
+    if (p.feed(bytes[i], id)) {
+      ids[found++] = id;
+    }
+  }
+  return found;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_publish_header_bytes() {
+  uint8_t buf[32];
+  size_t n = mqttPublishHeader(buf, sizeof(buf), "a/b", 5, 0x1234, false);
+  const uint8_t expected[] = {0x32, 12, 0x00, 0x03, 'a', '/', 'b', 0x12, 0x34};
+  TEST_ASSERT_EQUAL_UINT32(sizeof(expected), n);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, sizeof(expected));
+  mqttPublishHeader(buf, sizeof(buf), "a/b", 5, 0x1234, true);
+  TEST_ASSERT_EQUAL_HEX8(0x3A, buf[0]);
+}
+
+void test_publish_header_long_payload() {
+  uint8_t buf[32];
+  // 2 + 3 + 2 + 200 = 207 : longueur restante sur deux octets
+  size_t n = mqttPublishHeader(buf, sizeof(buf), "a/b", 200, 1, false);
+  TEST_ASSERT_EQUAL_UINT32(10, n);
+  TEST_ASSERT_EQUAL_HEX8(0xCF, buf[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, buf[2]);
+}
+
+void test_publish_header_rejects() {
+  uint8_t buf[16];
+  TEST_ASSERT_EQUAL_UINT32(0, mqttPublishHeader(buf, sizeof(buf), "a/b", 5, 0, false));
+  TEST_ASSERT_EQUAL_UINT32(0, mqttPublishHeader(buf, sizeof(buf), "sensors/x/y", 5, 1, false));
+}
+
+void test_parser_finds_pubacks_among_packets() {
+  const uint8_t stream[] = {
+    0x20, 0x02, 0x00, 0x00,                     // CONNACK
+    0x40, 0x02, 0x00, 0x07,                     // PUBACK 7
+    0x30, 0x05, 0x00, 0x01, 't', 0x40, 0x02,    // PUBLISH entrant contenant 40 02
+    0xD0, 0x00,                                 // PINGRESP
+    0x40, 0x02, 0x01, 0x00,                     // PUBACK 256
+  };
+  MqttAckParser p;
+  uint16_t ids[4];
+  TEST_ASSERT_EQUAL(2, feedAll(p, stream, sizeof(stream), ids));
+  TEST_ASSERT_EQUAL_UINT16(7, ids[0]);
+  TEST_ASSERT_EQUAL_UINT16(256, ids[1]);
+}
+
+void test_parser_multibyte_length_and_reset() {
+  MqttAckParser p;
+  uint16_t ids[2];
+  // PUBLISH entrant de 130 octets (longueur 0x82 0x01), puis PUBACK 9
+  uint8_t stream[3 + 130 + 4];
+  memset(stream, 0x40, sizeof(stream));
+  stream[0] = 0x30;
+  stream[1] = 0x82;
+  stream[2] = 0x01;
+  const uint8_t ack[] = {0x40, 0x02, 0x00, 0x09};
+  memcpy(stream + 133, ack, sizeof(ack));
+  TEST_ASSERT_EQUAL(1, feedAll(p, stream, sizeof(stream), ids));
+  TEST_ASSERT_EQUAL_UINT16(9, ids[0]);
+  // Connexion coupee au milieu d'un paquet : reset() resynchronise
+  feedAll(p, stream, 10, ids);
+  p.reset();
+  TEST_ASSERT_EQUAL(1, feedAll(p, ack, sizeof(ack), ids));
+}
+
+void test_window_out_of_order_acks() {
+  InflightWindow<4> w;
+  TEST_ASSERT_EQUAL_UINT16(1, w.add(1, 0));
+  TEST_ASSERT_EQUAL_UINT16(2, w.add(3, 0));
+  TEST_ASSERT_EQUAL_UINT16(3, w.add(2, 0));
+  TEST_ASSERT_EQUAL_UINT32(6, w.readings());
+  TEST_ASSERT_EQUAL_UINT32(4, w.offset(2));
+  // Acquittement du deuxieme : rien a liberer tant que le premier manque
+  TEST_ASSERT_TRUE(w.ack(2));
+  TEST_ASSERT_FALSE(w.ack(2));
+  TEST_ASSERT_FALSE(w.ack(42));
+  TEST_ASSERT_EQUAL_UINT32(0, w.popAcked());
+  TEST_ASSERT_TRUE(w.ack(1));
+  TEST_ASSERT_EQUAL_UINT32(4, w.popAcked());
+  TEST_ASSERT_EQUAL(1, w.size());
+  TEST_ASSERT_EQUAL_UINT16(3, w.slot(0).id);
+  TEST_ASSERT_EQUAL_UINT32(0, w.offset(0));
+}
+
+void test_window_full_and_expiry() {
+  InflightWindow<2> w;
+  w.add(1, 1000);
+  w.add(1, 3000);
+  TEST_ASSERT_TRUE(w.full());
+  TEST_ASSERT_EQUAL_UINT16(0, w.add(1, 3000));
+  TEST_ASSERT_EQUAL(-1, w.expired(5999, 5000));
+  TEST_ASSERT_EQUAL(0, w.expired(6000, 5000));
+  w.resent(0, 6000);
+  TEST_ASSERT_EQUAL(1, w.expired(8000, 5000));
+  w.ack(w.slot(1).id);
+  TEST_ASSERT_EQUAL(-1, w.expired(8000, 5000));
+}
+
+void test_window_ids_skip_zero() {
+  InflightWindow<1> w;
+  for (uint32_t i = 1; i < UINT16_MAX; i++) {
+    w.add(1, 0);
+    w.clear();
+  }
+  TEST_ASSERT_EQUAL_UINT16(UINT16_MAX, w.add(1, 0));
+  w.clear();
+  TEST_ASSERT_EQUAL_UINT16(1, w.add(1, 0));
+}
+
+void test_window_id_range() {
+  InflightWindow<4> w(32768, 32769);
+  TEST_ASSERT_EQUAL_UINT16(32768, w.add(1, 0));
+  TEST_ASSERT_EQUAL_UINT16(32769, w.add(1, 0));
+  TEST_ASSERT_EQUAL_UINT16(32768, w.add(1, 0));
+  TEST_ASSERT_FALSE(w.ack(1));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_publish_header_bytes);
+  RUN_TEST(test_publish_header_long_payload);
+  RUN_TEST(test_publish_header_rejects);
+  RUN_TEST(test_parser_finds_pubacks_among_packets);
+  RUN_TEST(test_parser_multibyte_length_and_reset);
+  RUN_TEST(test_window_out_of_order_acks);
+  RUN_TEST(test_window_full_and_expiry);
+  RUN_TEST(test_window_ids_skip_zero);
+  RUN_TEST(test_window_id_range);
+  return UNITY_END();
+}
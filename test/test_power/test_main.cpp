@@ -0,0 +1,97 @@
+#include <unity.h>
+#include "power_meter.h"
+
+/**
+ * Bilan d'energie : temps par etat, rapport cyclique et courant moyen estime.
+ */
+
+static const uint32_t UA[PSTATE_COUNT] = {120000, 22000, 10};
+
+void setUp() {}
+void tearDown() {}
+
+void test_enter_accumulates_current_state() {
+  PowerMeter m = {};
+  m.state = PSTATE_IDLE;
+  powerMeterEnter(m, PSTATE_BOOST, 800000);   // 800 ms au repos
+  powerMeterEnter(m, PSTATE_IDLE, 1000000);   // 200 ms au maximum
+  powerMeterEnter(m, PSTATE_IDLE, 1500000);   // Meme etat : cloture seule
+  TEST_ASSERT_EQUAL_UINT64(1300000, m.us[PSTATE_IDLE]);
+  TEST_ASSERT_EQUAL_UINT64(200000, m.us[PSTATE_BOOST]);
+  TEST_ASSERT_EQUAL_UINT8(PSTATE_IDLE, m.state);
+  TEST_ASSERT_EQUAL_UINT8(13, powerMeterDutyPct(m));
+}
+
+void test_clock_going_back_is_ignored() {
+  // Reveil de deep sleep : esp_timer repart de 0, l'ancienne marque est ignoree
+  PowerMeter m = {};
+  m.state = PSTATE_IDLE;
+  m.sinceUs = 5000000;
+  powerMeterEnter(m, PSTATE_BOOST, 1000);
+  TEST_ASSERT_EQUAL_UINT64(0, powerMeterTotal(m));
+  TEST_ASSERT_EQUAL_UINT64(1000, m.sinceUs);
+}
+
+void test_mean_current_always_on() {
+  PowerMeter m = {};
+  m.us[PSTATE_BOOST] = 6000000;   // 6 s sur 60 s
+  m.us[PSTATE_IDLE] = 54000000;
+  // (6 * 120 + 54 * 22) / 60 = 31,8 mA
+  TEST_ASSERT_EQUAL_UINT32(31800, powerMeterMeanUa(m, UA));
+  TEST_ASSERT_EQUAL_UINT8(10, powerMeterDutyPct(m));
+}
+
+void test_mean_current_deep_sleep() {
+  PowerMeter m = {};
+  powerMeterAdd(m, PSTATE_BOOST, 3000000);      // 3 s de radio
+  powerMeterAdd(m, PSTATE_IDLE, 1000000);       // 10 reveils de 100 ms
+  powerMeterAdd(m, PSTATE_SLEEP, 596000000);    // 10 minutes au total
+  // (3 * 120000 + 1 * 22000 + 596 * 10) / 600 = 646 uA
+  TEST_ASSERT_EQUAL_UINT32(646, powerMeterMeanUa(m, UA));
+  TEST_ASSERT_EQUAL_UINT8(1, powerMeterDutyPct(m));
+}
+
+void test_long_window_does_not_overflow() {
+  PowerMeter m = {};
+  m.us[PSTATE_BOOST] = 30ULL * 24 * 3600 * 1000000;  // 30 jours au maximum
+  TEST_ASSERT_EQUAL_UINT32(120000, powerMeterMeanUa(m, UA));
+}
+
+void test_reset_keeps_state() {
+  PowerMeter m = {};
+  m.state = PSTATE_BOOST;
+  powerMeterEnter(m, PSTATE_BOOST, 2000);
+  powerMeterReset(m, 2000);
+  TEST_ASSERT_EQUAL_UINT64(0, powerMeterTotal(m));
+  TEST_ASSERT_EQUAL_UINT8(0, powerMeterDutyPct(m));
+  TEST_ASSERT_EQUAL_UINT32(0, powerMeterMeanUa(m, UA));
+  powerMeterEnter(m, PSTATE_IDLE, 3000);
+  TEST_ASSERT_EQUAL_UINT64(1000, m.us[PSTATE_BOOST]);
+}
+
+void test_consume_keeps_time_after_report() {
+  PowerMeter m = {};
+  m.state = PSTATE_IDLE;
+  powerMeterEnter(m, PSTATE_BOOST, 5000);
+  powerMeterEnter(m, PSTATE_BOOST, 6000);  // Rendu du diagnostic
+  uint64_t reported[PSTATE_COUNT];
+  for (int s = 0; s < PSTATE_COUNT; s++) {
+    reported[s] = m.us[s];
+  }
+  powerMeterEnter(m, PSTATE_IDLE, 8000);  // Publication, puis fin de fenetre
+  powerMeterConsume(m, reported);
+  TEST_ASSERT_EQUAL_UINT64(2000, m.us[PSTATE_BOOST]);
+  TEST_ASSERT_EQUAL_UINT64(0, m.us[PSTATE_IDLE]);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_enter_accumulates_current_state);
+  RUN_TEST(test_clock_going_back_is_ignored);
+  RUN_TEST(test_mean_current_always_on);
+  RUN_TEST(test_mean_current_deep_sleep);
+  RUN_TEST(test_long_window_does_not_overflow);
+  RUN_TEST(test_reset_keeps_state);
+  RUN_TEST(test_consume_keeps_time_after_report);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+#include "config.h"
+#include "timebase.h"
+#include "timefmt.h"
+
+/**
+ * Horodatage ISO 8601 entier et cache du decalage horaire, compares a la libc.
+ * Horodatages relatifs d'avant NTP et leur conversion a posteriori.
+ */
+
+static const char* iso(uint32_t epoch, int32_t offset) {
+  static char buf[TIMESTAMP_LEN];
+  TEST_ASSERT_EQUAL(TIMESTAMP_LEN - 1, formatIso8601(buf, sizeof(buf), epoch, offset));
+  return buf;
+}
+
+void setUp() {
+  setenv("TZ", TZ_FRANCE, 1);
+  tzset();
+}
+
+void tearDown() {}
+
+void test_reference_timestamp() {
+  TEST_ASSERT_EQUAL_STRING("2026-02-08T15:30:00+01:00", iso(1770561000, 3600));
+  TEST_ASSERT_EQUAL_STRING("2027-01-01T00:00:00+01:00", iso(1798758000, 3600));
+  TEST_ASSERT_EQUAL_STRING("2020-01-01T00:00:00-05:00", iso(1577854800, -18000));
+}
+
+void test_matches_gmtime() {
+  char expected[TIMESTAMP_LEN];
+  for (uint32_t epoch = 1577836800; epoch < 1900000000; epoch += 987654) {
+    time_t t = epoch;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%S+00:00", &tm);
+    TEST_ASSERT_EQUAL_STRING(expected, iso(epoch, 0));
+  }
+}
+
+void test_civil_roundtrip() {
+  for (int32_t z = 0; z < 30000; z += 7) {
+    int32_t y;
+    uint32_t m, d;
+    civilFromDays(z, y, m, d);
+    TEST_ASSERT_EQUAL_INT32(z, daysFromCivil(y, m, d));
+  }
+  int32_t y;
+  uint32_t m, d;
+  civilFromDays(daysFromCivil(2028, 2, 29), y, m, d);
+  TEST_ASSERT_EQUAL_INT32(2028, y);
+  TEST_ASSERT_EQUAL_UINT32(2, m);
+  TEST_ASSERT_EQUAL_UINT32(29, d);
+}
+
+void test_tz_offset_matches_localtime() {
+  // Balayage sur trois ans, passages CET/CEST compris
+  for (uint32_t epoch = 1735689600; epoch < 1830000000; epoch += 3607) {
+    time_t t = epoch;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    TEST_ASSERT_EQUAL_INT32(tm.tm_isdst > 0 ? 7200 : 3600, tzOffsetAt(epoch));
+  }
+}
+
+void test_timestamp_dst_and_unknown() {
+  char buf[TIMESTAMP_LEN];
+  formatTimestamp(buf, sizeof(buf), 1783000000);
+  TEST_ASSERT_EQUAL_STRING("2026-07-02T15:46:40+02:00", buf);
+  TEST_ASSERT_EQUAL(4, formatTimestamp(buf, sizeof(buf), 0));
+  TEST_ASSERT_EQUAL_STRING("null", buf);
+  TEST_ASSERT_EQUAL(0, formatIso8601(buf, TIMESTAMP_LEN - 1, 1770561000, 3600));
+}
+
+void test_relative_stamps_backfilled() {
+  // Releves a 0,4 s et 70 s du demarrage, heure connue a 95,5 s
+  TEST_ASSERT_EQUAL_UINT32(1, epochStamp(0, 400000));
+  TEST_ASSERT_EQUAL_UINT32(71, epochStamp(12, 70000000));
+  TEST_ASSERT_EQUAL_UINT32(1770561000, epochStamp(1770561000, 70000000));
+  TEST_ASSERT_TRUE(epochIsRelative(71));
+  TEST_ASSERT_FALSE(epochIsRelative(0));
+  TEST_ASSERT_FALSE(epochIsRelative(1770561000));
+
+  PackedReading batch[3] = {};
+  batch[0].epoch = 1;
+  batch[1].epoch = 71;
+  batch[2].epoch = 1770561000;
+  BootClock clock;
+  TEST_ASSERT_FALSE(clock.observe(95, 95000000));
+  TEST_ASSERT_FALSE(clock.resolve(batch, 3));
+  TEST_ASSERT_EQUAL_UINT32(71, batch[1].epoch);
+
+  TEST_ASSERT_TRUE(clock.observe(1770561095, 95500000));
+  TEST_ASSERT_EQUAL_UINT32(1770561000, clock.bootEpoch());
+  TEST_ASSERT_TRUE(clock.resolve(batch, 3));
+  TEST_ASSERT_EQUAL_UINT32(1770561000, batch[0].epoch);
+  TEST_ASSERT_EQUAL_UINT32(1770561070, batch[1].epoch);
+  TEST_ASSERT_EQUAL_UINT32(1770561000, batch[2].epoch);
+
+  // Origine figee : une resynchronisation NTP ne deplace pas les releves rejoues
+  clock.observe(1770561300, 100000000);
+  TEST_ASSERT_EQUAL_UINT32(1770561000, clock.bootEpoch());
+}
+
+void test_relative_stamps_from_peer_and_cleared() {
+  // Releve pris a 10 s d'une feuille dont l'horloge est a 25 s a la reception
+  TEST_ASSERT_EQUAL_UINT32(1770561085, epochFromPeer(11, 26, 1770561100));
+  TEST_ASSERT_EQUAL_UINT32(1770561000, epochFromPeer(1770561000, 26, 1770561100));
+  TEST_ASSERT_EQUAL_UINT32(0, epochFromPeer(11, 26, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, epochFromPeer(30, 26, 1770561100));
+
+  PackedReading batch[2] = {};
+  batch[0].epoch = 5;
+  batch[1].epoch = 1770561000;
+  clearRelativeEpochs(batch, 2);
+  TEST_ASSERT_EQUAL_UINT32(0, batch[0].epoch);
+  TEST_ASSERT_EQUAL_UINT32(1770561000, batch[1].epoch);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reference_timestamp);
+  RUN_TEST(test_matches_gmtime);
+  RUN_TEST(test_civil_roundtrip);
+  RUN_TEST(test_tz_offset_matches_localtime);
+  RUN_TEST(test_timestamp_dst_and_unknown);
+  RUN_TEST(test_relative_stamps_backfilled);
+  RUN_TEST(test_relative_stamps_from_peer_and_cleared);
+  return UNITY_END();
+}
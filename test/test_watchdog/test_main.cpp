@@ -0,0 +1,112 @@
+#include <string.h>
+#include <unity.h>
+#include "stall_watch.h"
+
+/**
+ * Chien de garde logiciel : attribution d'un blocage a l'etape en cours,
+ * battement de boucle, releve conserve en memoire RTC.
+ */
+
+enum { ST_SAMPLE, ST_DHT, ST_PUBLISH, ST_COUNT };
+
+static const uint32_t LIMITS[ST_COUNT] = {5000, 500, 30000};
+
+void setUp() {}
+void tearDown() {}
+
+void test_innermost_stage_is_blamed() {
+  WatchSlot w = {};
+  Stall s;
+  watchEnter(w, ST_SAMPLE, 1000);
+  watchEnter(w, ST_DHT, 1010);
+  TEST_ASSERT_FALSE(watchCheck(w, 1500, LIMITS, s));
+  TEST_ASSERT_TRUE(watchCheck(w, 1600, LIMITS, s));
+  TEST_ASSERT_EQUAL_UINT8(ST_DHT, s.stage);
+  TEST_ASSERT_EQUAL_UINT32(590, s.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(500, s.limitMs);
+}
+
+void test_outer_stage_blamed_between_inner_stages() {
+  WatchSlot w = {};
+  Stall s;
+  watchEnter(w, ST_SAMPLE, 1000);
+  watchEnter(w, ST_DHT, 1010);
+  watchExit(w, 1040);
+  // Bloque apres la lecture DHT, toujours dans le cycle d'acquisition
+  TEST_ASSERT_TRUE(watchCheck(w, 6100, LIMITS, s));
+  TEST_ASSERT_EQUAL_UINT8(ST_SAMPLE, s.stage);
+  watchExit(w, 6200);
+  TEST_ASSERT_EQUAL_UINT8(0, w.depth);
+  TEST_ASSERT_FALSE(watchCheck(w, 60000, LIMITS, s));  // Boucle non surveillee
+}
+
+void test_loop_heartbeat_outside_stages() {
+  WatchSlot w = {};
+  w.loopStallMs = 20000;
+  Stall s;
+  watchBeat(w, 1000);
+  TEST_ASSERT_FALSE(watchCheck(w, 21000, LIMITS, s));
+  TEST_ASSERT_TRUE(watchCheck(w, 21001, LIMITS, s));
+  TEST_ASSERT_EQUAL_UINT8(WATCH_NONE, s.stage);
+  // Dans une etape, seule sa limite compte
+  watchEnter(w, ST_PUBLISH, 21001);
+  TEST_ASSERT_FALSE(watchCheck(w, 40000, LIMITS, s));
+  watchExit(w, 40000);
+  TEST_ASSERT_FALSE(watchCheck(w, 40001, LIMITS, s));
+}
+
+void test_clock_wrap() {
+  WatchSlot w = {};
+  Stall s;
+  watchEnter(w, ST_DHT, UINT32_MAX - 100);
+  TEST_ASSERT_FALSE(watchCheck(w, 300, LIMITS, s));
+  TEST_ASSERT_TRUE(watchCheck(w, 500, LIMITS, s));
+  TEST_ASSERT_EQUAL_UINT32(601, s.elapsedMs);
+}
+
+void test_depth_overflow_keeps_tracked_stages() {
+  WatchSlot w = {};
+  Stall s;
+  for (int i = 0; i < WATCH_DEPTH + 2; i++) {
+    watchEnter(w, ST_PUBLISH, 100);
+  }
+  watchEnter(w, ST_DHT, 100);  // Non suivie
+  TEST_ASSERT_FALSE(watchCheck(w, 1000, LIMITS, s));
+  for (int i = 0; i < WATCH_DEPTH + 3; i++) {
+    watchExit(w, 200);
+  }
+  TEST_ASSERT_EQUAL_UINT8(0, w.depth);
+  watchExit(w, 300);  // Sortie en trop sans effet
+  TEST_ASSERT_EQUAL_UINT8(0, w.depth);
+}
+
+void test_stall_record_roundtrip() {
+  StallRecord r;
+  memset(&r, 0xA5, sizeof(r));  // Memoire RTC apres mise sous tension
+  TEST_ASSERT_FALSE(stallRecordValid(r));
+  r = {};
+  r.core = 0;
+  r.stage = ST_PUBLISH;
+  r.fresh = 1;
+  r.stalls = 3;
+  r.elapsedMs = 30500;
+  r.limitMs = 30000;
+  r.uptimeS = 86400;
+  r.epoch = 1770561000;
+  stallRecordSeal(r);
+  TEST_ASSERT_TRUE(stallRecordValid(r));
+  StallRecord copy = r;
+  copy.elapsedMs ^= 1;
+  TEST_ASSERT_FALSE(stallRecordValid(copy));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_innermost_stage_is_blamed);
+  RUN_TEST(test_outer_stage_blamed_between_inner_stages);
+  RUN_TEST(test_loop_heartbeat_outside_stages);
+  RUN_TEST(test_clock_wrap);
+  RUN_TEST(test_depth_overflow_keeps_tracked_stages);
+  RUN_TEST(test_stall_record_roundtrip);
+  return UNITY_END();
+}
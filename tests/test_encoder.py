@@ -0,0 +1,385 @@
+"""
+Tests des encodages binaires de la MeteoStation (miroir de lib/MeteoCore/src/encoder.cpp).
+
+Format BINARY v1 : en-tete (version, nombre) puis, par releve,
+epoch u32, masque de validite u8 et un int16 par canal en centiemes.
+Format BINARY v2 (publication par exception) : masque des canaux presents
+et un int16 par canal present et valide.
+Format CBOR : [1, [[epoch, c0, c1, c2, c3], ...]] avec null si invalide,
+undefined si inchange (version 2).
+Format compresse (lib/MeteoCore/src/compress.cpp, MQTT_TOPIC/z) : colonnes
+delta zigzag/LEB128 des champs de PackedReading, puis LZSS (fenetre 8 bits,
+longueur 4 bits).
+"""
+
+import json
+import struct
+import pytest
+
+BINARY_VERSION = 1
+CHANNELS = ["dht_temperature", "dht_humidity", "ntc_temperature", "luminosity"]
+
+
+def to_centi(value):
+    """Valeur -> entier en centiemes, arrondi au plus proche (packReading)."""
+    c = value * 100.0
+    return int(c + (0.5 if c >= 0 else -0.5))
+
+
+def encode_binary(readings):
+    """readings : liste de (epoch, [valeurs ou None]) -> bytes."""
+    out = struct.pack("<BB", BINARY_VERSION, len(readings))
+    for epoch, values in readings:
+        valid = sum(1 << i for i, v in enumerate(values) if v is not None)
+        centi = [to_centi(v) if v is not None else 0 for v in values]
+        out += struct.pack("<IB4h", epoch, valid, *centi)
+    return out
+
+
+def decode_binary(data):
+    version, count = struct.unpack_from("<BB", data, 0)
+    assert version == BINARY_VERSION
+    readings = []
+    for i in range(count):
+        epoch, valid, *centi = struct.unpack_from("<IB4h", data, 2 + 13 * i)
+        values = [c / 100.0 if (valid >> ch) & 1 else None for ch, c in enumerate(centi)]
+        readings.append((epoch, values))
+    return readings
+
+
+def encode_binary_v2(readings):
+    """readings : liste de (epoch, [valeurs, None si invalide], masque omis) -> bytes."""
+    out = struct.pack("<BB", 2, len(readings))
+    for epoch, values, omitted in readings:
+        valid = sum(1 << i for i, v in enumerate(values) if v is not None)
+        present = ~omitted & 0x0F
+        out += struct.pack("<IBB", epoch, valid, present)
+        for ch, v in enumerate(values):
+            if (present & valid) >> ch & 1:
+                out += struct.pack("<h", to_centi(v))
+    return out
+
+
+def decode_binary_v2(data):
+    """Retourne (epoch, {canal: valeur ou None}) ; un canal absent est inchange."""
+    version, count = struct.unpack_from("<BB", data, 0)
+    assert version == 2
+    pos, readings = 2, []
+    for _ in range(count):
+        epoch, valid, present = struct.unpack_from("<IBB", data, pos)
+        pos += 6
+        values = {}
+        for ch in range(len(CHANNELS)):
+            if not (present >> ch) & 1:
+                continue
+            if (valid >> ch) & 1:
+                values[CHANNELS[ch]] = struct.unpack_from("<h", data, pos)[0] / 100.0
+                pos += 2
+            else:
+                values[CHANNELS[ch]] = None
+        readings.append((epoch, values))
+    assert pos == len(data)
+    return readings
+
+
+def cbor_head(major, arg):
+    if arg < 24:
+        return bytes([major << 5 | arg])
+    if arg <= 0xFF:
+        return bytes([major << 5 | 24, arg])
+    if arg <= 0xFFFF:
+        return bytes([major << 5 | 25]) + struct.pack(">H", arg)
+    return bytes([major << 5 | 26]) + struct.pack(">I", arg)
+
+
+def cbor_int(v):
+    return cbor_head(0, v) if v >= 0 else cbor_head(1, -1 - v)
+
+
+def encode_cbor(readings, version=1):
+    """readings : (epoch, valeurs) ou (epoch, valeurs, masque omis) en version 2."""
+    out = cbor_head(4, 2) + cbor_int(version) + cbor_head(4, len(readings))
+    for epoch, values, *rest in readings:
+        omitted = rest[0] if rest else 0
+        out += cbor_head(4, 1 + len(values)) + cbor_head(0, epoch)
+        for ch, v in enumerate(values):
+            if (omitted >> ch) & 1:
+                out += b"\xf7"
+            else:
+                out += cbor_int(to_centi(v)) if v is not None else b"\xf6"
+    return out
+
+
+UNDEFINED = object()
+
+
+def decode_cbor(data, pos=0):
+    """Decodeur CBOR minimal (entiers, tableaux, null)."""
+    ib = data[pos]
+    major, info = ib >> 5, ib & 0x1F
+    pos += 1
+    if ib == 0xF6:
+        return None, pos
+    if ib == 0xF7:
+        return UNDEFINED, pos
+    if info < 24:
+        arg = info
+    else:
+        size = {24: 1, 25: 2, 26: 4}[info]
+        arg = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = decode_cbor(data, pos)
+            items.append(item)
+        return items, pos
+    raise ValueError(f"Type CBOR non supporte : {major}")
+
+
+COMPRESS_HEADER = 6
+LZSS_WINDOW_BITS = 8
+LZSS_LENGTH_BITS = 4
+LZSS_MIN_MATCH = 2
+LZSS_MAX_MATCH = LZSS_MIN_MATCH + (1 << LZSS_LENGTH_BITS) - 1
+PACKED_FIELDS = ["seq", "epoch", "valid", "omitted", "interval_s", "c0", "c1", "c2", "c3"]
+PACKED_SIZE = 20
+
+
+def lzss_compress(data):
+    """Meme recherche gloutonne que lzssCompress : du plus proche au plus lointain."""
+    bits = []
+    i = 0
+    while i < len(data):
+        max_len = min(len(data) - i, LZSS_MAX_MATCH)
+        best_len = best_dist = 0
+        j = i
+        while j > max(0, i - (1 << LZSS_WINDOW_BITS)) and best_len < max_len:
+            j -= 1
+            n = 0
+            while n < max_len and data[j + n] == data[i + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_dist = n, i - j
+        if best_len >= LZSS_MIN_MATCH:
+            bits.append("0" + format(best_dist - 1, f"0{LZSS_WINDOW_BITS}b")
+                        + format(best_len - LZSS_MIN_MATCH, f"0{LZSS_LENGTH_BITS}b"))
+            i += best_len
+        else:
+            bits.append("1" + format(data[i], "08b"))
+            i += 1
+    stream = "".join(bits)
+    stream += "0" * (-len(stream) % 8)
+    return bytes(int(stream[k:k + 8], 2) for k in range(0, len(stream), 8))
+
+
+def lzss_decompress(data, out_len):
+    stream = "".join(format(b, "08b") for b in data)
+    out = bytearray()
+    pos = 0
+    while len(out) < out_len:
+        if stream[pos] == "1":
+            out.append(int(stream[pos + 1:pos + 9], 2))
+            pos += 9
+            continue
+        dist = int(stream[pos + 1:pos + 1 + LZSS_WINDOW_BITS], 2) + 1
+        pos += 1 + LZSS_WINDOW_BITS
+        length = int(stream[pos:pos + LZSS_LENGTH_BITS], 2) + LZSS_MIN_MATCH
+        pos += LZSS_LENGTH_BITS
+        if dist > len(out):
+            raise ValueError("Reference avant le debut")
+        for _ in range(length):
+            out.append(out[-dist])
+    return bytes(out)
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        out.append(b | 0x80 if v else b)
+        if not v:
+            return bytes(out)
+
+
+def encode_compressed(readings):
+    """readings : dicts aux cles PACKED_FIELDS (c0..c3 en centiemes)."""
+    cols = bytearray()
+    for field in PACKED_FIELDS:
+        prev = 0
+        for r in readings:
+            cur = r[field] & 0xFFFFFFFF
+            d = (cur - prev) & 0xFFFFFFFF
+            d = d - (1 << 32) if d & 0x80000000 else d
+            cols += varint(((d << 1) ^ (d >> 31)) & 0xFFFFFFFF)
+            prev = cur
+    z = lzss_compress(bytes(cols))
+    method, data = (1, z) if len(z) < len(cols) else (0, bytes(cols))
+    return struct.pack("<BBBBH", 1, PACKED_SIZE, len(readings), method, len(cols)) + data
+
+
+def decode_compressed(data):
+    version, size, count, method, col_len = struct.unpack_from("<BBBBH", data)
+    assert version == 1 and size == PACKED_SIZE
+    body = data[COMPRESS_HEADER:]
+    cols = lzss_decompress(body, col_len) if method == 1 else body
+    readings = [{} for _ in range(count)]
+    pos = 0
+    for field in PACKED_FIELDS:
+        prev = 0
+        for r in readings:
+            z = shift = 0
+            while True:
+                b = cols[pos]
+                pos += 1
+                z |= (b & 0x7F) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            prev = (prev + ((z >> 1) ^ -(z & 1))) & 0xFFFFFFFF
+            r[field] = prev
+    assert pos == col_len
+    for r in readings:
+        for ch in ("c0", "c1", "c2", "c3"):
+            r[ch] = (r[ch] & 0xFFFF) - (0x10000 if r[ch] & 0x8000 else 0)
+    return readings
+
+
+READING = (1770561000, [20.7, 52.0, 21.1, 77.0])
+READING_DHT_KO = (1770561010, [None, None, -5.25, 0.0])
+
+# Sequence du firmware avec bandes mortes (50, 200, 20, 300) : le 2e releve
+# ne change rien et n'est pas publie ; octets produits par encodeBinary/encodeCbor
+EXCEPTION_READINGS = [
+    (1770561000, [20.7, 52.0, 21.1, 77.0], 0x0),
+    (1770561020, [21.3, 52.5, 21.2, 80.5], 0x6),
+    (1770561030, [None, None, 21.35, 80.5], 0x8),
+]
+EXCEPTION_BINARY = bytes.fromhex(
+    "0203e89d88690f0f160850143e08141efc9d88690f095208721f069e88690c075708")
+EXCEPTION_CBOR = bytes.fromhex(
+    "820283851a69889de819081619145019083e191e14851a69889dfc190852f7f7191f72"
+    "851a69889e06f6f6190857f7")
+
+# 12 releves reguliers (releve 7 sans DHT), octets produits par encodeCompressed
+COMPRESSED_READINGS = [
+    {"seq": 100 + i, "epoch": 1770561000 + i * 10, "valid": 0x0C if i == 7 else 0x0F,
+     "omitted": 0, "interval_s": 0, "c0": 0 if i == 7 else 2070 + i % 3,
+     "c1": 0 if i == 7 else 5200, "c2": -525 + i, "c3": 7700}
+    for i in range(12)
+]
+COMPRESSED = bytes.fromhex(
+    "01140c017900e440604008e87df899886c500111e80000e0b0603a003c005ac900dc20"
+    "6021d5c836120038e82a2164cfd44127998417a751781bc8")
+
+
+class TestBinaryEncoding:
+    """Tests de l'enregistrement binaire versionne."""
+
+    def test_record_size(self):
+        """En-tete de 2 octets puis 13 octets par releve."""
+        assert len(encode_binary([READING])) == 15
+        assert len(encode_binary([READING] * 10)) == 2 + 13 * 10
+
+    def test_roundtrip(self):
+        """Decodage fidele au centieme, canaux invalides a None."""
+        decoded = decode_binary(encode_binary([READING, READING_DHT_KO]))
+        assert decoded[0][0] == READING[0]
+        assert decoded[0][1] == pytest.approx(READING[1])
+        assert decoded[1][1][:2] == [None, None]
+        assert decoded[1][1][2] == pytest.approx(-5.25)
+
+    def test_version_header(self):
+        """Le premier octet porte la version du format."""
+        assert encode_binary([READING])[0] == BINARY_VERSION
+
+    def test_much_smaller_than_json(self):
+        """Au moins 5x plus compact que le payload JSON unitaire."""
+        payload = {
+            "timestamp": "2026-02-08T15:30:00+01:00",
+            "user": "user@example.com",
+            "device": "meteoStation_1",
+            **dict(zip(CHANNELS, READING[1])),
+        }
+        assert len(json.dumps(payload)) >= 5 * len(encode_binary([READING]))
+
+
+class TestBinaryV2Encoding:
+    """Tests de l'enregistrement binaire v2 (publication par exception)."""
+
+    def test_matches_firmware_bytes(self):
+        """Le miroir produit les memes octets que encodeBinary (REPORT_BY_EXCEPTION)."""
+        assert encode_binary_v2(EXCEPTION_READINGS) == EXCEPTION_BINARY
+
+    def test_only_present_channels(self):
+        """Seuls les canaux presents et valides portent une valeur."""
+        decoded = decode_binary_v2(EXCEPTION_BINARY)
+        assert set(decoded[1][1]) == {"dht_temperature", "luminosity"}
+        assert decoded[2][1] == {"dht_temperature": None, "dht_humidity": None,
+                                 "ntc_temperature": pytest.approx(21.35)}
+
+    def test_full_record_size(self):
+        """Un releve complet v2 fait 14 octets, un releve sans valeur 6."""
+        full = encode_binary_v2([(0, [1.0, 2.0, 3.0, 4.0], 0)])
+        empty = encode_binary_v2([(0, [None, None, None, None], 0)])
+        assert len(full) == 2 + 14
+        assert len(empty) == 2 + 6
+
+
+class TestCborEncoding:
+    """Tests de l'encodage CBOR."""
+
+    def test_roundtrip(self):
+        """Structure [version, [[epoch, c0..c3], ...]]."""
+        decoded, end = decode_cbor(encode_cbor([READING, READING_DHT_KO]))
+        data = encode_cbor([READING, READING_DHT_KO])
+        assert end == len(data)
+        version, records = decoded
+        assert version == 1
+        assert records[0] == [READING[0], 2070, 5200, 2110, 7700]
+        assert records[1] == [READING_DHT_KO[0], None, None, -525, 0]
+
+    def test_record_size(self):
+        """Un releve tient en moins de 20 octets (borne CBOR_RECORD_MAX = 18)."""
+        one = len(encode_cbor([READING]))
+        two = len(encode_cbor([READING, READING]))
+        assert two - one <= 18
+
+    def test_undefined_for_unchanged(self):
+        """Version 2 : undefined pour un canal inchange, octets du firmware."""
+        data = encode_cbor(EXCEPTION_READINGS, version=2)
+        assert data == EXCEPTION_CBOR
+        (version, records), _ = decode_cbor(data)
+        assert version == 2
+        assert records[1][2] is UNDEFINED
+        assert records[2][1] is None
+
+    def test_negative_integer(self):
+        """Les temperatures negatives utilisent le type majeur 1."""
+        assert cbor_int(-525) == bytes([0x39, 0x02, 0x0C])
+
+
+class TestCompressedEncoding:
+    """Tests du format compresse du rejeu de coupure."""
+
+    def test_matches_firmware_bytes(self):
+        """Le miroir produit les memes octets que encodeCompressed."""
+        assert encode_compressed(COMPRESSED_READINGS) == COMPRESSED
+
+    def test_decode_firmware_bytes(self):
+        """Le decodeur retrouve les releves, temperatures negatives comprises."""
+        assert decode_compressed(COMPRESSED) == COMPRESSED_READINGS
+
+    def test_ratio(self):
+        """Un lot regulier tient dans moins d'un tiers de ses PackedReading."""
+        assert len(COMPRESSED) * 3 < len(COMPRESSED_READINGS) * PACKED_SIZE
+
+    def test_lzss_roundtrip(self):
+        """Copies chevauchantes et litteraux isoles."""
+        data = b"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab" + bytes(range(40)) + b"ab" * 30
+        assert lzss_decompress(lzss_compress(data), len(data)) == data
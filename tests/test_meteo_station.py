@@ -2,7 +2,8 @@
 Tests unitaires pour la logique de la MeteoStation.
 
 Reproduit en Python les calculs effectues dans le firmware ESP32
-(equation Beta NTC, conversion LDR, construction du payload MQTT).
+(equation Beta NTC, table NTC precalculee, conversion LDR,
+construction du payload MQTT).
 """
 
 import json
@@ -33,6 +34,27 @@ def ntc_temperature(raw_adc):
     return temp_k - 273.15
 
 
+def build_ntc_lut():
+    """Table ADC -> temperature en centiemes de degre (miroir de ntc_lut.h)."""
+    lut = []
+    for raw in range(int(ADC_MAX) + 1):
+        clamped = min(max(raw, 1), int(ADC_MAX) - 1)
+        temp = ntc_temperature(clamped)
+        lut.append(int(temp * 100.0 + (0.5 if temp >= 0 else -0.5)))
+    return lut
+
+
+def ntc_lut_interp(lut, raw):
+    """Interpolation lineaire entre deux entrees de la table."""
+    if raw <= 0:
+        return lut[0] / 100.0
+    if raw >= ADC_MAX:
+        return lut[int(ADC_MAX)] / 100.0
+    i = int(raw)
+    frac = raw - i
+    return (lut[i] + (lut[i + 1] - lut[i]) * frac) / 100.0
+
+
 def ldr_percentage(raw_adc):
     """Conversion ADC -> luminosite en pourcentage."""
     return raw_adc * 100.0 / ADC_MAX
@@ -59,6 +81,249 @@ def build_payload(timestamp, user, device, dht_temp, dht_humidity, ntc_temp, lum
     return payload
 
 
+def build_batch_payload(user, device, readings):
+    """Construit le payload groupe : en-tete user/device puis tableau de releves."""
+    return {
+        "user": user,
+        "device": device,
+        "readings": [
+            {
+                "timestamp": ts,
+                "dht_temperature": dht_temp,
+                "dht_humidity": dht_humidity,
+                "ntc_temperature": ntc_temp,
+                "luminosity": luminosity,
+            }
+            for ts, dht_temp, dht_humidity, ntc_temp, luminosity in readings
+        ],
+    }
+
+
+def days_from_civil(y, m, d):
+    """Jours depuis 1970-01-01 (miroir de daysFromCivil, timefmt.cpp)."""
+    y -= m <= 2
+    era = (y if y >= 0 else y - 399) // 400
+    yoe = y - era * 400
+    doy = (153 * (m - 3 if m > 2 else m + 9) + 2) // 5 + d - 1
+    doe = yoe * 365 + yoe // 4 - yoe // 100 + doy
+    return era * 146097 + doe - 719468
+
+
+def civil_from_days(z):
+    """Date civile (annee, mois, jour) d'un nombre de jours depuis 1970-01-01."""
+    z += 719468
+    era = (z if z >= 0 else z - 146096) // 146097
+    doe = z - era * 146097
+    yoe = (doe - doe // 1460 + doe // 36524 - doe // 146096) // 365
+    doy = doe - (365 * yoe + yoe // 4 - yoe // 100)
+    mp = (5 * doy + 2) // 153
+    d = doy - (153 * mp + 2) // 5 + 1
+    m = mp + 3 if mp < 10 else mp - 9
+    return yoe + era * 400 + (m <= 2), m, d
+
+
+def format_iso8601(epoch, offset_s):
+    """Horodatage ISO 8601 en arithmetique entiere (miroir de formatIso8601)."""
+    days, secs = divmod(epoch + offset_s, 86400)
+    y, m, d = civil_from_days(days)
+    sign = "-" if offset_s < 0 else "+"
+    off = abs(offset_s)
+    return (f"{y:04d}-{m:02d}-{d:02d}T{secs // 3600:02d}:{secs // 60 % 60:02d}:{secs % 60:02d}"
+            f"{sign}{off // 3600:02d}:{off // 60 % 60:02d}")
+
+
+def format_centi1(centi):
+    """Valeur en centiemes ecrite avec une decimale, arrondi au plus proche."""
+    deci = (abs(centi) + 5) // 10
+    return f"{'-' if centi < 0 else ''}{deci // 10}.{deci % 10}"
+
+
+def deadband_apply(state, values, bands, heartbeat, step=1):
+    """
+    Publication par exception (miroir de deadbandApply, deadband.h).
+    values : centiemes par canal, None si invalide. Retourne (publier, omis).
+    step : un par releve (cadence fixe) ou duree ecoulee (cadence adaptative).
+    """
+    state["since_full"] = state.get("since_full", 0) + step
+    full = not state.get("primed") or state["since_full"] >= heartbeat
+    last = state.setdefault("last", [None] * len(values))
+    omitted = 0
+    for ch, c in enumerate(values):
+        if (c is None) != (last[ch] is None):
+            changed = True
+        elif c is not None:
+            changed = abs(c - last[ch]) >= bands[ch]
+        else:
+            changed = False
+        if changed or full:
+            last[ch] = c
+        else:
+            omitted |= 1 << ch
+    if full:
+        state["primed"] = True
+        state["since_full"] = 0
+        return True, omitted
+    return omitted != (1 << len(values)) - 1, omitted
+
+
+ADC_CAL_FRAC = 16
+ADC_CAL_SMOOTH = 9
+
+
+def adc_cal_build(mv, supply_mv=3300):
+    """
+    Table de correction ADC (miroir de adcCalBuild, adc_cal.cpp) : tension
+    lissee sur ADC_CAL_SMOOTH codes -> code lineaire en 1/16 de LSB.
+    """
+    half, n, top = ADC_CAL_SMOOTH // 2, len(mv), 4095 * ADC_CAL_FRAC
+    table = []
+    for i in range(n):
+        window = mv[max(0, i - half):min(n, i + half + 1)]
+        q = (sum(window) * top + len(window) * supply_mv // 2) // (len(window) * supply_mv)
+        table.append(min(q, top))
+    return table
+
+
+DHT_OK, DHT_ERR_TIMEOUT, DHT_ERR_FRAME, DHT_ERR_CHECKSUM = range(4)
+
+
+def dht_decode_frame(pulses):
+    """
+    Decodage d'une trame DHT (miroir de dhtDecodeFrame, dht_decoder.cpp).
+    pulses : liste de (niveau, duree_us). Retourne (statut, octets).
+    """
+    highs = [us for level, us in pulses if level and us > 0]
+    if not highs:
+        return DHT_ERR_TIMEOUT, None
+    if len(highs) < 40:
+        return DHT_ERR_FRAME, None
+    bits = highs[-40:]
+    if any(us > 100 for us in bits):
+        return DHT_ERR_FRAME, None
+    data = [0] * 5
+    for i, us in enumerate(bits):
+        data[i // 8] = (data[i // 8] << 1) | (1 if us > 50 else 0)
+    ok = sum(data[:4]) & 0xFF == data[4]
+    return (DHT_OK if ok else DHT_ERR_CHECKSUM), data
+
+
+def dht11_convert(data):
+    """Octets DHT11 -> (temperature, humidite), comme la bibliotheque Adafruit."""
+    hum = data[0] + data[1] * 0.1
+    temp = float(data[2])
+    if data[3] & 0x80:
+        temp = -1 - temp
+    return temp + (data[3] & 0x0F) * 0.1, hum
+
+
+def dht_frame(data, one_us=70, zero_us=27):
+    """Capture RMT synthetique : liberation, reponse, 40 bits, repos final."""
+    pulses = [(1, 30), (0, 80), (1, 80)]
+    for i in range(40):
+        bit = (data[i // 8] >> (7 - i % 8)) & 1
+        pulses += [(0, 50), (1, one_us if bit else zero_us)]
+    return pulses + [(0, 50), (1, 0)]
+
+
+ADC_FILTER_MEAN, ADC_FILTER_MEDIAN, ADC_FILTER_TRIMMED, ADC_FILTER_IIR = range(4)
+
+
+class SampleFilter:
+    """Filtre incremental d'une salve ADC (miroir de adc_filter.h)."""
+
+    def __init__(self, kind, window=32, trim_pct=20, alpha=0.1):
+        self.kind, self.window, self.trim_pct, self.alpha = kind, window, trim_pct, alpha
+        self.iir = None
+        self.begin()
+
+    def begin(self):
+        self.block, self.count, self.total = [], 0, 0.0
+
+    def add(self, raw):
+        self.count += 1
+        if self.kind == ADC_FILTER_MEAN:
+            self.total += raw
+        elif self.kind == ADC_FILTER_IIR:
+            self.iir = raw if self.iir is None else self.iir + self.alpha * (raw - self.iir)
+        else:
+            self.block.append(raw)
+            if len(self.block) == self.window:
+                self._close_block()
+
+    def _close_block(self):
+        b, n = sorted(self.block), len(self.block)
+        if self.kind == ADC_FILTER_MEDIAN:
+            v = b[n // 2] if n % 2 else (b[n // 2 - 1] + b[n // 2]) / 2
+        else:
+            k = n * self.trim_pct // 100
+            if 2 * k >= n:
+                k = (n - 1) // 2
+            v = sum(b[k:n - k]) / (n - 2 * k)
+        self.total += v * n
+        self.block = []
+
+    def result(self):
+        if self.count == 0:
+            return 0.0
+        if self.kind == ADC_FILTER_IIR:
+            return self.iir
+        if self.block:
+            self._close_block()
+        return self.total / self.count
+
+
+class Welford:
+    """Statistiques incrementales d'une voie (miroir de welford.h)."""
+
+    def __init__(self):
+        self.n, self.mean, self.m2 = 0, 0.0, 0.0
+        self.min = self.max = None
+
+    def add(self, x):
+        self.n += 1
+        if self.n == 1:
+            self.mean = self.min = self.max = x
+            return
+        delta = x - self.mean
+        self.mean += delta / self.n
+        self.m2 += delta * (x - self.mean)
+        self.min = min(self.min, x)
+        self.max = max(self.max, x)
+
+    def stddev(self):
+        return math.sqrt(self.m2 / (self.n - 1)) if self.n > 1 else 0.0
+
+
+STAGE_HIST_BINS = 20
+
+
+def stage_bin(us):
+    """Classe d'histogramme d'une duree (miroir de stageBin, stage_stats.h)."""
+    b = 0
+    while us > 1 and b < STAGE_HIST_BINS - 1:
+        us >>= 1
+        b += 1
+    return b
+
+
+class Backoff:
+    """Attente exponentielle plafonnee avec gigue (miroir de backoff.h)."""
+
+    def __init__(self, base_ms, cap_ms):
+        self.base_ms = base_ms
+        self.cap_ms = cap_ms
+        self.attempts = 0
+
+    def next(self, rnd):
+        d = min(self.cap_ms, self.base_ms << self.attempts) if self.attempts < 31 else self.cap_ms
+        self.attempts += 1
+        half = d // 2
+        return half + rnd % (d - half + 1)
+
+    def reset(self):
+        self.attempts = 0
+
+
 # =============================================================================
 # Tests NTC
 # =============================================================================
@@ -103,6 +368,43 @@ class TestNtcTemperature:
             assert -40 < temp < 150, f"Temperature {temp} C hors plage pour ADC={raw}"
 
 
+# =============================================================================
+# Tests table NTC precalculee
+# =============================================================================
+
+class TestNtcLut:
+    """Tests de la table de conversion NTC generee a la compilation."""
+
+    LUT = build_ntc_lut()
+
+    def test_lut_size(self):
+        """Une entree par code ADC 12 bits."""
+        assert len(self.LUT) == 4096
+
+    def test_lut_fits_int16(self):
+        """Toutes les entrees tiennent dans un int16_t."""
+        assert all(-32768 <= c <= 32767 for c in self.LUT)
+
+    def test_lut_matches_beta_equation(self):
+        """L'ecart avec l'equation Beta est inferieur a 0.01 C."""
+        for raw in range(1, int(ADC_MAX)):
+            assert self.LUT[raw] / 100.0 == pytest.approx(ntc_temperature(raw), abs=0.01)
+
+    def test_lut_extremes_clamped(self):
+        """Les codes 0 et 4095 reprennent la valeur de leurs voisins."""
+        assert self.LUT[0] == self.LUT[1]
+        assert self.LUT[4095] == self.LUT[4094]
+
+    def test_lut_monotonic(self):
+        """La temperature decroit quand le code ADC augmente."""
+        assert all(a >= b for a, b in zip(self.LUT, self.LUT[1:]))
+
+    def test_interp_fractional_raw(self):
+        """L'interpolation d'une moyenne fractionnaire reste proche de l'equation Beta."""
+        for raw in (150.25, 613.5, 1200.75, 3000.1):
+            assert ntc_lut_interp(self.LUT, raw) == pytest.approx(ntc_temperature(raw), abs=0.01)
+
+
 # =============================================================================
 # Tests LDR
 # =============================================================================
@@ -228,3 +530,417 @@ class TestMqttPayload:
         device = "meteoStation_1"
         topic = f"sensors/{user}/{device}"
         assert topic == "sensors/user@example.com/meteoStation_1"
+
+
+# =============================================================================
+# Tests payload MQTT groupe
+# =============================================================================
+
+class TestMqttBatchPayload:
+    """Tests du payload groupe publie sur sensors/{user}/{device}/batch."""
+
+    READINGS = [
+        ("2026-02-08T15:30:00+01:00", 20.7, 52.0, 21.1, 77.0),
+        ("2026-02-08T15:30:10+01:00", None, None, 21.2, 76.0),
+    ]
+
+    def test_batch_header_once(self):
+        """user et device ne sont presents qu'une fois, dans l'en-tete."""
+        payload = build_batch_payload("user@example.com", "meteoStation_1", self.READINGS)
+        assert set(payload.keys()) == {"user", "device", "readings"}
+        for reading in payload["readings"]:
+            assert "user" not in reading
+            assert "device" not in reading
+
+    def test_batch_keeps_order_and_timestamps(self):
+        """Chaque releve garde son horodatage d'origine, dans l'ordre."""
+        payload = build_batch_payload("user@example.com", "meteoStation_1", self.READINGS)
+        timestamps = [r["timestamp"] for r in payload["readings"]]
+        assert timestamps == [r[0] for r in self.READINGS]
+
+    def test_batch_dht_null(self):
+        """Un releve DHT en erreur garde des champs null dans le lot."""
+        payload = build_batch_payload("user@example.com", "meteoStation_1", self.READINGS)
+        json_str = json.dumps(payload)
+        assert json.loads(json_str)["readings"][1]["dht_temperature"] is None
+
+    def test_batch_smaller_than_single_messages(self):
+        """Un lot est plus compact que les messages unitaires equivalents."""
+        user, device = "user@example.com", "meteoStation_1"
+        batch = json.dumps(build_batch_payload(user, device, self.READINGS * 10))
+        singles = sum(
+            len(json.dumps(build_payload(ts, user, device, t, h, n, l)))
+            for ts, t, h, n, l in self.READINGS * 10
+        )
+        assert len(batch) < singles
+
+    def test_batch_topic_format(self):
+        """Les lots sont publies sur le sous-topic /batch."""
+        topic = "sensors/user@example.com/meteoStation_1" + "/batch"
+        assert topic.endswith("/meteoStation_1/batch")
+
+
+# =============================================================================
+# Tests formatage sans allocation (horodatage, valeurs)
+# =============================================================================
+
+class TestTimestampFormat:
+    """Tests de l'horodatage ISO 8601 et des valeurs, sans strftime ni printf."""
+
+    def test_reference_timestamp(self):
+        """2026-02-08 14:30 UTC s'ecrit 15:30+01:00 en heure d'hiver."""
+        assert format_iso8601(1770561000, 3600) == "2026-02-08T15:30:00+01:00"
+
+    def test_matches_datetime(self):
+        """Le calcul entier donne le meme resultat que datetime, CET et CEST."""
+        from datetime import datetime, timedelta, timezone
+        for offset in (3600, 7200, 0, -18000):
+            tz = timezone(timedelta(seconds=offset))
+            for epoch in range(1577836800, 1900000000, 9876543):
+                expected = datetime.fromtimestamp(epoch, tz).isoformat()
+                assert format_iso8601(epoch, offset) == expected
+
+    def test_day_rollover_with_offset(self):
+        """Le decalage peut faire passer au jour, mois et an suivants."""
+        assert format_iso8601(1798758000, 3600) == "2027-01-01T00:00:00+01:00"
+
+    def test_civil_roundtrip(self):
+        """daysFromCivil et civilFromDays sont inverses, annees bissextiles comprises."""
+        for z in range(0, 30000, 7):
+            assert days_from_civil(*civil_from_days(z)) == z
+        assert civil_from_days(days_from_civil(2028, 2, 29)) == (2028, 2, 29)
+
+    def test_timestamp_length(self):
+        """L'horodatage tient dans TIMESTAMP_LEN (25 caracteres + fin de chaine)."""
+        assert len(format_iso8601(1770561000, 7200)) == 25
+
+    def test_centi_one_decimal(self):
+        """Les centiemes sont arrondis a une decimale comme %.1f."""
+        assert format_centi1(2351) == "23.5"
+        assert format_centi1(2355) == "23.6"
+        assert format_centi1(0) == "0.0"
+        assert format_centi1(-45) == "-0.5"
+        assert format_centi1(10000) == "100.0"
+        assert format_centi1(-32768) == "-327.7"
+
+
+# =============================================================================
+# Tests calibration ADC (table de correction)
+# =============================================================================
+
+def esp32_adc_mv(raw):
+    """Courbe typique ADC1 a 11 dB : decalage bas et compression haute (mV)."""
+    return round(142 + 0.78 * raw + 4.5e-5 * raw * raw - 1.4e-8 * raw ** 3)
+
+
+class TestAdcCalibration:
+    """Tests de la table code brut -> code lineaire precalculee au demarrage."""
+
+    def test_linear_adc_is_identity(self):
+        """Avec un ADC deja lineaire, le code corrige reste a 1/4 de LSB pres."""
+        table = adc_cal_build([round(r * 3300 / 4095) for r in range(4096)])
+        assert max(abs(table[r] - r * ADC_CAL_FRAC) for r in range(8, 4088)) <= ADC_CAL_FRAC // 4
+
+    def test_table_fits_uint16_and_monotonic(self):
+        """La table tient en uint16 (8 Ko) et conserve l'ordre des codes."""
+        table = adc_cal_build([esp32_adc_mv(r) for r in range(4096)])
+        assert max(table) <= 65535
+        assert all(b >= a for a, b in zip(table, table[1:]))
+
+    def test_clamped_above_supply(self):
+        """Une tension superieure a l'alimentation est bornee au code 4095."""
+        table = adc_cal_build([3400] * 4096)
+        assert set(table) == {4095 * ADC_CAL_FRAC}
+
+    def test_improves_ntc_accuracy(self):
+        """Sur un ADC non lineaire, l'erreur NTC passe de plusieurs C a moins de 0,2 C."""
+        table = adc_cal_build([esp32_adc_mv(r) for r in range(4096)])
+        curve = [esp32_adc_mv(r) for r in range(4096)]
+        worst_raw = worst_cal = 0.0
+        for true_code in range(600, 3600, 50):
+            true_temp = ntc_temperature(true_code)
+            mv = true_code * 3300 / 4095
+            raw = min(range(4096), key=lambda r: abs(curve[r] - mv))
+            worst_raw = max(worst_raw, abs(ntc_temperature(raw) - true_temp))
+            worst_cal = max(worst_cal, abs(ntc_temperature(table[raw] / ADC_CAL_FRAC) - true_temp))
+        assert worst_raw > 1.0
+        assert worst_cal < 0.2
+
+
+# =============================================================================
+# Tests decodeur DHT (capture RMT)
+# =============================================================================
+
+class TestDhtDecoder:
+    """Tests du decodage des trames DHT11 capturees par le RMT."""
+
+    def test_valid_frame(self):
+        """52 % / 21,3 C : trame decodee et somme de controle verifiee."""
+        status, data = dht_decode_frame(dht_frame([52, 0, 21, 3, 76]))
+        assert status == DHT_OK
+        assert dht11_convert(data) == pytest.approx((21.3, 52.0))
+
+    def test_checksum_error(self):
+        """Une somme de controle fausse est signalee, pas convertie en NaN."""
+        status, _ = dht_decode_frame(dht_frame([52, 0, 21, 3, 77]))
+        assert status == DHT_ERR_CHECKSUM
+
+    def test_truncated_frame(self):
+        """Une trame incomplete est une erreur de trame, l'absence de reponse un timeout."""
+        assert dht_decode_frame(dht_frame([52, 0, 21, 3, 76])[:40])[0] == DHT_ERR_FRAME
+        assert dht_decode_frame([])[0] == DHT_ERR_TIMEOUT
+
+    def test_timing_tolerance(self):
+        """Les durees hautes des bits peuvent deriver de +/- 15 us."""
+        frame = [52, 0, 21, 3, 76]
+        assert dht_decode_frame(dht_frame(frame, one_us=58, zero_us=40))[1] == frame
+        assert dht_decode_frame(dht_frame(frame, one_us=85, zero_us=15))[1] == frame
+
+    def test_negative_dht11(self):
+        """Bit 7 de l'octet decimal : temperature negative (DHT11 recents)."""
+        assert dht11_convert([40, 0, 2, 0x85, 0])[0] == pytest.approx(-2.5)
+
+
+# =============================================================================
+# Tests filtres ADC (mediane, moyenne tronquee, IIR)
+# =============================================================================
+
+# Salve avec deux pics (saturation et zero) ; valeurs produites par SampleFilter<8>
+SPIKY_BURST = [2000, 2001, 1999, 4095, 2002, 2000, 1998, 0, 2001, 2003,
+               2000, 1999, 2002, 2001, 2000, 2000, 1999, 2001, 2002, 2000]
+
+
+def filter_burst(kind, samples, **kw):
+    f = SampleFilter(kind, **kw)
+    for x in samples:
+        f.add(x)
+    return f.result()
+
+
+class TestAdcFilters:
+    """Tests des filtres incrementaux des voies NTC et LDR."""
+
+    def test_mean_shifted_by_spike(self):
+        """La moyenne simple est deplacee par un pic isole."""
+        assert filter_burst(ADC_FILTER_MEAN, SPIKY_BURST) == pytest.approx(2005.15)
+
+    def test_median_rejects_spikes(self):
+        """Mediane par blocs de 8 : identique au firmware, pics ignores."""
+        assert filter_burst(ADC_FILTER_MEDIAN, SPIKY_BURST, window=8) == pytest.approx(2000.3)
+
+    def test_trimmed_rejects_spikes(self):
+        """Moyenne tronquee a 20 % : identique au firmware, resolution sub-LSB conservee."""
+        value = filter_burst(ADC_FILTER_TRIMMED, SPIKY_BURST, window=8)
+        assert value == pytest.approx(2000.366577, abs=1e-4)
+
+    def test_single_block_is_plain_median(self):
+        """Une salve plus courte que le bloc donne la mediane exacte."""
+        assert filter_burst(ADC_FILTER_MEDIAN, [5, 1, 4000, 3, 2]) == 3
+        assert filter_burst(ADC_FILTER_MEDIAN, [5, 1, 3, 2]) == 2.5
+
+    def test_iir_state_kept_across_bursts(self):
+        """Le passe-bas IIR converge sur plusieurs salves."""
+        f = SampleFilter(ADC_FILTER_IIR, alpha=0.25)
+        f.begin()
+        f.add(1000)
+        assert f.result() == 1000
+        for _ in range(5):
+            f.begin()
+            for _ in range(10):
+                f.add(2000)
+        assert f.result() == pytest.approx(2000, abs=0.01)
+
+    def test_iir_matches_firmware(self):
+        """Valeur produite par SampleFilter<8> (alpha 0,25) sur la salve a pics."""
+        assert filter_burst(ADC_FILTER_IIR, SPIKY_BURST, alpha=0.25) == pytest.approx(1989.95459, abs=1e-3)
+
+    def test_fewer_samples_same_accuracy(self):
+        """Avec des pics, 9 echantillons filtres font mieux que 20 moyennes."""
+        import random
+        rnd = random.Random(3)
+        err_mean = err_trim = 0.0
+        for _ in range(200):
+            burst = [2000 + rnd.randint(-2, 2) if rnd.random() > 0.05 else rnd.choice([0, 4095])
+                     for _ in range(20)]
+            err_mean += abs(filter_burst(ADC_FILTER_MEAN, burst) - 2000)
+            err_trim += abs(filter_burst(ADC_FILTER_TRIMMED, burst[:9]) - 2000)
+        assert err_trim < err_mean / 5
+
+
+# =============================================================================
+# Tests agregation par fenetre (Welford)
+# =============================================================================
+
+class TestWindowAggregation:
+    """Tests des statistiques incrementales et du resume de fenetre."""
+
+    def test_matches_statistics_module(self):
+        """Moyenne et ecart-type d'echantillon identiques au calcul direct."""
+        import statistics
+        samples = [20.5, 20.7, 20.9, 21.1, 20.8, 20.6]
+        w = Welford()
+        for x in samples:
+            w.add(x)
+        assert w.mean == pytest.approx(statistics.mean(samples))
+        assert w.stddev() == pytest.approx(statistics.stdev(samples))
+        assert (w.min, w.max) == (20.5, 21.1)
+
+    def test_single_sample(self):
+        """Un seul echantillon : ecart-type nul, min = max = moyenne."""
+        w = Welford()
+        w.add(21.0)
+        assert (w.mean, w.min, w.max, w.stddev()) == (21.0, 21.0, 21.0, 0.0)
+
+    def test_stable_with_large_offset(self):
+        """Welford reste precis sur un signal a fort decalage (pas de somme des carres)."""
+        import random
+        rnd = random.Random(2)
+        w = Welford()
+        samples = [1000.0 + rnd.gauss(0, 0.1) for _ in range(3600)]
+        for x in samples:
+            w.add(x)
+        import statistics
+        assert w.stddev() == pytest.approx(statistics.stdev(samples), rel=1e-6)
+
+    def test_summary_extends_payload(self):
+        """Le resume garde les champs existants (moyenne) et ajoute window_s et stats."""
+        payload = build_payload("2026-02-08T15:30:00+01:00", "user@example.com",
+                                "meteoStation_1", 20.8, None, 21.1, 77.0)
+        payload["window_s"] = 60
+        payload["stats"] = {
+            "dht_temperature": {"n": 60, "min": 20.5, "max": 21.1, "stddev": 0.26},
+        }
+        decoded = json.loads(json.dumps(payload))
+        assert decoded["dht_temperature"] == 20.8
+        assert set(decoded["stats"]["dht_temperature"]) == {"n", "min", "max", "stddev"}
+        assert "dht_humidity" not in decoded["stats"]
+
+
+# =============================================================================
+# Tests publication par exception (bandes mortes)
+# =============================================================================
+
+class TestDeadband:
+    """Tests de la publication par exception avec releve complet periodique."""
+
+    BANDS = [50, 200, 20, 300]
+
+    def test_first_reading_full(self):
+        """Le premier releve est toujours publie en entier."""
+        assert deadband_apply({}, [2070, 5200, 2110, 7700], self.BANDS, 30) == (True, 0)
+
+    def test_unchanged_reading_dropped(self):
+        """Un releve dans toutes les bandes mortes n'est pas publie."""
+        st = {}
+        deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 30)
+        assert deadband_apply(st, [2080, 5250, 2110, 7700], self.BANDS, 30) == (False, 0xF)
+
+    def test_only_changed_channels(self):
+        """Seuls les canaux sortis de leur bande sont publies."""
+        st = {}
+        deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 30)
+        assert deadband_apply(st, [2130, 5250, 2120, 8050], self.BANDS, 30) == (True, 0x6)
+
+    def test_slow_drift_reported(self):
+        """La reference est la derniere valeur publiee : une derive lente est vue."""
+        st = {}
+        deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 1000)
+        published = [deadband_apply(st, [2070, 5200, 2110 + 5 * i, 7700], self.BANDS, 1000)[0]
+                     for i in range(1, 6)]
+        assert published == [False, False, False, True, False]
+
+    def test_validity_change_reported(self):
+        """Un capteur qui tombe en erreur (ou revient) est publie."""
+        st = {}
+        deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 30)
+        assert deadband_apply(st, [None, None, 2110, 7700], self.BANDS, 30) == (True, 0xC)
+        assert deadband_apply(st, [None, None, 2110, 7700], self.BANDS, 30) == (False, 0xF)
+
+    def test_heartbeat_forces_full(self):
+        """Un releve complet est force tous les heartbeat_every releves."""
+        st = {}
+        results = [deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 30)
+                   for _ in range(61)]
+        assert [i for i, (pub, _) in enumerate(results) if pub] == [0, 30, 60]
+
+    def test_heartbeat_on_elapsed_time(self):
+        """Cadence adaptative : un releve complet toutes les 300 s, a 2 s comme a 60 s."""
+        st = {}
+        steps = [0] + [2000] * 150 + [60000] * 5
+        results = [deadband_apply(st, [2070, 5200, 2110, 7700], self.BANDS, 300000, s)
+                   for s in steps]
+        assert [i for i, (pub, _) in enumerate(results) if pub] == [0, 150, 155]
+
+    def test_message_rate_reduction(self):
+        """Sur un signal interieur stable et bruite, le debit baisse de plus de 80 %."""
+        import random
+        rnd = random.Random(1)
+        st = {}
+        published = 0
+        for i in range(8640):  # 24 h a 10 s
+            temp = 2100 + int(30 * math.sin(i / 1500)) + rnd.randint(-5, 5)
+            values = [temp // 100 * 100, 5200, temp, 7700 + rnd.randint(-100, 100)]
+            published += deadband_apply(st, values, self.BANDS, 30)[0]
+        assert published < 0.2 * 8640
+
+
+# =============================================================================
+# Tests chronometrage des etapes (diag)
+# =============================================================================
+
+class TestStageHistogram:
+    """Tests de l'histogramme log2 des durees d'etapes."""
+
+    def test_bin_is_floor_log2(self):
+        """La classe i couvre [2^i, 2^(i+1)) us."""
+        for i in range(1, STAGE_HIST_BINS - 1):
+            assert stage_bin(1 << i) == i
+            assert stage_bin((1 << (i + 1)) - 1) == i
+
+    def test_small_durations(self):
+        """0 et 1 us tombent dans la premiere classe."""
+        assert stage_bin(0) == 0
+        assert stage_bin(1) == 0
+
+    def test_long_durations_clamped(self):
+        """Les durees au-dela de 2^19 us (handshake TLS) tombent dans la derniere classe."""
+        assert stage_bin(1 << 19) == STAGE_HIST_BINS - 1
+        assert stage_bin(30_000_000) == STAGE_HIST_BINS - 1
+        assert stage_bin(2**32 - 1) == STAGE_HIST_BINS - 1
+
+
+# =============================================================================
+# Tests attente exponentielle (reconnexions)
+# =============================================================================
+
+class TestBackoff:
+    """Tests de l'attente exponentielle avec gigue des reconnexions."""
+
+    def test_doubles_until_cap(self):
+        """La borne basse (d/2) double a chaque tentative jusqu'au plafond."""
+        b = Backoff(1000, 120000)
+        lower = [b.next(0) for _ in range(10)]
+        assert lower[:4] == [500, 1000, 2000, 4000]
+        assert lower[-1] == 60000
+
+    def test_jitter_range(self):
+        """Le delai est toujours dans [d/2, d]."""
+        for rnd in range(0, 5000, 37):
+            b = Backoff(1000, 120000)
+            b.attempts = 3
+            assert 4000 <= b.next(rnd) <= 8000
+
+    def test_reset(self):
+        """Apres une connexion reussie, on repart du delai de base."""
+        b = Backoff(1000, 120000)
+        for _ in range(6):
+            b.next(0)
+        b.reset()
+        assert b.next(0) == 500
+        assert b.attempts == 1
+
+    def test_no_overflow(self):
+        """Un grand nombre d'echecs reste plafonne."""
+        b = Backoff(1000, 300000)
+        for _ in range(100):
+            assert b.next(12345) <= 300000